@@ -139,6 +139,18 @@ typedef struct libvlc_media_stats_t
     float       f_send_bitrate;
 } libvlc_media_stats_t;
 
+/**
+ * Video output pipeline stages timed by libvlc_media_get_video_latency()
+ */
+typedef enum libvlc_video_latency_stage_t
+{
+    libvlc_video_latency_queue,    /**< Queued for display */
+    libvlc_video_latency_filter,   /**< Video filters */
+    libvlc_video_latency_prepare,  /**< Subpictures and preparation */
+    libvlc_video_latency_display,  /**< Display of the picture */
+    libvlc_video_latency_lateness, /**< Display date after the picture date */
+} libvlc_video_latency_stage_t;
+
 typedef struct libvlc_media_track_info_t
 {
     /* Codec fourcc */
@@ -649,6 +661,27 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Get the latency histogram of a stage of the video output pipeline
+ *
+ * The first bucket counts the durations below 128 microseconds, each next
+ * bucket the durations below twice the limit of the previous one, and the
+ * last bucket all the longer durations.
+ *
+ * \param p_md media descriptor object
+ * \param stage pipeline stage
+ * \param p_buckets array receiving the count of frames per bucket
+ *                  (allocated by the caller)
+ * \param i_buckets size of the array
+ * \return the number of buckets written (at most 16),
+ *         or -1 if the statistics are not available
+ * \version LibVLC 4.0.0 and later.
+ */
+LIBVLC_API int libvlc_media_get_video_latency( libvlc_media_t *p_md,
+                                               libvlc_video_latency_stage_t stage,
+                                               uint64_t *p_buckets,
+                                               unsigned i_buckets );
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
@@ -144,6 +144,25 @@ VLC_API block_t *block_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
 VLC_API block_t *block_TryRealloc(block_t *, ssize_t pre, size_t body) VLC_USED;
 
+/**
+ * Block cache statistics.
+ *
+ * Small blocks allocated with block_Alloc() are recycled through per-thread
+ * caches. These counters are cumulated over all threads.
+ */
+typedef struct block_cache_stats_t
+{
+    unsigned long hits; /**< allocations served from a cache */
+    unsigned long misses; /**< allocations served from the heap */
+    unsigned long remote_frees; /**< releases from a non-allocating thread */
+    unsigned caches; /**< number of thread caches */
+} block_cache_stats_t;
+
+/**
+ * Gets the block cache statistics.
+ */
+VLC_API void block_CacheGetStats(block_cache_stats_t *);
+
 /**
  * Reallocates a block.
  *
@@ -430,6 +449,22 @@ static inline block_t *block_ChainGather( block_t *p_list )
  */
 VLC_API block_fifo_t *block_FifoNew(void) VLC_USED VLC_MALLOC;
 
+/**
+ * Creates a lock-less FIFO queue of blocks.
+ *
+ * This is a variant of block_FifoNew() for high packet rates. Queuing and
+ * dequeuing do not take any lock; the consumer only sleeps when the queue is
+ * empty. Any number of threads can queue blocks with block_FifoPut(), but only
+ * one thread at a time may call block_FifoGet(), block_FifoShow() or
+ * block_FifoEmpty().
+ *
+ * @warning The vlc_fifo_Lock() family of functions cannot be used with
+ * such a queue.
+ *
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API block_fifo_t *block_FifoNewLockless(void) VLC_USED VLC_MALLOC;
+
 /**
  * Destroys a FIFO created by block_FifoNew().
  *
@@ -467,9 +502,10 @@ VLC_API block_t *block_FifoGet(block_fifo_t *) VLC_USED;
  * You need to protect against concurrent threads who could dequeue the block.
  * Preferably, there should be only one thread reading from the FIFO.
  *
- * @warning This function is undefined if the FIFO is empty.
+ * @warning This function is undefined if the FIFO is empty, unless it was
+ * created by block_FifoNewLockless().
  *
- * @return a valid block.
+ * @return a valid block, or NULL if a lock-less FIFO is empty.
  */
 VLC_API block_t *block_FifoShow(block_fifo_t *);
 
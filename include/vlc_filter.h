@@ -26,6 +26,7 @@
 #define VLC_FILTER_H 1
 
 #include <vlc_es.h>
+#include <vlc_block.h>
 
 /**
  * \defgroup filter Filters
@@ -52,6 +53,10 @@ typedef struct filter_owner_t
         {
             subpicture_t * (*buffer_new)( filter_t * );
         } sub;
+        struct
+        {
+            block_t * (*buffer_new)( filter_t *, size_t );
+        } audio;
     };
 } filter_owner_t;
 
@@ -77,6 +82,11 @@ struct filter_t
     es_format_t         fmt_out;
     bool                b_allow_fmt_out_change;
 
+    /** The audio filter always returns its input block, processed in place.
+     * Set by the module when it opens; the owner then needs no output
+     * buffer for this filter. */
+    bool                b_in_place;
+
     /* Name of the "video filter" shortcut that is requested, can be NULL */
     const char *        psz_name;
     /* Filter configuration */
@@ -105,6 +115,20 @@ struct filter_t
                           subpicture_region_t *, const vlc_fourcc_t * );
     };
 
+    /** Filter a slice of a picture (video filter, optional)
+     *
+     * Filters whose output rows only depend on the input picture can
+     * provide this callback in addition to pf_video_filter. Filter chains
+     * then allocate the output picture themselves, and process the
+     * picture in slices on several threads concurrently.
+     *
+     * Rows [y0, y1) are counted in lines of the first plane; they are
+     * scaled to the lines of other planes by the ratio of the plane
+     * visible lines. The boundaries are multiple of 16 lines except at
+     * the bottom of the picture. */
+    void (*pf_video_slice)( filter_t *, picture_t *dst, const picture_t *src,
+                            unsigned y0, unsigned y1 );
+
     union
     {
         /* TODO: video filter drain */
@@ -186,6 +210,25 @@ static inline void filter_ChangeViewpoint( filter_t *p_filter,
         p_filter->pf_change_viewpoint( p_filter, vp );
 }
 
+/**
+ * This function will return a new block usable by p_filter as an output
+ * buffer, of i_size bytes. You have to release it using block_Release or by
+ * returning it to the caller as a pf_audio_filter return value.
+ * The owner of the filter may recycle the blocks, so that a chain of
+ * filters runs without allocations.
+ *
+ * \param p_filter filter_t object
+ * \param i_size payload size in bytes
+ * \return new block on success, NULL on error
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter,
+                                              size_t i_size )
+{
+    if( p_filter->owner.audio.buffer_new != NULL )
+        return p_filter->owner.audio.buffer_new( p_filter, i_size );
+    return block_Alloc( i_size );
+}
+
 /**
  * This function will drain, then flush an audio filter.
  */
@@ -387,12 +387,50 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/**
+ * Video pipeline stages timed by input_stats_t::i_vout_latency
+ */
+enum input_stats_vout_stage
+{
+    INPUT_STATS_VOUT_QUEUE,    /**< Queued from the decoder to the display */
+    INPUT_STATS_VOUT_FILTER,   /**< Video filter chains */
+    INPUT_STATS_VOUT_PREPARE,  /**< Subpictures, blending and preparation */
+    INPUT_STATS_VOUT_DISPLAY,  /**< Display of the prepared picture */
+    INPUT_STATS_VOUT_LATENESS, /**< Display date after the picture date */
+    INPUT_STATS_VOUT_STAGES
+};
+
+/**
+ * Number of buckets of the latency histograms. The first bucket counts
+ * durations below 128 microseconds, each next bucket durations below twice
+ * the limit of the previous one, and the last bucket all longer durations.
+ */
+#define INPUT_STATS_LATENCY_BUCKETS 16
+
+/**
+ * Returns the latency histogram bucket of a duration.
+ */
+static inline unsigned input_stats_LatencyBucket( mtime_t i_duration )
+{
+    unsigned i_bucket = 0;
+
+    for( mtime_t i_limit = 128; i_duration >= i_limit
+      && i_bucket < INPUT_STATS_LATENCY_BUCKETS - 1; i_limit *= 2 )
+        i_bucket++;
+    return i_bucket;
+}
+
 struct input_stats_t
 {
     /* Input */
     int64_t i_read_packets;
     int64_t i_read_bytes;
     float f_input_bitrate;
+    int64_t i_stream_cache_hits;   /**< Reads served from a stream cache */
+    int64_t i_stream_cache_misses; /**< Reads waiting for the source */
+    int64_t i_recv_calls;          /**< Datagram receive system calls */
+    int64_t i_recv_datagrams;      /**< Datagrams received by those calls */
 
     /* Demux */
     int64_t i_demux_read_packets;
@@ -408,10 +446,17 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    int64_t i_copied_pictures; /**< Full-frame copies by the video outputs */
+    float f_copy_rate;         /**< Full-frame copies per second */
+    int64_t i_spu_cache_hits;   /**< Subpicture regions reused as rendered */
+    int64_t i_spu_cache_misses; /**< Subpicture regions rendered/scaled */
+    /** Latency histograms, see input_stats_LatencyBucket() */
+    int64_t i_vout_latency[INPUT_STATS_VOUT_STAGES][INPUT_STATS_LATENCY_BUCKETS];
 
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    int64_t i_allocated_abuffers; /**< Output blocks allocated by filters */
 };
 
 /**
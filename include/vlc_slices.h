@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * vlc_slices.h: slice thread pool
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SLICES_H
+#define VLC_SLICES_H 1
+
+/**
+ * \defgroup slices Slice threads
+ * \ingroup thread
+ * Pool of threads splitting a job, such as a picture, into independent
+ * slices.
+ * @{
+ * \file
+ * Slice thread pool functions
+ */
+
+/**
+ * Slice thread pool handle
+ */
+typedef struct vlc_slices vlc_slices_t;
+
+/**
+ * Slice processing callback.
+ *
+ * \param opaque data pointer given to vlc_slices_Run()
+ * \param index slice index, from 0 to the slice count excluded
+ * \param worker index of the thread processing the slice,
+ *               0 for the calling thread, from 1 to vlc_slices_GetThreads()
+ *               excluded for the pool threads
+ */
+typedef void (*vlc_slice_cb)(void *opaque, unsigned index, unsigned worker);
+
+/**
+ * Creates a pool of slice threads.
+ *
+ * \param threads total number of threads, including the calling thread
+ * \param priority thread priority (e.g. VLC_THREAD_PRIORITY_VIDEO)
+ * \return the pool, or NULL if there is a single thread or on error
+ */
+VLC_API vlc_slices_t *vlc_slices_New(unsigned threads, int priority) VLC_USED;
+
+/**
+ * Destroys a pool of slice threads, waiting for its threads to exit.
+ *
+ * There must be no pending vlc_slices_Run() call.
+ */
+VLC_API void vlc_slices_Delete(vlc_slices_t *);
+
+/**
+ * Gets the number of threads processing the slices, including the calling
+ * thread.
+ */
+VLC_API unsigned vlc_slices_GetThreads(const vlc_slices_t *) VLC_USED;
+
+/**
+ * Processes slices.
+ *
+ * Calls cb() once for each slice, on the pool threads and the calling thread,
+ * and waits for all the slices to be processed. A pool runs one job at a
+ * time: this function must not be called concurrently on the same pool.
+ *
+ * \param count number of slices
+ * \param cb slice processing callback
+ * \param opaque data pointer for the callback
+ */
+VLC_API void vlc_slices_Run(vlc_slices_t *, unsigned count, vlc_slice_cb cb,
+                            void *opaque);
+
+/** @} */
+
+#endif
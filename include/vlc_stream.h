@@ -335,6 +335,30 @@ VLC_API void vlc_stream_Delete(stream_t *s);
 
 VLC_API stream_t *vlc_stream_CommonNew(vlc_object_t *, void (*)(stream_t *));
 
+/**
+ * Stream statistics counters, see vlc_stream_AddStats()
+ */
+enum vlc_stream_stat
+{
+    VLC_STREAM_STAT_CACHE_HITS, /**< Reads served from a stream cache */
+    VLC_STREAM_STAT_CACHE_MISSES, /**< Reads waiting for the source */
+    VLC_STREAM_STAT_RECV_CALLS, /**< Receive system calls */
+    VLC_STREAM_STAT_RECV_DATAGRAMS, /**< Datagrams received by those calls */
+};
+
+/**
+ * Adds to a statistics counter of the input of a stream.
+ *
+ * Access and stream filter modules report their own counters with this.
+ * This function does nothing if the stream does not belong to an input,
+ * and can be called from any thread.
+ *
+ * \param stat counter to increase
+ * \param value amount to add to the counter
+ */
+VLC_API void vlc_stream_AddStats(stream_t *s, enum vlc_stream_stat stat,
+                                 uintmax_t value);
+
 /**
  * Get the size of the stream.
  */
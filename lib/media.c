@@ -133,6 +133,14 @@ static_assert(
     MULTIVIEW_STEREO_CHECKERBOARD   == (int) libvlc_video_multiview_stereo_checkerboard,
     "Mismatch between libvlc_video_multiview_t and video_multiview_mode_t");
 
+static_assert(
+    INPUT_STATS_VOUT_QUEUE    == (int) libvlc_video_latency_queue &&
+    INPUT_STATS_VOUT_FILTER   == (int) libvlc_video_latency_filter &&
+    INPUT_STATS_VOUT_PREPARE  == (int) libvlc_video_latency_prepare &&
+    INPUT_STATS_VOUT_DISPLAY  == (int) libvlc_video_latency_display &&
+    INPUT_STATS_VOUT_LATENESS == (int) libvlc_video_latency_lateness,
+    "Mismatch between libvlc_video_latency_stage_t and input_stats_vout_stage");
+
 static libvlc_media_list_t *media_get_subitems( libvlc_media_t * p_md,
                                                 bool b_create )
 {
@@ -747,6 +755,33 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     return true;
 }
 
+int libvlc_media_get_video_latency( libvlc_media_t *p_md,
+                                    libvlc_video_latency_stage_t stage,
+                                    uint64_t *p_buckets, unsigned i_buckets )
+{
+    input_item_t *item = p_md->p_input_item;
+
+    if( item == NULL || (unsigned) stage >= INPUT_STATS_VOUT_STAGES )
+        return -1;
+
+    vlc_mutex_lock( &item->lock );
+
+    input_stats_t *p_itm_stats = item->p_stats;
+    if( p_itm_stats == NULL )
+    {
+        vlc_mutex_unlock( &item->lock );
+        return -1;
+    }
+
+    if( i_buckets > INPUT_STATS_LATENCY_BUCKETS )
+        i_buckets = INPUT_STATS_LATENCY_BUCKETS;
+    for( unsigned i = 0; i < i_buckets; i++ )
+        p_buckets[i] = p_itm_stats->i_vout_latency[stage][i];
+
+    vlc_mutex_unlock( &item->lock );
+    return i_buckets;
+}
+
 /**************************************************************************
  * event_manager
  **************************************************************************/
@@ -51,6 +51,9 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <dirent.h>
 
 #include <vlc_common.h>
@@ -69,6 +72,9 @@ struct access_sys_t
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_MMAP
+    uint64_t offset; /* read offset in memory-mapped mode */
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -126,8 +132,18 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
+
+/* Size of the file windows mapped at once */
+#define MMAP_WINDOW (4 << 20)
 
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *BlockMmap (stream_t *, bool *);
+static int MmapSeek (stream_t *, uint64_t);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
@@ -231,6 +247,17 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        /* Hand out blocks referencing the page cache, rather than copies */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote(fd, p_access->psz_filepath))
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = BlockMmap;
+            p_access->pf_seek = MmapSeek;
+            p_sys->offset = 0;
+        }
 #endif
     }
     else
@@ -253,7 +280,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -287,6 +314,62 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *BlockMmap (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    /* The file may be growing */
+    if (fstat (p_sys->fd, &st))
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    if (p_sys->offset >= (uint64_t)st.st_size)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    const size_t page_mask = sysconf (_SC_PAGESIZE) - 1;
+    size_t left = p_sys->offset & page_mask;
+    size_t length = MMAP_WINDOW - left;
+
+    if ((uint64_t)length > st.st_size - p_sys->offset)
+        length = st.st_size - p_sys->offset;
+
+    void *addr = mmap (NULL, left + length, PROT_READ, MAP_PRIVATE,
+                       p_sys->fd, p_sys->offset - left);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    posix_madvise (addr, left + length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, left + length, POSIX_MADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc ((char *)addr + left, length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    p_sys->offset += length;
+    return block;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *sys = p_access->p_sys;
+
+    sys->offset = i_pos;
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -30,12 +30,21 @@
 #include "fs.h"
 #include <vlc_plugin.h>
 
+#define MMAP_TEXT N_("Memory-map files")
+#define MMAP_LONGTEXT N_( \
+    "Read local files through memory mappings rather than copying their " \
+    "data. This is faster when files are in the page cache, but VLC " \
+    "may crash if a file is truncated while being read.")
+
 vlc_module_begin ()
     set_description( N_("File input") )
     set_shortname( N_("File") )
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_obsolete_string( "file-cat" )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true )
+#endif
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
@@ -85,6 +85,97 @@ drop:
     block_Release (block);
 }
 
+#ifdef HAVE_RECVMMSG
+/**
+ * Receives a batch of datagrams from the RTP socket in one system call.
+ * @param mru current maximum receive unit (updated on truncation)
+ * @return false if no receive buffer could be allocated at all.
+ */
+static bool rtp_recv_batch (demux_t *demux, size_t *mru)
+{
+    demux_sys_t *sys = demux->p_sys;
+    unsigned count = 0;
+
+    while (count < sys->rx_batch)
+    {
+        block_t *block = sys->rx_blocks[count];
+
+        if (block == NULL)
+        {
+            block = block_Alloc (*mru);
+            if (unlikely(block == NULL))
+                break;
+            sys->rx_blocks[count] = block;
+        }
+
+        sys->rx_iov[count].iov_base = block->p_buffer;
+        sys->rx_iov[count].iov_len = *mru;
+        sys->rx_msgs[count].msg_hdr.msg_flags = 0;
+        count++;
+    }
+
+    if (unlikely(count == 0))
+    {
+        if (*mru == DEFAULT_MRU)
+            return false; /* we are totallly screwed */
+        *mru = DEFAULT_MRU; /* retry with shrunk MRU */
+        return true;
+    }
+
+    int n = recvmmsg (sys->fd, sys->rx_msgs, count, MSG_DONTWAIT, NULL);
+    if (n <= 0)
+    {
+        if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+            msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return true;
+    }
+
+    vlc_stream_AddStats (demux, VLC_STREAM_STAT_RECV_CALLS, 1);
+    vlc_stream_AddStats (demux, VLC_STREAM_STAT_RECV_DATAGRAMS, n);
+
+    size_t new_mru = *mru;
+
+    for (int i = 0; i < n; i++)
+    {
+        block_t *block = sys->rx_blocks[i];
+        size_t len = sys->rx_msgs[i].msg_len;
+
+        sys->rx_blocks[i] = NULL;
+        if (sys->rx_msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, *mru);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > new_mru)
+                new_mru = len;
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+
+    /* Keep unused buffers at the front for the next batch */
+    for (unsigned i = n, j = 0; i < count; i++, j++)
+    {
+        sys->rx_blocks[j] = sys->rx_blocks[i];
+        sys->rx_blocks[i] = NULL;
+    }
+
+    if (new_mru != *mru)
+    {   /* Drop buffers that are now too small */
+        for (unsigned i = 0; i < sys->rx_batch; i++)
+            if (sys->rx_blocks[i] != NULL)
+            {
+                block_Release (sys->rx_blocks[i]);
+                sys->rx_blocks[i] = NULL;
+            }
+        *mru = new_mru;
+    }
+    return true;
+}
+#endif
+
 static int rtp_timeout (mtime_t deadline)
 {
     if (deadline == VLC_TS_INVALID)
@@ -139,6 +230,15 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef HAVE_RECVMMSG
+            if (sys->rx_batch > 1)
+            {
+                if (!rtp_recv_batch (demux, &iov.iov_len))
+                    break;
+                goto dequeue;
+            }
+#endif
+
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -75,6 +75,11 @@
     "RTP packets will be discarded if they are too far behind (i.e. in the " \
     "past) by this many packets from the last received packet." )
 
+#define RTP_BATCH_TEXT N_("Receive batch size")
+#define RTP_BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams received with a single system call " \
+    "(1 disables batching)." )
+
 #define RTP_DYNAMIC_PT_TEXT N_("RTP payload format assumed for dynamic " \
                                "payloads")
 #define RTP_DYNAMIC_PT_LONGTEXT N_( \
@@ -122,6 +127,11 @@ vlc_module_begin ()
     add_integer ("rtp-max-misorder", 100, RTP_MAX_MISORDER_TEXT,
                  RTP_MAX_MISORDER_LONGTEXT, true)
         change_integer_range (0, 32767)
+#ifdef HAVE_RECVMMSG
+    add_integer ("rtp-batch", 16, RTP_BATCH_TEXT,
+                 RTP_BATCH_LONGTEXT, true)
+        change_integer_range (1, 256)
+#endif
     add_string ("rtp-dynamic-pt", NULL, RTP_DYNAMIC_PT_TEXT,
                 RTP_DYNAMIC_PT_LONGTEXT, true)
         change_string_list (dynamic_pt_list, dynamic_pt_list_text)
@@ -269,6 +279,31 @@ static int Open (vlc_object_t *obj)
     p_sys->max_misorder = var_CreateGetInteger (obj, "rtp-max-misorder");
     p_sys->thread_ready = false;
     p_sys->autodetect   = true;
+#ifdef HAVE_RECVMMSG
+    p_sys->rx_batch     = var_InheritInteger (obj, "rtp-batch");
+    p_sys->rx_msgs      = NULL;
+    p_sys->rx_iov       = NULL;
+    p_sys->rx_blocks    = NULL;
+
+    if (tp == IPPROTO_TCP)
+        p_sys->rx_batch = 1;
+    if (p_sys->rx_batch > 1)
+    {
+        p_sys->rx_msgs = calloc (p_sys->rx_batch, sizeof (*p_sys->rx_msgs));
+        p_sys->rx_iov = calloc (p_sys->rx_batch, sizeof (*p_sys->rx_iov));
+        p_sys->rx_blocks = calloc (p_sys->rx_batch,
+                                   sizeof (*p_sys->rx_blocks));
+        if (unlikely(p_sys->rx_msgs == NULL || p_sys->rx_iov == NULL
+                  || p_sys->rx_blocks == NULL))
+            p_sys->rx_batch = 1;
+        else
+            for (unsigned i = 0; i < p_sys->rx_batch; i++)
+            {
+                p_sys->rx_msgs[i].msg_hdr.msg_iov = &p_sys->rx_iov[i];
+                p_sys->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+    }
+#endif
 
     demux->pf_demux   = NULL;
     demux->pf_control = Control;
@@ -331,6 +366,15 @@ static void Close (vlc_object_t *obj)
         vlc_join (p_sys->thread, NULL);
     }
 
+#ifdef HAVE_RECVMMSG
+    if (p_sys->rx_blocks != NULL)
+        for (unsigned i = 0; i < p_sys->rx_batch; i++)
+            if (p_sys->rx_blocks[i] != NULL)
+                block_Release (p_sys->rx_blocks[i]);
+    free (p_sys->rx_blocks);
+    free (p_sys->rx_iov);
+    free (p_sys->rx_msgs);
+#endif
 #ifdef HAVE_SRTP
     if (p_sys->srtp)
         srtp_destroy (p_sys->srtp);
@@ -79,5 +79,13 @@ struct demux_sys_t
     uint8_t       max_src; /**< Max simultaneous RTP sources */
     bool          thread_ready;
     bool          autodetect; /**< Payload type autodetection pending */
+
+#ifdef HAVE_RECVMMSG
+    /* Batched datagram receive */
+    unsigned         rx_batch; /**< Max datagrams per system call */
+    struct mmsghdr  *rx_msgs;
+    struct iovec    *rx_iov;
+    block_t        **rx_blocks; /**< Preallocated receive buffers */
+#endif
 };
 
@@ -49,6 +49,9 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <netinet/udp.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -59,6 +62,14 @@ static void Close( vlc_object_t * );
 #define BUFFER_TEXT N_("Receive buffer")
 #define BUFFER_LONGTEXT N_("UDP receive buffer size (bytes)" )
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Receive batch size")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams received with a single system call " \
+    "(1 disables batching)." )
+#define GRO_TEXT N_("Generic receive offload")
+#define GRO_LONGTEXT N_( \
+    "Let the kernel coalesce consecutive datagrams from the same source " \
+    "into a single buffer, where supported." )
 
 vlc_module_begin ()
     set_shortname( N_("UDP" ) )
@@ -69,6 +80,11 @@ vlc_module_begin ()
     add_obsolete_integer( "server-port" ) /* since 2.0.0 */
     add_obsolete_integer( "udp-buffer" ) /* since 3.0.0 */
     add_integer( "udp-timeout", -1, TIMEOUT_TEXT, NULL, true )
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range( "udp-batch", 16, 1, 256,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_bool( "udp-gro", true, GRO_TEXT, GRO_LONGTEXT, true )
+#endif
 
     set_capability( "access", 0 )
     add_shortcut( "udp", "udpstream", "udp4", "udp6" )
@@ -81,12 +97,23 @@ struct access_sys_t
     int fd;
     int timeout;
     size_t mtu;
+#ifdef HAVE_RECVMMSG
+    /* Batched receive */
+    unsigned batch;
+    block_t *queue; /**< received datagrams not returned yet */
+    block_t **pool; /**< preallocated receive buffers */
+    struct mmsghdr *msgs;
+    struct iovec *iovecs;
+#endif
 };
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static block_t *BlockUDP( stream_t *, bool * );
+#ifdef HAVE_RECVMMSG
+static block_t *BlockUDPBatch( stream_t *, bool * );
+#endif
 static int Control( stream_t *, int, va_list );
 
 /*****************************************************************************
@@ -174,6 +201,45 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = var_InheritInteger( p_access, "udp-batch" );
+    sys->queue = NULL;
+    sys->pool = NULL;
+
+    if( sys->batch > 1 )
+    {
+        sys->pool = vlc_obj_calloc( p_this, sys->batch, sizeof (*sys->pool) );
+        sys->msgs = vlc_obj_calloc( p_this, sys->batch, sizeof (*sys->msgs) );
+        sys->iovecs = vlc_obj_calloc( p_this, sys->batch,
+                                      sizeof (*sys->iovecs) );
+        if( unlikely(sys->pool == NULL || sys->msgs == NULL
+                  || sys->iovecs == NULL) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+
+        for( unsigned i = 0; i < sys->batch; i++ )
+        {
+            sys->msgs[i].msg_hdr.msg_iov = &sys->iovecs[i];
+            sys->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+# ifdef UDP_GRO
+        /* With GRO, one buffer may carry several coalesced datagrams. This is
+         * fine as the stream layer does not preserve datagram boundaries. */
+        if( var_InheritBool( p_access, "udp-gro" )
+         && setsockopt( sys->fd, IPPROTO_UDP, UDP_GRO, &(int){ 1 },
+                        sizeof (int) ) == 0 )
+        {
+            msg_Dbg( p_access, "using UDP generic receive offload" );
+            sys->mtu = 65535;
+        }
+# endif
+        p_access->pf_block = BlockUDPBatch;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -185,6 +251,15 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->pool != NULL )
+    {
+        block_ChainRelease( sys->queue );
+        for( unsigned i = 0; i < sys->batch; i++ )
+            if( sys->pool[i] != NULL )
+                block_Release( sys->pool[i] );
+    }
+#endif
     net_Close( sys->fd );
 }
 
@@ -282,3 +357,116 @@ skip:
 
     return pkt;
 }
+
+#ifdef HAVE_RECVMMSG
+/*****************************************************************************
+ * BlockUDPBatch: receives up to sys->batch datagrams per system call
+ *****************************************************************************/
+static block_t *BlockUDPBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    block_t *pkt = sys->queue;
+
+    if (pkt != NULL)
+    {   /* Return a datagram from the previous batch */
+        sys->queue = pkt->p_next;
+        pkt->p_next = NULL;
+        return pkt;
+    }
+
+    /* Refill the receive buffers consumed by the previous batch */
+    unsigned count = 0;
+
+    while (count < sys->batch)
+    {
+        if (sys->pool[count] == NULL)
+        {
+            sys->pool[count] = block_Alloc(sys->mtu);
+            if (unlikely(sys->pool[count] == NULL))
+                break;
+        }
+
+        sys->iovecs[count].iov_base = sys->pool[count]->p_buffer;
+        sys->iovecs[count].iov_len = sys->mtu;
+        sys->msgs[count].msg_hdr.msg_flags = 0;
+        count++;
+    }
+
+    if (unlikely(count == 0))
+    {   /* OOM - dequeue and discard one packet */
+        char dummy;
+        recv(sys->fd, &dummy, 1, 0);
+        return NULL;
+    }
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout))
+    {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+    }
+
+    int n = recvmmsg(sys->fd, sys->msgs, count, MSG_DONTWAIT, NULL);
+    if (n <= 0)
+        return NULL;
+
+    vlc_stream_AddStats(access, VLC_STREAM_STAT_RECV_CALLS, 1);
+    vlc_stream_AddStats(access, VLC_STREAM_STAT_RECV_DATAGRAMS, n);
+
+    block_t **pp = &sys->queue;
+    size_t mtu = sys->mtu;
+
+    for (int i = 0; i < n; i++)
+    {
+        size_t len = sys->msgs[i].msg_len;
+
+        pkt = sys->pool[i];
+        sys->pool[i] = NULL;
+
+        if (sys->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(access, "%zu bytes packet truncated (MTU was %zu)",
+                    len, sys->mtu);
+            pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > mtu)
+                mtu = len;
+        }
+        else
+            pkt->i_buffer = len;
+
+        *pp = pkt;
+        pp = &pkt->p_next;
+    }
+
+    /* Keep unused buffers at the front of the pool for the next batch */
+    for (unsigned i = n, j = 0; i < count; i++, j++)
+    {
+        sys->pool[j] = sys->pool[i];
+        sys->pool[i] = NULL;
+    }
+
+    if (mtu != sys->mtu)
+    {   /* Drop buffers that are now too small */
+        for (unsigned i = 0; i < sys->batch; i++)
+            if (sys->pool[i] != NULL)
+            {
+                block_Release(sys->pool[i]);
+                sys->pool[i] = NULL;
+            }
+        sys->mtu = mtu;
+    }
+
+    pkt = sys->queue;
+    sys->queue = pkt->p_next;
+    pkt->p_next = NULL;
+    return pkt;
+}
+#endif
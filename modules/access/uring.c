@@ -0,0 +1,420 @@
+/*****************************************************************************
+ * uring.c: asynchronous file input using io_uring
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef HAVE_LINUX_MAGIC_H
+#   include <sys/vfs.h>
+#   include <linux/magic.h>
+#endif
+
+#include <liburing.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_fs.h>
+
+/*
+ * The file is read by chunks of fixed size, aligned on their size.
+ * Up to "depth" chunks following the read position are requested at once,
+ * so that data is already in memory (or on its way) when the demuxer needs
+ * it. Seeks within that window reuse the requests already submitted.
+ *
+ * This module is only used on request, with uring:// MRLs, so that it does
+ * not take local files over from the file system module: on a local disk,
+ * opening a file is not faster than with read(), and demuxers that seek
+ * back and forth between interleaved tracks discard the window each time,
+ * reading several times more data than they use.
+ */
+#define CHUNK_SIZE (256 << 10)
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+#define DEPTH_TEXT N_("Read-ahead requests")
+#define DEPTH_LONGTEXT N_( \
+    "Number of read requests kept in flight ahead of the read position " \
+    "(each request reads 256 kiB).")
+
+vlc_module_begin ()
+    set_shortname (N_("io_uring"))
+    set_description (N_("Asynchronous file input (io_uring)"))
+    set_category (CAT_INPUT)
+    set_subcategory (SUBCAT_INPUT_ACCESS)
+    add_integer_with_range ("uring-depth", 8, 1, 64,
+                            DEPTH_TEXT, DEPTH_LONGTEXT, true)
+    set_capability ("access", 0)
+    add_shortcut ("uring")
+    set_callbacks (Open, Close)
+vlc_module_end ()
+
+typedef struct
+{
+    uint64_t offset;  /* file offset of the chunk */
+    ssize_t  length;  /* bytes read, or negative error code */
+    uint8_t *buffer;
+    struct iovec iov;
+    bool     pending; /* request in flight, buffer in use by the kernel */
+    bool     valid;   /* offset is current (request pending or completed) */
+} uring_chunk_t;
+
+struct access_sys_t
+{
+    int fd;
+    bool remote; /* on a network file system */
+    struct io_uring ring;
+
+    uint64_t pos;
+    uint64_t size;
+
+    unsigned depth;
+    uring_chunk_t *chunks;
+
+    /* statistics */
+    unsigned long requests;
+    unsigned long hits;
+    unsigned long waits;
+};
+
+static uint64_t ChunkAlign (uint64_t offset)
+{
+    return offset - (offset % CHUNK_SIZE);
+}
+
+static uring_chunk_t *ChunkFind (access_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->depth; i++)
+        if (sys->chunks[i].valid && sys->chunks[i].offset == offset)
+            return &sys->chunks[i];
+    return NULL;
+}
+
+/**
+ * Requests the chunks following the read position, which are not requested
+ * yet, in as many free chunk buffers as available.
+ */
+static void Submit (stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    uint64_t offset = ChunkAlign (sys->pos);
+    const uint64_t end = offset + (uint64_t)sys->depth * CHUNK_SIZE;
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < sys->depth; i++)
+    {
+        uring_chunk_t *chunk = &sys->chunks[i];
+
+        if (chunk->valid || chunk->pending)
+            continue;
+
+        while (offset < end && offset < sys->size
+            && ChunkFind (sys, offset) != NULL)
+            offset += CHUNK_SIZE;
+        if (offset >= end || offset >= sys->size)
+            break;
+
+        struct io_uring_sqe *sqe = io_uring_get_sqe (&sys->ring);
+        if (sqe == NULL)
+            break;
+
+        chunk->iov.iov_base = chunk->buffer;
+        chunk->iov.iov_len = CHUNK_SIZE;
+        io_uring_prep_readv (sqe, sys->fd, &chunk->iov, 1, offset);
+        io_uring_sqe_set_data (sqe, chunk);
+        chunk->offset = offset;
+        chunk->pending = true;
+        chunk->valid = true;
+        offset += CHUNK_SIZE;
+        count++;
+    }
+
+    if (count > 0)
+    {
+        io_uring_submit (&sys->ring);
+        sys->requests += count;
+    }
+}
+
+/**
+ * Collects one completed request, waiting for it if needed.
+ */
+static int Reap (stream_t *access, bool wait)
+{
+    access_sys_t *sys = access->p_sys;
+    struct io_uring_cqe *cqe;
+    int val;
+
+    if (wait)
+        val = io_uring_wait_cqe (&sys->ring, &cqe);
+    else
+        val = io_uring_peek_cqe (&sys->ring, &cqe);
+    if (val < 0)
+        return val;
+
+    uring_chunk_t *chunk = io_uring_cqe_get_data (cqe);
+
+    chunk->pending = false;
+    chunk->length = cqe->res;
+    io_uring_cqe_seen (&sys->ring, cqe);
+    return 0;
+}
+
+static ssize_t Read (stream_t *access, void *buf, size_t len)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->pos >= sys->size)
+    {
+        /* The file may be growing */
+        struct stat st;
+
+        if (fstat (sys->fd, &st) || (uint64_t)st.st_size <= sys->pos)
+            return 0;
+        sys->size = st.st_size;
+    }
+
+    /* Collect whatever completed meanwhile, without blocking */
+    while (Reap (access, false) == 0);
+    Submit (access);
+
+    uring_chunk_t *chunk = ChunkFind (sys, ChunkAlign (sys->pos));
+
+    if (chunk != NULL && !chunk->pending)
+        sys->hits++;
+    else
+        sys->waits++;
+
+    for (;;)
+    {
+        while (chunk == NULL || chunk->pending)
+        {
+            int val = Reap (access, true);
+            if (val < 0 && val != -EINTR)
+            {
+                msg_Err (access, "read error: %s", vlc_strerror_c(-val));
+                return 0;
+            }
+            Submit (access);
+            chunk = ChunkFind (sys, ChunkAlign (sys->pos));
+        }
+
+        if (chunk->length < 0)
+        {
+            msg_Err (access, "read error: %s",
+                     vlc_strerror_c(-chunk->length));
+            chunk->valid = false;
+            return 0;
+        }
+
+        if ((size_t)chunk->length > sys->pos - chunk->offset)
+            break;
+
+        /* Short read: end of file, or request the chunk again */
+        chunk->valid = false;
+        if (chunk->length == 0)
+            return 0;
+        Submit (access);
+        chunk = ChunkFind (sys, ChunkAlign (sys->pos));
+    }
+
+    size_t skip = sys->pos - chunk->offset;
+    size_t copy = chunk->length - skip;
+    if (copy > len)
+        copy = len;
+
+    memcpy (buf, chunk->buffer + skip, copy);
+    sys->pos += copy;
+
+    /* Recycle the chunk once fully consumed */
+    if (sys->pos >= chunk->offset + chunk->length)
+        chunk->valid = false;
+    return copy;
+}
+
+static int Seek (stream_t *access, uint64_t pos)
+{
+    access_sys_t *sys = access->p_sys;
+    const uint64_t start = ChunkAlign (pos);
+    const uint64_t end = start + (uint64_t)sys->depth * CHUNK_SIZE;
+
+    /* Keep the requests still ahead of the new position, drop the others.
+     * Dropped requests in flight complete in the background. */
+    for (unsigned i = 0; i < sys->depth; i++)
+    {
+        uring_chunk_t *chunk = &sys->chunks[i];
+
+        if (chunk->offset < start || chunk->offset >= end)
+            chunk->valid = false;
+    }
+
+    sys->pos = pos;
+    return VLC_SUCCESS;
+}
+
+static int Control (stream_t *access, int query, va_list args)
+{
+    access_sys_t *sys = access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg (args, bool *) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+        {
+            struct stat st;
+
+            if (fstat (sys->fd, &st))
+                return VLC_EGENERIC;
+            *va_arg (args, uint64_t *) = st.st_size;
+            break;
+        }
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg (args, int64_t *) = INT64_C(1000)
+                * var_InheritInteger (access, sys->remote ? "network-caching"
+                                                          : "file-caching");
+            break;
+
+        case STREAM_SET_PAUSE_STATE:
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static bool IsRemote (int fd)
+{
+#ifdef HAVE_LINUX_MAGIC_H
+    struct statfs stf;
+
+    if (fstatfs (fd, &stf))
+        return false;
+
+    switch ((unsigned long)stf.f_type)
+    {
+        case AFS_SUPER_MAGIC:
+        case CODA_SUPER_MAGIC:
+        case NCP_SUPER_MAGIC:
+        case NFS_SUPER_MAGIC:
+        case SMB_SUPER_MAGIC:
+        case 0xFF534D42 /*CIFS_MAGIC_NUMBER*/:
+            return true;
+    }
+#else
+    (void) fd;
+#endif
+    return false;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+
+    if (access->psz_filepath == NULL)
+        return VLC_EGENERIC;
+
+    int fd = vlc_open (access->psz_filepath, O_RDONLY | O_NONBLOCK);
+    if (fd == -1)
+        return VLC_EGENERIC;
+
+    /* Only regular files benefit from read-ahead requests, leave anything
+     * else (directories, devices, pipes) to the file system module. */
+    struct stat st;
+    if (fstat (fd, &st) || !S_ISREG (st.st_mode))
+        goto error;
+
+    fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_NONBLOCK);
+
+    access_sys_t *sys = vlc_obj_malloc (obj, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        goto error;
+
+    sys->fd = fd;
+    sys->remote = IsRemote (fd);
+    sys->pos = 0;
+    sys->size = st.st_size;
+    sys->depth = var_InheritInteger (obj, "uring-depth");
+    sys->requests = sys->hits = sys->waits = 0;
+
+    sys->chunks = vlc_obj_calloc (obj, sys->depth, sizeof (*sys->chunks));
+    if (unlikely(sys->chunks == NULL))
+        goto error;
+
+    for (unsigned i = 0; i < sys->depth; i++)
+    {
+        sys->chunks[i].buffer = vlc_obj_malloc (obj, CHUNK_SIZE);
+        if (unlikely(sys->chunks[i].buffer == NULL))
+            goto error;
+    }
+
+    int val = io_uring_queue_init (sys->depth, &sys->ring, 0);
+    if (val < 0)
+    {   /* Not supported by the kernel: fall back to plain reads */
+        msg_Dbg (access, "io_uring not available: %s", vlc_strerror_c(-val));
+        goto error;
+    }
+
+    access->pf_read = Read;
+    access->pf_block = NULL;
+    access->pf_seek = Seek;
+    access->pf_control = Control;
+    access->p_sys = sys;
+
+    /* Demuxers will need the beginning of the file for probing. */
+    Submit (access);
+    return VLC_SUCCESS;
+
+error:
+    vlc_close (fd);
+    return VLC_EGENERIC;
+}
+
+static void Close (vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+    access_sys_t *sys = access->p_sys;
+
+    /* Buffers must not be freed while the kernel may still write them */
+    for (unsigned i = 0; i < sys->depth; i++)
+        while (sys->chunks[i].pending)
+            if (Reap (access, true) < 0)
+                break;
+
+    msg_Dbg (access, "%lu requests, %lu reads from completed requests, "
+             "%lu waits", sys->requests, sys->hits, sys->waits);
+
+    io_uring_queue_exit (&sys->ring);
+    vlc_close (sys->fd);
+}
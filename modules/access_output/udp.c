@@ -50,6 +50,7 @@
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
+#define MAX_BATCH 64
 
 /*****************************************************************************
  * Module descriptor
@@ -71,6 +72,15 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Transmit batch size")
+#define BATCH_LONGTEXT N_("Maximum number of packets sent with a single " \
+                          "system call (1 disables batching)." )
+#define BATCH_WINDOW_TEXT N_("Transmit batch window (us)")
+#define BATCH_WINDOW_LONGTEXT N_("Packets due within this delay after the " \
+                          "first packet of a batch are sent along with it. " \
+                          "Packets carrying a clock reference are never " \
+                          "sent ahead of time." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -79,6 +89,12 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+#ifdef HAVE_SENDMMSG
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 16, 1, MAX_BATCH,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch-window", 0, 0, 100000,
+                            BATCH_WINDOW_TEXT, BATCH_WINDOW_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -92,6 +108,10 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+#ifdef HAVE_SENDMMSG
+    "batch",
+    "batch-window",
+#endif
     NULL
 };
 
@@ -121,6 +141,17 @@ struct sout_access_out_sys_t
     block_t      *p_buffer;
 
     vlc_thread_t  thread;
+
+#ifdef HAVE_SENDMMSG
+    /* Batched transmit (writer thread only) */
+    unsigned       i_batch;
+    mtime_t        i_batch_window;
+    block_t       *pp_batch[MAX_BATCH];
+    struct mmsghdr p_msgs[MAX_BATCH];
+    struct iovec   p_iov[MAX_BATCH];
+    uint64_t       i_calls; /**< send system calls */
+    uint64_t       i_packets; /**< packets sent */
+#endif
 };
 
 #define DEFAULT_PORT 1234
@@ -209,9 +240,21 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
-    p_sys->p_fifo = block_FifoNew();
-    p_sys->p_empty_blocks = block_FifoNew();
+    p_sys->p_fifo = block_FifoNewLockless();
+    p_sys->p_empty_blocks = block_FifoNewLockless();
     p_sys->p_buffer = NULL;
+#ifdef HAVE_SENDMMSG
+    p_sys->i_batch = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    p_sys->i_batch_window = var_GetInteger( p_access,
+                                            SOUT_CFG_PREFIX "batch-window" );
+    p_sys->i_calls = p_sys->i_packets = 0;
+    memset( p_sys->p_msgs, 0, sizeof (p_sys->p_msgs) );
+    for( unsigned i = 0; i < MAX_BATCH; i++ )
+    {
+        p_sys->p_msgs[i].msg_hdr.msg_iov = &p_sys->p_iov[i];
+        p_sys->p_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
 
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
@@ -245,6 +288,12 @@ static void Close( vlc_object_t * p_this )
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
 
+#ifdef HAVE_SENDMMSG
+    if( p_sys->i_calls > 0 )
+        msg_Dbg( p_access, "sent %"PRIu64" packets in %"PRIu64" system calls "
+                 "(%.2f per call)", p_sys->i_packets, p_sys->i_calls,
+                 (double)p_sys->i_packets / p_sys->i_calls );
+#endif
     net_Close( p_sys->i_handle );
     free( p_sys );
 }
@@ -380,6 +429,66 @@ static block_t *NewUDPPacket( sout_access_out_t *p_access, mtime_t i_dts)
     return p_buffer;
 }
 
+#ifdef HAVE_SENDMMSG
+/*****************************************************************************
+ * SendBatch: send a packet along with the following ones that are due soon.
+ *****************************************************************************
+ * The first packet is owned by the caller. Other packets are dequeued from
+ * the FIFO, sent and recycled here. Returns the date of the last packet.
+ *****************************************************************************/
+static mtime_t SendBatch( sout_access_out_t *p_access, block_t *p_first,
+                          mtime_t i_date )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    mtime_t i_limit = __MAX( i_date, mdate() ) + p_sys->i_batch_window;
+    unsigned i_count = 1;
+
+    p_sys->pp_batch[0] = p_first;
+
+    while( i_count < p_sys->i_batch )
+    {
+        block_t *p_pk = block_FifoShow( p_sys->p_fifo );
+        if( p_pk == NULL )
+            break;
+
+        mtime_t i_next = p_sys->i_caching + p_pk->i_dts;
+
+        /* Clock references must go out on time, not ahead of it */
+        if( (p_pk->i_flags & BLOCK_FLAG_CLOCK) || i_next > i_limit
+         || i_next - i_date > 2000000 )
+            break;
+
+        p_sys->pp_batch[i_count++] = block_FifoGet( p_sys->p_fifo );
+        i_date = i_next;
+    }
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        p_sys->p_iov[i].iov_base = p_sys->pp_batch[i]->p_buffer;
+        p_sys->p_iov[i].iov_len = p_sys->pp_batch[i]->i_buffer;
+    }
+
+    for( unsigned i_sent = 0; i_sent < i_count; )
+    {
+        int val = sendmmsg( p_sys->i_handle, p_sys->p_msgs + i_sent,
+                            i_count - i_sent, 0 );
+        p_sys->i_calls++;
+        if( val == -1 )
+        {   /* Skip the failed packet */
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1;
+        }
+        else
+            p_sys->i_packets += val;
+        i_sent += val;
+    }
+
+    for( unsigned i = 1; i < i_count; i++ )
+        block_FifoPut( p_sys->p_empty_blocks, p_sys->pp_batch[i] );
+    return i_date;
+}
+#endif
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -428,6 +537,15 @@ static void* ThreadWrite( void *data )
             mwait( i_date );
             i_to_send = i_group;
         }
+#ifdef HAVE_SENDMMSG
+        if( p_sys->i_batch > 1 )
+        {
+            int canc = vlc_savecancel();
+            i_date = SendBatch( p_access, p_pk, i_date );
+            vlc_restorecancel( canc );
+        }
+        else
+#endif
         if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
             msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
         vlc_cleanup_pop();
@@ -139,6 +139,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->b_in_place = true;
 
     var_Create(p_filter->obj.libvlc, "audiobargraph_v-alarm", VLC_VAR_BOOL);
     var_Create(p_filter->obj.libvlc, "audiobargraph_v-i_values", VLC_VAR_STRING);
@@ -39,6 +39,8 @@
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "../dsp.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -105,8 +107,11 @@ struct atomic_operation_t
 
 struct filter_sys_t
 {
-    size_t i_overflow_buffer_size;/* in bytes */
-    float * p_overflow_buffer;
+    unsigned int i_max_delay;/* in sample unit */
+    unsigned int i_max_samples;
+    /* For each input channel, the i_max_delay previous samples followed by
+     * room for i_max_samples samples, then the left and right ears */
+    float * p_planar;
     unsigned int i_nb_atomic_operations;
     struct atomic_operation_t * p_atomic_operations;
 };
@@ -304,131 +309,107 @@ static int Init( vlc_object_t *p_this, struct filter_sys_t * p_data
         i_source_channel_offset++;
     }
 
-    /* Initialize the overflow buffer
-     * we need it because the process induce a delay in the samples */
-    p_data->i_overflow_buffer_size = 0;
+    /* The process induces a delay in the samples, keep enough of the
+     * previous ones */
+    p_data->i_max_delay = 0;
     for( i = 0 ; i < p_data->i_nb_atomic_operations ; i++ )
     {
-        if( p_data->i_overflow_buffer_size
-                < p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float) )
-        {
-            p_data->i_overflow_buffer_size
-                = p_data->p_atomic_operations[i].i_delay * 2 * sizeof (float);
-        }
+        if( p_data->i_max_delay < p_data->p_atomic_operations[i].i_delay )
+            p_data->i_max_delay = p_data->p_atomic_operations[i].i_delay;
     }
-    p_data->p_overflow_buffer = malloc( p_data->i_overflow_buffer_size );
-    if( p_data->p_overflow_buffer == NULL )
-    {
-        free( p_data->p_atomic_operations );
+
+    return 0;
+}
+
+/*****************************************************************************
+ * Reserve: grow the planar buffers, keeping the previous samples
+ *****************************************************************************/
+static int Reserve( struct filter_sys_t * p_data, unsigned int i_nb_channels,
+                    unsigned int i_samples )
+{
+    if( i_samples <= p_data->i_max_samples )
+        return 0;
+
+    size_t i_old_stride = p_data->i_max_delay + p_data->i_max_samples;
+    size_t i_stride = p_data->i_max_delay + i_samples;
+    float * p_planar = vlc_alloc( i_nb_channels * i_stride + 2 * i_samples,
+                                  sizeof (float) );
+    if( p_planar == NULL )
         return -1;
-    }
-    memset( p_data->p_overflow_buffer, 0 , p_data->i_overflow_buffer_size );
 
+    for( unsigned int i = 0; i < i_nb_channels; i++ )
+    {
+        if( p_data->p_planar != NULL )
+            memcpy( p_planar + i * i_stride,
+                    p_data->p_planar + i * i_old_stride,
+                    p_data->i_max_delay * sizeof (float) );
+        else
+            memset( p_planar + i * i_stride, 0,
+                    p_data->i_max_delay * sizeof (float) );
+    }
+    free( p_data->p_planar );
+    p_data->p_planar = p_planar;
+    p_data->i_max_samples = i_samples;
     return 0;
 }
 
 /*****************************************************************************
  * DoWork: convert a buffer
  *****************************************************************************/
-static void DoWork( filter_t * p_filter,
-                    block_t * p_in_buf, block_t * p_out_buf )
+static int DoWork( filter_t * p_filter,
+                   block_t * p_in_buf, block_t * p_out_buf )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    unsigned int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    unsigned int i_samples = p_in_buf->i_nb_samples;
 
-    float * p_in = (float*) p_in_buf->p_buffer;
-    float * p_out;
-    uint8_t * p_overflow;
-    uint8_t * p_end_overflow;
-    uint8_t * p_slide;
+    const float * p_in = (const float *) p_in_buf->p_buffer;
+    float * p_out = (float *) p_out_buf->p_buffer;
 
-    size_t i_overflow_size;     /* in bytes */
-    size_t i_out_size;          /* in bytes */
+    if( Reserve( p_sys, i_input_nb, i_samples ) )
+        return -1;
 
-    unsigned int i, j;
+    size_t i_stride = p_sys->i_max_delay + p_sys->i_max_samples;
+    float * p_ears = p_sys->p_planar + i_input_nb * i_stride;
 
-    int i_source_channel_offset;
-    int i_dest_channel_offset;
-    unsigned int i_delay;
-    double d_amplitude_factor;
+    /* Deinterleave the input after the previous samples of each channel */
+    for( unsigned int i = 0; i < i_input_nb; i++ )
+    {
+        float * p_dst = p_sys->p_planar + i * i_stride + p_sys->i_max_delay;
 
-    p_out = (float *)p_out_buf->p_buffer;
-    i_out_size = p_out_buf->i_buffer;
+        for( unsigned int j = 0; j < i_samples; j++ )
+            p_dst[j] = p_in[j * i_input_nb + i];
+    }
 
-    /* Slide the overflow buffer */
-    p_overflow = (uint8_t *) p_sys->p_overflow_buffer;
-    i_overflow_size = p_sys->i_overflow_buffer_size;
-    p_end_overflow = p_overflow + i_overflow_size;
+    /* apply the atomic operations */
+    memset( p_ears, 0, 2 * i_samples * sizeof (float) );
+    for( unsigned int i = 0; i < p_sys->i_nb_atomic_operations; i++ )
+    {
+        const struct atomic_operation_t * p_op = &p_sys->p_atomic_operations[i];
+        const float * p_src = p_sys->p_planar
+                            + p_op->i_source_channel_offset * i_stride
+                            + p_sys->i_max_delay - p_op->i_delay;
 
-    memset( p_out, 0, i_out_size );
-    memcpy( p_out, p_overflow, __MIN( i_out_size, i_overflow_size ) );
+        dsp_MixAdd( p_ears + p_op->i_dest_channel_offset * i_samples, p_src,
+                    p_op->d_amplitude_factor, i_samples );
+    }
 
-    p_slide = (uint8_t *) p_sys->p_overflow_buffer;
-    while( p_slide < p_end_overflow )
+    /* Interleave the ears to the stereo output */
+    for( unsigned int j = 0; j < i_samples; j++ )
     {
-        size_t i_bytes_copied;
-
-        if( p_slide + i_out_size < p_end_overflow )
-        {
-            memset( p_slide, 0, i_out_size );
-            if( p_slide + 2 * i_out_size < p_end_overflow )
-                i_bytes_copied = i_out_size;
-            else
-                i_bytes_copied = p_end_overflow - ( p_slide + i_out_size );
-            memcpy( p_slide, p_slide + i_out_size, i_bytes_copied );
-        }
-        else
-        {
-            i_bytes_copied = p_end_overflow - p_slide;
-            memset( p_slide, 0, i_bytes_copied );
-        }
-        p_slide += i_bytes_copied;
+        p_out[2 * j] = p_ears[j];
+        p_out[2 * j + 1] = p_ears[i_samples + j];
     }
 
-    /* apply the atomic operations */
-    for( i = 0; i < p_sys->i_nb_atomic_operations; i++ )
+    /* Keep the last samples for the next buffer */
+    for( unsigned int i = 0; i < i_input_nb; i++ )
     {
-        /* shorter variable names */
-        i_source_channel_offset
-            = p_sys->p_atomic_operations[i].i_source_channel_offset;
-        i_dest_channel_offset
-            = p_sys->p_atomic_operations[i].i_dest_channel_offset;
-        i_delay = p_sys->p_atomic_operations[i].i_delay;
-        d_amplitude_factor
-            = p_sys->p_atomic_operations[i].d_amplitude_factor;
-
-        if( p_out_buf->i_nb_samples > i_delay )
-        {
-            /* current buffer coefficients */
-            for( j = 0; j < p_out_buf->i_nb_samples - i_delay; j++ )
-            {
-                ((float*)p_out)[ (i_delay+j)*i_output_nb + i_dest_channel_offset ]
-                    += p_in[ j * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
-
-            /* overflow buffer coefficients */
-            for( j = 0; j < i_delay; j++ )
-            {
-                ((float*)p_overflow)[ j*i_output_nb + i_dest_channel_offset ]
-                    += p_in[ (p_out_buf->i_nb_samples - i_delay + j)
-                       * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
-        }
-        else
-        {
-            /* overflow buffer coefficients only */
-            for( j = 0; j < p_out_buf->i_nb_samples; j++ )
-            {
-                ((float*)p_overflow)[ (i_delay - p_out_buf->i_nb_samples + j)
-                                        * i_output_nb + i_dest_channel_offset ]
-                    += p_in[ j * i_input_nb + i_source_channel_offset ]
-                       * d_amplitude_factor;
-            }
-        }
+        float * p_channel = p_sys->p_planar + i * i_stride;
+
+        memmove( p_channel, p_channel + i_samples,
+                 p_sys->i_max_delay * sizeof (float) );
     }
+    return 0;
 }
 
 /*
@@ -454,8 +435,9 @@ static int OpenFilter( vlc_object_t *p_this )
     p_sys = p_filter->p_sys = malloc( sizeof(struct filter_sys_t) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
-    p_sys->i_overflow_buffer_size = 0;
-    p_sys->p_overflow_buffer = NULL;
+    p_sys->i_max_delay = 0;
+    p_sys->i_max_samples = 0;
+    p_sys->p_planar = NULL;
     p_sys->i_nb_atomic_operations = 0;
     p_sys->p_atomic_operations = NULL;
 
@@ -495,7 +477,7 @@ static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
-    free( p_filter->p_sys->p_overflow_buffer );
+    free( p_filter->p_sys->p_planar );
     free( p_filter->p_sys->p_atomic_operations );
     free( p_filter->p_sys );
 }
@@ -513,7 +495,7 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
         aout_FormatNbChannels( &(p_filter->fmt_out.audio) ) /
         aout_FormatNbChannels( &(p_filter->fmt_in.audio) );
 
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
@@ -526,7 +508,11 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    if( DoWork( p_filter, p_block, p_out ) )
+    {
+        block_Release( p_out );
+        p_out = NULL;
+    }
 
     block_Release( p_block );
     return p_out;
@@ -61,7 +61,7 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
 
     assert( i_input_nb < i_output_nb );
 
-    block_t *p_out_buf = block_Alloc(
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter,
                               p_in_buf->i_buffer * i_output_nb / i_input_nb );
     if( unlikely(p_out_buf == NULL) )
     {
@@ -134,7 +134,7 @@ static block_t *Extract( filter_t *p_filter, block_t *p_in_buf )
                       * p_filter->fmt_out.audio.i_bitspersample
                       * i_out_channels / 8;
 
-    block_t *p_out_buf = block_Alloc( i_out_size );
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_out_size );
     if( unlikely(p_out_buf == NULL) )
     {
         block_Release( p_in_buf );
@@ -157,6 +157,7 @@ static block_t *Extract( filter_t *p_filter, block_t *p_in_buf )
                          p_in_buf->i_nb_samples, pi_selections,
                          p_filter->fmt_out.audio.i_bitspersample );
 
+    block_Release( p_in_buf );
     return p_out_buf;
 }
 
@@ -177,6 +178,7 @@ static int Create( vlc_object_t *p_this )
         if( aout_FormatNbChannels( outfmt ) == infmt->i_channels )
         {
             p_filter->pf_audio_filter = Equals;
+            p_filter->b_in_place = true;
             return VLC_SUCCESS;
         }
         else
@@ -207,6 +209,7 @@ static int Create( vlc_object_t *p_this )
       && aout_FormatNbChannels( infmt ) == 1 )
     {
         p_filter->pf_audio_filter = Equals;
+        p_filter->b_in_place = true;
         return VLC_SUCCESS;
     }
 
@@ -289,6 +292,7 @@ static int Create( vlc_object_t *p_this )
         if( b_equals )
         {
             p_filter->pf_audio_filter = Equals;
+            p_filter->b_in_place = true;
             return VLC_SUCCESS;
         }
     }
@@ -301,7 +305,10 @@ static int Create( vlc_object_t *p_this )
     if( aout_FormatNbChannels( outfmt ) > aout_FormatNbChannels( infmt ) )
         p_filter->pf_audio_filter = Upmix;
     else
+    {
         p_filter->pf_audio_filter = Downmix;
+        p_filter->b_in_place = true;
+    }
 
     return VLC_SUCCESS;
 }
@@ -39,6 +39,8 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
+#include "dsp.h"
+
 /*****************************************************************************
 * Local prototypes.
 *****************************************************************************/
@@ -54,6 +56,7 @@
 #define DB_DEFAULT_CUBE
 #define RMS_BUF_SIZE    (960)
 #define LOOKAHEAD_SIZE  ((RMS_BUF_SIZE)<<1)
+#define CHUNK_SIZE      (256)
 
 #define LIN_INTERP(f,a,b) ((a) + (f) * ( (b) - (a) ))
 #define LIMIT(v,l,u)      (v < l ? l : ( v > u ? u : v ))
@@ -69,12 +72,8 @@ typedef struct
 
 typedef struct
 {
-    struct
-    {
-        float pf_vals[AOUT_CHAN_MAX];
-        float f_lev_in;
-
-    } p_buf[LOOKAHEAD_SIZE];
+    float pf_vals[LOOKAHEAD_SIZE * AOUT_CHAN_MAX]; /* interleaved frames */
+    float pf_lev_in[LOOKAHEAD_SIZE];
     unsigned int i_pos;
     unsigned int i_count;
 
@@ -127,11 +126,11 @@ static float    CubeInterp      ( const float, const float, const float,
                                   const float, const float );
 #endif
 static void     RoundToZero     ( float * );
-static float    Max             ( float, float );
 static float    Clamp           ( float, float, float );
 static int      Round           ( float );
 static float    RmsEnvProcess   ( rms_env *, const float );
-static void     BufferProcess   ( float *, int, float, float, lookahead * );
+static void     BufferProcess   ( float *, int, const float *, int,
+                                  lookahead * );
 
 static int RMSPeakCallback      ( vlc_object_t *, char const *, vlc_value_t,
                                   vlc_value_t, void * );
@@ -258,6 +257,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->b_in_place = true;
 
     /* At this stage, we are ready! */
     msg_Dbg( p_filter, "compressor successfully initialized" );
@@ -339,95 +339,109 @@ static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
     float f_ef_a     = f_ga * 0.25f;
     float f_ef_ai    = 1.0f - f_ef_a;
 
-    /* Process the current buffer */
-    for( int i = 0; i < i_samples; i++ )
+    /* Process the current buffer by chunks that do not wrap around the
+     * lookahead array: the peak detection and the gain are vectorized, only
+     * the envelopes are computed sample by sample */
+    while( i_samples > 0 )
     {
-        float f_lev_in_old, f_lev_in_new;
+        float pf_peak[CHUNK_SIZE];
+        float pf_gain[CHUNK_SIZE];
+        int i_count = __MIN( i_samples, CHUNK_SIZE );
 
-        /* Now, compress the pre-equalized audio (ported from sc4_1882
-         * plugin with a few modifications) */
+        i_count = __MIN( i_count, (int)( p_la->i_count - p_la->i_pos ) );
+        dsp_FramePeak( pf_buf, i_count, i_channels, pf_peak );
 
-        /* Fetch the old delayed buffer value */
-        f_lev_in_old = p_la->p_buf[p_la->i_pos].f_lev_in;
-
-        /* Find the peak value of current sample.  This becomes the new delayed
-         * buffer value that replaces the old one in the lookahead array */
-        f_lev_in_new = fabs( pf_buf[0] );
-        for( int i_chan = 1; i_chan < i_channels; i_chan++ )
+        for( int i = 0; i < i_count; i++ )
         {
-            f_lev_in_new = Max( f_lev_in_new, fabs( pf_buf[i_chan] ) );
-        }
-        p_la->p_buf[p_la->i_pos].f_lev_in = f_lev_in_new;
+            float f_lev_in_old, f_lev_in_new;
 
-        /* Add the square of the peak value to a running sum */
-        f_sum += f_lev_in_new * f_lev_in_new;
+            /* Now, compress the pre-equalized audio (ported from sc4_1882
+             * plugin with a few modifications) */
 
-        /* Update the RMS envelope */
-        if( f_amp > f_env_rms )
-        {
-            f_env_rms = f_env_rms * f_ga + f_amp * ( 1.0f - f_ga );
-        }
-        else
-        {
-            f_env_rms = f_env_rms * f_gr + f_amp * ( 1.0f - f_gr );
-        }
-        RoundToZero( &f_env_rms );
+            /* Fetch the old delayed buffer value */
+            f_lev_in_old = p_la->pf_lev_in[p_la->i_pos + i];
 
-        /* Update the peak envelope */
-        if( f_lev_in_old > f_env_peak )
-        {
-            f_env_peak = f_env_peak * f_ga + f_lev_in_old * ( 1.0f - f_ga );
-        }
-        else
-        {
-            f_env_peak = f_env_peak * f_gr + f_lev_in_old * ( 1.0f - f_gr );
-        }
-        RoundToZero( &f_env_peak );
+            /* The peak value of current sample becomes the new delayed buffer
+             * value that replaces the old one in the lookahead array */
+            f_lev_in_new = pf_peak[i];
+            p_la->pf_lev_in[p_la->i_pos + i] = f_lev_in_new;
 
-        /* Process the RMS value and update the output gain every 4 samples */
-        if( ( p_sys->i_count++ & 3 ) == 3 )
-        {
-            /* Process the RMS value by placing in the mean square value, and
-             * reset the running sum */
-            f_amp = RmsEnvProcess( p_rms, f_sum * 0.25f );
-            f_sum = 0.0f;
-            if( isnan( f_env_rms ) )
+            /* Add the square of the peak value to a running sum */
+            f_sum += f_lev_in_new * f_lev_in_new;
+
+            /* Update the RMS envelope */
+            if( f_amp > f_env_rms )
             {
-                /* This can happen sometimes, but I don't know why. */
-                f_env_rms = 0.0f;
+                f_env_rms = f_env_rms * f_ga + f_amp * ( 1.0f - f_ga );
             }
-
-            /* Find the superposition of the RMS and peak envelopes */
-            f_env = LIN_INTERP( f_rms_peak, f_env_rms, f_env_peak );
-
-            /* Update the output gain */
-            if( f_env <= f_knee_min )
+            else
             {
-                /* Gain below the knee (and below the threshold) */
-                f_gain_out = 1.0f;
+                f_env_rms = f_env_rms * f_gr + f_amp * ( 1.0f - f_gr );
             }
-            else if( f_env < f_knee_max )
+            RoundToZero( &f_env_rms );
+
+            /* Update the peak envelope */
+            if( f_lev_in_old > f_env_peak )
             {
-                /* Gain within the knee */
-                const float f_x = -( f_threshold
-                                   - f_knee - Lin2Db( f_env, p_sys ) ) / f_knee;
-                f_gain_out = Db2Lin( -f_knee * f_rs * f_x * f_x * 0.25f,
-                                      p_sys );
+                f_env_peak = f_env_peak * f_ga
+                           + f_lev_in_old * ( 1.0f - f_ga );
             }
             else
             {
-                /* Gain above the knee (and above the threshold) */
-                f_gain_out = Db2Lin( ( f_threshold - Lin2Db( f_env, p_sys ) )
-                                     * f_rs, p_sys );
+                f_env_peak = f_env_peak * f_gr
+                           + f_lev_in_old * ( 1.0f - f_gr );
+            }
+            RoundToZero( &f_env_peak );
+
+            /* Process the RMS value and update the output gain every 4
+             * samples */
+            if( ( p_sys->i_count++ & 3 ) == 3 )
+            {
+                /* Process the RMS value by placing in the mean square value,
+                 * and reset the running sum */
+                f_amp = RmsEnvProcess( p_rms, f_sum * 0.25f );
+                f_sum = 0.0f;
+                if( isnan( f_env_rms ) )
+                {
+                    /* This can happen sometimes, but I don't know why. */
+                    f_env_rms = 0.0f;
+                }
+
+                /* Find the superposition of the RMS and peak envelopes */
+                f_env = LIN_INTERP( f_rms_peak, f_env_rms, f_env_peak );
+
+                /* Update the output gain */
+                if( f_env <= f_knee_min )
+                {
+                    /* Gain below the knee (and below the threshold) */
+                    f_gain_out = 1.0f;
+                }
+                else if( f_env < f_knee_max )
+                {
+                    /* Gain within the knee */
+                    const float f_x = -( f_threshold - f_knee
+                                       - Lin2Db( f_env, p_sys ) ) / f_knee;
+                    f_gain_out = Db2Lin( -f_knee * f_rs * f_x * f_x * 0.25f,
+                                          p_sys );
+                }
+                else
+                {
+                    /* Gain above the knee (and above the threshold) */
+                    f_gain_out = Db2Lin( ( f_threshold
+                                           - Lin2Db( f_env, p_sys ) ) * f_rs,
+                                         p_sys );
+                }
             }
-        }
 
-        /* Find the total gain */
-        f_gain = f_gain * f_ef_a + f_gain_out * f_ef_ai;
+            /* Find the total gain */
+            f_gain = f_gain * f_ef_a + f_gain_out * f_ef_ai;
+            pf_gain[i] = f_gain * f_mug;
+        }
 
         /* Write the resulting buffer to the output */
-        BufferProcess( pf_buf, i_channels, f_gain, f_mug, p_la );
-        pf_buf += i_channels;
+        BufferProcess( pf_buf, i_channels, pf_gain, i_count, p_la );
+        pf_buf += i_count * i_channels;
+        i_samples -= i_count;
     }
 
     /* Update the internal parameters */
@@ -545,16 +559,6 @@ static void RoundToZero( float *pf_x )
 
 /* A set of branchless clipping operations from Laurent de Soras */
 
-static float Max( float f_x, float f_a )
-{
-    f_x -= f_a;
-    f_x += fabsf( f_x );
-    f_x *= 0.5f;
-    f_x += f_a;
-
-    return f_x;
-}
-
 static float Clamp( float f_x, float f_a, float f_b )
 {
     const float f_x1 = fabsf( f_x - f_a );
@@ -604,26 +608,29 @@ static float RmsEnvProcess( rms_env * p_r, const float f_x )
 }
 
 /* Output the compressed delayed buffer and store the current buffer.  Uses a
- * circular array, just like the one used in calculating the RMS of the buffer
+ * circular array, just like the one used in calculating the RMS of the buffer.
+ * The samples must not wrap around the array.
  */
-static void BufferProcess( float * pf_buf, int i_channels, float f_gain,
-                           float f_mug, lookahead * p_la )
+static void BufferProcess( float * pf_buf, int i_channels,
+                           const float * pf_gain, int i_samples,
+                           lookahead * p_la )
 {
-    /* Loop through every channel */
-    for( int i_chan = 0; i_chan < i_channels; i_chan++ )
-    {
-        float f_x = pf_buf[i_chan]; /* Current buffer value */
+    float *pf_vals = &p_la->pf_vals[p_la->i_pos * i_channels];
 
-        /* Output the compressed delayed buffer value */
-        pf_buf[i_chan] = p_la->p_buf[p_la->i_pos].pf_vals[i_chan]
-                       * f_gain * f_mug;
+    /* Swap the current and the delayed buffer values */
+    for( int i = 0; i < i_samples * i_channels; i++ )
+    {
+        float f_x = pf_buf[i]; /* Current buffer value */
 
-        /* Update the delayed buffer value */
-        p_la->p_buf[p_la->i_pos].pf_vals[i_chan] = f_x;
+        pf_buf[i] = pf_vals[i];
+        pf_vals[i] = f_x;
     }
 
+    /* Output the compressed delayed buffer values */
+    dsp_ScaleFrames( pf_buf, pf_gain, i_samples, i_channels );
+
     /* Go to the next delayed buffer value for the next run */
-    p_la->i_pos = ( p_la->i_pos + 1 ) % ( p_la->i_count );
+    p_la->i_pos = ( p_la->i_pos + i_samples ) % ( p_la->i_count );
 }
 
 /*****************************************************************************
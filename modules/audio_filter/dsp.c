@@ -0,0 +1,1574 @@
+/*****************************************************************************
+ * dsp.c: vectorized DSP helpers for the audio filters
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef DSP_TEST
+# undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_es.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+# ifdef __SSE2__
+#  define DSP_SSE2
+# else
+#  define DSP_SSE2 __attribute__ ((__target__ ("sse2")))
+# endif
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define DSP_NEON
+#endif
+
+#include "dsp.h"
+#include "dsp_convert.h"
+
+struct dsp_ops
+{
+    void (*scale)(float *, float, size_t);
+    void (*mix_add)(float *, const float *, float, size_t);
+    void (*lerp)(float *, const float *, const float *, float, size_t);
+    void (*scale_channels)(float *, const float *, unsigned, unsigned);
+    void (*scale_frames)(float *, const float *, unsigned, unsigned);
+    void (*channel_energy)(const float *, unsigned, unsigned, float *);
+    void (*frame_peak)(const float *, unsigned, unsigned, float *);
+    void (*fir)(float *, const float *, const float *, unsigned, size_t);
+    float (*dot)(const float *, const float *, size_t);
+    void (*dot_planes)(float *, const float *const *, unsigned, size_t,
+                       const float *, size_t);
+    void (*biquad_cascade)(float *, unsigned, unsigned, const dsp_biquad_t *,
+                           unsigned, float *);
+    void (*resonators)(const dsp_resonators_t *, dsp_resonators_state_t *,
+                       float *, unsigned, unsigned, float);
+    void (*comb)(dsp_delay_t *, float, float, const float *, float *,
+                 unsigned);
+    void (*allpass)(dsp_delay_t *, float, float *, unsigned);
+};
+
+static inline float Flush(float f)
+{
+    return fabsf(f) < FLT_MIN ? 0.f : f;
+}
+
+/*****************************************************************************
+ * C version, one float per "vector"
+ *****************************************************************************/
+#define vec_t float
+#define VLANES 1
+#define VATTR
+#define FN(name) name##C
+#define vload(p) (*(p))
+#define vstore(p, v) (*(p) = (v))
+#define vset1(f) (f)
+#define vadd(a, b) ((a) + (b))
+#define vsub(a, b) ((a) - (b))
+#define vmul(a, b) ((a) * (b))
+#define vmax(a, b) fmaxf(a, b)
+#define vabs(v) fabsf(v)
+#define vflush(v) Flush(v)
+#define vhsum(v) (v)
+#define vhmax(v) (v)
+#include "dsp_template.h"
+
+/*****************************************************************************
+ * SSE version
+ *****************************************************************************/
+#ifdef HAVE_SSE2_INTRINSICS
+static inline VLC_SSE __m128 AbsSSE(__m128 v)
+{
+    return _mm_max_ps(v, _mm_sub_ps(_mm_setzero_ps(), v));
+}
+
+static inline VLC_SSE __m128 FlushSSE(__m128 v)
+{
+    return _mm_and_ps(v, _mm_cmpge_ps(AbsSSE(v), _mm_set1_ps(FLT_MIN)));
+}
+
+static inline VLC_SSE float SumSSE(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline VLC_SSE float MaxSSE(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+# define vec_t __m128
+# define VLANES 4
+# define VATTR VLC_SSE
+# define FN(name) name##SSE
+# define vload(p) _mm_loadu_ps(p)
+# define vstore(p, v) _mm_storeu_ps(p, v)
+# define vset1(f) _mm_set1_ps(f)
+# define vadd(a, b) _mm_add_ps(a, b)
+# define vsub(a, b) _mm_sub_ps(a, b)
+# define vmul(a, b) _mm_mul_ps(a, b)
+# define vmax(a, b) _mm_max_ps(a, b)
+# define vabs(v) AbsSSE(v)
+# define vflush(v) FlushSSE(v)
+# define vhsum(v) SumSSE(v)
+# define vhmax(v) MaxSSE(v)
+# include "dsp_template.h"
+#endif
+
+/*****************************************************************************
+ * AVX version
+ *****************************************************************************/
+#ifdef HAVE_AVX2_INTRINSICS
+# define VLC_AVX __attribute__ ((__target__ ("avx")))
+
+static inline VLC_AVX __m256 AbsAVX(__m256 v)
+{
+    return _mm256_max_ps(v, _mm256_sub_ps(_mm256_setzero_ps(), v));
+}
+
+static inline VLC_AVX __m256 FlushAVX(__m256 v)
+{
+    return _mm256_and_ps(v, _mm256_cmp_ps(AbsAVX(v), _mm256_set1_ps(FLT_MIN),
+                                          _CMP_GE_OQ));
+}
+
+static inline VLC_AVX float SumAVX(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+static inline VLC_AVX float MaxAVX(__m256 v)
+{
+    __m128 s = _mm_max_ps(_mm256_castps256_ps128(v),
+                          _mm256_extractf128_ps(v, 1));
+    s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+# define vec_t __m256
+# define VLANES 8
+# define VATTR VLC_AVX
+# define FN(name) name##AVX
+# define vload(p) _mm256_loadu_ps(p)
+# define vstore(p, v) _mm256_storeu_ps(p, v)
+# define vset1(f) _mm256_set1_ps(f)
+# define vadd(a, b) _mm256_add_ps(a, b)
+# define vsub(a, b) _mm256_sub_ps(a, b)
+# define vmul(a, b) _mm256_mul_ps(a, b)
+# define vmax(a, b) _mm256_max_ps(a, b)
+# define vabs(v) AbsAVX(v)
+# define vflush(v) FlushAVX(v)
+# define vhsum(v) SumAVX(v)
+# define vhmax(v) MaxAVX(v)
+# include "dsp_template.h"
+#endif
+
+/*****************************************************************************
+ * NEON version
+ *****************************************************************************/
+#ifdef DSP_NEON
+static inline float32x4_t FlushNEON(float32x4_t v)
+{
+    uint32x4_t mask = vcgeq_f32(vabsq_f32(v), vdupq_n_f32(FLT_MIN));
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), mask));
+}
+
+static inline float SumNEON(float32x4_t v)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+static inline float MaxNEON(float32x4_t v)
+{
+    float32x2_t s = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmax_f32(s, s), 0);
+}
+
+# define vec_t float32x4_t
+# define VLANES 4
+# define VATTR
+# define FN(name) name##NEON
+# define vload(p) vld1q_f32(p)
+# define vstore(p, v) vst1q_f32(p, v)
+# define vset1(f) vdupq_n_f32(f)
+# define vadd(a, b) vaddq_f32(a, b)
+# define vsub(a, b) vsubq_f32(a, b)
+# define vmul(a, b) vmulq_f32(a, b)
+# define vmax(a, b) vmaxq_f32(a, b)
+# define vabs(v) vabsq_f32(v)
+# define vflush(v) FlushNEON(v)
+# define vhsum(v) SumNEON(v)
+# define vhmax(v) MaxNEON(v)
+# include "dsp_template.h"
+#endif
+
+static const struct dsp_ops *GetOps(void)
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX())
+        return &opsAVX;
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE())
+        return &opsSSE;
+#endif
+#ifdef DSP_NEON
+    if (vlc_CPU_ARM_NEON())
+        return &opsNEON;
+#endif
+    return &opsC;
+}
+
+void dsp_Scale(float *buf, float gain, size_t count)
+{
+    GetOps()->scale(buf, gain, count);
+}
+
+void dsp_MixAdd(float *dst, const float *src, float gain, size_t count)
+{
+    GetOps()->mix_add(dst, src, gain, count);
+}
+
+void dsp_Lerp(float *out, const float *a, const float *b, float alpha,
+              size_t count)
+{
+    GetOps()->lerp(out, a, b, alpha, count);
+}
+
+void dsp_ScaleChannels(float *buf, const float *gains, unsigned frames,
+                       unsigned channels)
+{
+    assert(channels > 0 && channels <= DSP_CHANNELS_MAX);
+    GetOps()->scale_channels(buf, gains, frames, channels);
+}
+
+void dsp_ScaleFrames(float *buf, const float *gains, unsigned frames,
+                     unsigned channels)
+{
+    assert(channels > 0);
+    GetOps()->scale_frames(buf, gains, frames, channels);
+}
+
+void dsp_ChannelEnergy(const float *buf, unsigned frames, unsigned channels,
+                       float *energy)
+{
+    assert(channels > 0 && channels <= DSP_CHANNELS_MAX);
+    GetOps()->channel_energy(buf, frames, channels, energy);
+}
+
+void dsp_FramePeak(const float *buf, unsigned frames, unsigned channels,
+                   float *peaks)
+{
+    GetOps()->frame_peak(buf, frames, channels, peaks);
+}
+
+void dsp_Fir(float *out, const float *in, const float *taps,
+             unsigned taps_count, size_t count)
+{
+    GetOps()->fir(out, in, taps, taps_count, count);
+}
+
+float dsp_Dot(const float *a, const float *b, size_t count)
+{
+    return GetOps()->dot(a, b, count);
+}
+
+void dsp_DotPlanes(float *out, const float *const *planes, unsigned channels,
+                   size_t offset, const float *b, size_t count)
+{
+    GetOps()->dot_planes(out, planes, channels, offset, b, count);
+}
+
+void dsp_BiquadCascade(float *buf, unsigned frames, unsigned channels,
+                       const dsp_biquad_t *coeffs, unsigned stages,
+                       float *state)
+{
+    GetOps()->biquad_cascade(buf, frames, channels, coeffs, stages, state);
+}
+
+void dsp_Resonators(const dsp_resonators_t *bank,
+                    dsp_resonators_state_t *state, float *buf,
+                    unsigned frames, unsigned stride, float dry)
+{
+    GetOps()->resonators(bank, state, buf, frames, stride, dry);
+}
+
+void dsp_Comb(dsp_delay_t *line, float feedback, float damp,
+              const float *in, float *acc, unsigned count)
+{
+    GetOps()->comb(line, feedback, damp, in, acc, count);
+}
+
+void dsp_Allpass(dsp_delay_t *line, float feedback, float *buf,
+                 unsigned count)
+{
+    GetOps()->allpass(line, feedback, buf, count);
+}
+
+/*****************************************************************************
+ * FFT, iterative radix 2
+ *****************************************************************************/
+struct dsp_fft
+{
+    unsigned size;
+    unsigned *reverse; /* bit reversed indexes */
+    /* Twiddle factors exp(-2i pi k / len) for k < len / 2, stage by stage,
+     * from len = 2 at offset 0, so that the butterflies read them in
+     * sequence */
+    float *tw_re;
+    float *tw_im;
+};
+
+dsp_fft_t *dsp_FFTNew(unsigned size)
+{
+    unsigned bits = 0;
+
+    while ((1u << bits) < size)
+        bits++;
+    assert(size >= 2 && (1u << bits) == size);
+
+    dsp_fft_t *fft = malloc(sizeof (*fft));
+    if (unlikely(fft == NULL))
+        return NULL;
+
+    fft->size = size;
+    fft->reverse = vlc_alloc(size, sizeof (*fft->reverse));
+    fft->tw_re = vlc_alloc(size, sizeof (float));
+    fft->tw_im = vlc_alloc(size, sizeof (float));
+    if (unlikely(fft->reverse == NULL || fft->tw_re == NULL
+              || fft->tw_im == NULL))
+    {
+        dsp_FFTDelete(fft);
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        unsigned r = 0;
+
+        for (unsigned b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        fft->reverse[i] = r;
+    }
+
+    for (unsigned half = 1; half < size; half *= 2)
+        for (unsigned k = 0; k < half; k++)
+        {
+            double phase = -M_PI * k / half;
+
+            fft->tw_re[half - 1 + k] = cos(phase);
+            fft->tw_im[half - 1 + k] = sin(phase);
+        }
+    return fft;
+}
+
+void dsp_FFTDelete(dsp_fft_t *fft)
+{
+    free(fft->reverse);
+    free(fft->tw_re);
+    free(fft->tw_im);
+    free(fft);
+}
+
+unsigned dsp_FFTSize(const dsp_fft_t *fft)
+{
+    return fft->size;
+}
+
+void dsp_FFT(const dsp_fft_t *fft, float *re, float *im, bool inverse)
+{
+    const unsigned size = fft->size;
+    const float sign = inverse ? -1.f : 1.f;
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        unsigned r = fft->reverse[i];
+
+        if (r > i)
+        {
+            float t = re[i]; re[i] = re[r]; re[r] = t;
+            t = im[i]; im[i] = im[r]; im[r] = t;
+        }
+    }
+
+    for (unsigned half = 1; half < size; half *= 2)
+    {
+        const float *tw_re = fft->tw_re + half - 1;
+        const float *tw_im = fft->tw_im + half - 1;
+
+        for (unsigned start = 0; start < size; start += 2 * half)
+        {
+            float *re0 = re + start, *im0 = im + start;
+            float *re1 = re0 + half, *im1 = im0 + half;
+
+            for (unsigned k = 0; k < half; k++)
+            {
+                const float wi = sign * tw_im[k];
+                const float vr = re1[k] * tw_re[k] - im1[k] * wi;
+                const float vi = re1[k] * wi + im1[k] * tw_re[k];
+
+                re1[k] = re0[k] - vr;
+                im1[k] = im0[k] - vi;
+                re0[k] += vr;
+                im0[k] += vi;
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * Sample format conversions
+ *****************************************************************************/
+enum { CVT_U8, CVT_S16, CVT_S32, CVT_FL32, CVT_FL64, CVT_FORMATS };
+
+static int FormatIndex(vlc_fourcc_t format)
+{
+    switch (format)
+    {
+        case VLC_CODEC_U8:   return CVT_U8;
+        case VLC_CODEC_S16N: return CVT_S16;
+        case VLC_CODEC_S32N: return CVT_S32;
+        case VLC_CODEC_FL32: return CVT_FL32;
+        case VLC_CODEC_FL64: return CVT_FL64;
+    }
+    return -1;
+}
+
+static const uint8_t format_sizes[CVT_FORMATS] = { 1, 2, 4, 4, 8 };
+
+/* Same result as maxps then minps: NaN becomes lo */
+static inline float ClampF(float v, float lo, float hi)
+{
+    v = v > lo ? v : lo;
+    return v < hi ? v : hi;
+}
+
+static inline double ClampD(double v, double lo, double hi)
+{
+    v = v > lo ? v : lo;
+    return v < hi ? v : hi;
+}
+
+/* Rounds half up, and saturates */
+static inline uint8_t S16ToU8(int16_t s)
+{
+    int v = (s + 0x80) >> 8;
+    return (v > 127 ? 127 : v) + 128;
+}
+
+static inline uint8_t S32ToU8(int32_t s)
+{
+    int v = ((s >> 23) + 1) >> 1;
+    return (v > 127 ? 127 : v) + 128;
+}
+
+static inline int16_t S32ToS16(int32_t s)
+{
+    int v = ((s >> 15) + 1) >> 1;
+    return v > 32767 ? 32767 : v;
+}
+
+static inline int32_t Fl32ToS32(float f)
+{
+    float s = ClampF(f * 2147483648.f, -2147483648.f, 2147483648.f);
+    return s >= 2147483648.f ? INT32_MAX : lrintf(s);
+}
+
+/* The destination is written no faster than the source is read, so that the
+ * narrowing conversions work in place */
+#define CVT_C(name, src_t, dst_t, expr) \
+static void name##C(void *dst, const void *src, size_t count) \
+{ \
+    const src_t *in = src; \
+    dst_t *out = dst; \
+    for (size_t i = 0; i < count; i++) \
+    { \
+        src_t x = in[i]; \
+        out[i] = (expr); \
+    } \
+}
+
+CVT_C(U8toS16, uint8_t, int16_t, (x - 128) * 256)
+CVT_C(U8toS32, uint8_t, int32_t, (x - 128) * 16777216)
+CVT_C(U8toFl32, uint8_t, float, (x - 128) * (1.f / 128.f))
+CVT_C(U8toFl64, uint8_t, double, (x - 128) * (1. / 128.))
+CVT_C(S16toU8, int16_t, uint8_t, S16ToU8(x))
+CVT_C(S16toS32, int16_t, int32_t, x * 65536)
+CVT_C(S16toFl32, int16_t, float, x * (1.f / 32768.f))
+CVT_C(S16toFl64, int16_t, double, x * (1. / 32768.))
+CVT_C(S32toU8, int32_t, uint8_t, S32ToU8(x))
+CVT_C(S32toS16, int32_t, int16_t, S32ToS16(x))
+CVT_C(S32toFl32, int32_t, float, (float)x * (1.f / 2147483648.f))
+CVT_C(S32toFl64, int32_t, double, x * (1. / 2147483648.))
+CVT_C(Fl32toU8, float, uint8_t,
+      lrintf(ClampF(x * 128.f, -128.f, 127.f)) + 128)
+CVT_C(Fl32toS16, float, int16_t,
+      lrintf(ClampF(x * 32768.f, -32768.f, 32767.f)))
+CVT_C(Fl32toS32, float, int32_t, Fl32ToS32(x))
+CVT_C(Fl32toFl64, float, double, x)
+CVT_C(Fl64toU8, double, uint8_t,
+      lrint(ClampD(x * 128., -128., 127.)) + 128)
+CVT_C(Fl64toS16, double, int16_t,
+      lrint(ClampD(x * 32768., -32768., 32767.)))
+CVT_C(Fl64toS32, double, int32_t,
+      lrint(ClampD(x * 2147483648., -2147483648., 2147483647.)))
+CVT_C(Fl64toFl32, double, float, x)
+
+#define CVT_COPY(size) \
+static void Copy##size(void *dst, const void *src, size_t count) \
+{ \
+    memmove(dst, src, count * size); \
+}
+
+CVT_COPY(1)
+CVT_COPY(2)
+CVT_COPY(4)
+CVT_COPY(8)
+
+/* Indexed by source, then destination format */
+static const dsp_convert_t cvtC[CVT_FORMATS][CVT_FORMATS] = {
+    { Copy1, U8toS16C, U8toS32C, U8toFl32C, U8toFl64C },
+    { S16toU8C, Copy2, S16toS32C, S16toFl32C, S16toFl64C },
+    { S32toU8C, S32toS16C, Copy4, S32toFl32C, S32toFl64C },
+    { Fl32toU8C, Fl32toS16C, Fl32toS32C, Copy4, Fl32toFl64C },
+    { Fl64toU8C, Fl64toS16C, Fl64toS32C, Fl64toFl32C, Copy8 },
+};
+
+#ifdef HAVE_SSE2_INTRINSICS
+/* The kernels convert whole vectors, loading all the source of an iteration
+ * before storing, and leave the tail to the C versions. The float to integer
+ * conversions round with the MXCSR mode, to nearest even by default, as
+ * lrint() does. */
+# define CVT_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+# define CVT_STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+
+/* Expands 16 U8 samples to S32 ones */
+static inline DSP_SSE2 void U8Expand(__m128i v, __m128i s32[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    v = _mm_xor_si128(v, _mm_set1_epi8(0x80));
+    __m128i lo = _mm_unpacklo_epi8(zero, v), hi = _mm_unpackhi_epi8(zero, v);
+    s32[0] = _mm_unpacklo_epi16(zero, lo);
+    s32[1] = _mm_unpackhi_epi16(zero, lo);
+    s32[2] = _mm_unpacklo_epi16(zero, hi);
+    s32[3] = _mm_unpackhi_epi16(zero, hi);
+}
+
+/* Packs 16 S32 samples in [-128, 128] to U8 ones */
+static inline DSP_SSE2 __m128i U8Pack(__m128i a, __m128i b, __m128i c,
+                                      __m128i d)
+{
+    __m128i v = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    return _mm_xor_si128(v, _mm_set1_epi8(0x80));
+}
+
+static inline DSP_SSE2 void StoreFl64(double *out, __m128i s32, __m128d gain)
+{
+    _mm_storeu_pd(out, _mm_mul_pd(_mm_cvtepi32_pd(s32), gain));
+    _mm_storeu_pd(out + 2, _mm_mul_pd(_mm_cvtepi32_pd(
+                                      _mm_unpackhi_epi64(s32, s32)), gain));
+}
+
+/* Rounds S32 samples to 32 - bits bits */
+static inline DSP_SSE2 __m128i RoundS32(__m128i v, int bits)
+{
+    v = _mm_srai_epi32(v, bits - 1);
+    return _mm_srai_epi32(_mm_add_epi32(v, _mm_set1_epi32(1)), 1);
+}
+
+static inline DSP_SSE2 __m128i Fl32ToInt(__m128 v, __m128 gain, __m128 lo,
+                                         __m128 hi)
+{
+    v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(v, gain), lo), hi);
+    return _mm_cvtps_epi32(v);
+}
+
+static inline DSP_SSE2 __m128i Fl64ToInt(const double *in, __m128d gain,
+                                         __m128d lo, __m128d hi)
+{
+    __m128d a = _mm_mul_pd(_mm_loadu_pd(in), gain);
+    __m128d b = _mm_mul_pd(_mm_loadu_pd(in + 2), gain);
+
+    a = _mm_min_pd(_mm_max_pd(a, lo), hi);
+    b = _mm_min_pd(_mm_max_pd(b, lo), hi);
+    return _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b));
+}
+
+static DSP_SSE2 void U8toS16SSE2(void *dst, const void *src, size_t count)
+{
+    const uint8_t *in = src;
+    int16_t *out = dst;
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi8(0x80);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_xor_si128(CVT_LOAD(in + i), bias);
+        CVT_STORE(out + i, _mm_unpacklo_epi8(zero, v));
+        CVT_STORE(out + i + 8, _mm_unpackhi_epi8(zero, v));
+    }
+    U8toS16C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void U8toS32SSE2(void *dst, const void *src, size_t count)
+{
+    const uint8_t *in = src;
+    int32_t *out = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v[4];
+
+        U8Expand(CVT_LOAD(in + i), v);
+        for (unsigned j = 0; j < 4; j++)
+            CVT_STORE(out + i + 4 * j, v[j]);
+    }
+    U8toS32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void U8toFl32SSE2(void *dst, const void *src, size_t count)
+{
+    const uint8_t *in = src;
+    float *out = dst;
+    const __m128 gain = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v[4];
+
+        U8Expand(CVT_LOAD(in + i), v);
+        for (unsigned j = 0; j < 4; j++)
+            _mm_storeu_ps(out + i + 4 * j,
+                          _mm_mul_ps(_mm_cvtepi32_ps(v[j]), gain));
+    }
+    U8toFl32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void U8toFl64SSE2(void *dst, const void *src, size_t count)
+{
+    const uint8_t *in = src;
+    double *out = dst;
+    const __m128d gain = _mm_set1_pd(1. / 2147483648.);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v[4];
+
+        U8Expand(CVT_LOAD(in + i), v);
+        for (unsigned j = 0; j < 4; j++)
+            StoreFl64(out + i + 4 * j, v[j], gain);
+    }
+    U8toFl64C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S16toU8SSE2(void *dst, const void *src, size_t count)
+{
+    const int16_t *in = src;
+    uint8_t *out = dst;
+    const __m128i half = _mm_set1_epi16(0x80);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        /* The saturated addition gives 127 from 32767 as in S16ToU8() */
+        __m128i a = _mm_srai_epi16(_mm_adds_epi16(CVT_LOAD(in + i), half), 8);
+        __m128i b = _mm_srai_epi16(_mm_adds_epi16(CVT_LOAD(in + i + 8), half),
+                                   8);
+        CVT_STORE(out + i, _mm_xor_si128(_mm_packs_epi16(a, b),
+                                         _mm_set1_epi8(0x80)));
+    }
+    S16toU8C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S16toS32SSE2(void *dst, const void *src, size_t count)
+{
+    const int16_t *in = src;
+    int32_t *out = dst;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = CVT_LOAD(in + i);
+        CVT_STORE(out + i, _mm_unpacklo_epi16(zero, v));
+        CVT_STORE(out + i + 4, _mm_unpackhi_epi16(zero, v));
+    }
+    S16toS32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S16toFl32SSE2(void *dst, const void *src, size_t count)
+{
+    const int16_t *in = src;
+    float *out = dst;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 gain = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = CVT_LOAD(in + i);
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(zero, v));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(zero, v));
+        _mm_storeu_ps(out + i, _mm_mul_ps(lo, gain));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(hi, gain));
+    }
+    S16toFl32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S16toFl64SSE2(void *dst, const void *src, size_t count)
+{
+    const int16_t *in = src;
+    double *out = dst;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128d gain = _mm_set1_pd(1. / 2147483648.);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = CVT_LOAD(in + i);
+        StoreFl64(out + i, _mm_unpacklo_epi16(zero, v), gain);
+        StoreFl64(out + i + 4, _mm_unpackhi_epi16(zero, v), gain);
+    }
+    S16toFl64C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S32toU8SSE2(void *dst, const void *src, size_t count)
+{
+    const int32_t *in = src;
+    uint8_t *out = dst;
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = RoundS32(CVT_LOAD(in + i), 24);
+        __m128i b = RoundS32(CVT_LOAD(in + i + 4), 24);
+        __m128i c = RoundS32(CVT_LOAD(in + i + 8), 24);
+        __m128i d = RoundS32(CVT_LOAD(in + i + 12), 24);
+        CVT_STORE(out + i, U8Pack(a, b, c, d));
+    }
+    S32toU8C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S32toS16SSE2(void *dst, const void *src, size_t count)
+{
+    const int32_t *in = src;
+    int16_t *out = dst;
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = RoundS32(CVT_LOAD(in + i), 16);
+        __m128i b = RoundS32(CVT_LOAD(in + i + 4), 16);
+        CVT_STORE(out + i, _mm_packs_epi32(a, b));
+    }
+    S32toS16C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S32toFl32SSE2(void *dst, const void *src, size_t count)
+{
+    const int32_t *in = src;
+    float *out = dst;
+    const __m128 gain = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(CVT_LOAD(in + i)),
+                                          gain));
+    S32toFl32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void S32toFl64SSE2(void *dst, const void *src, size_t count)
+{
+    const int32_t *in = src;
+    double *out = dst;
+    const __m128d gain = _mm_set1_pd(1. / 2147483648.);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        StoreFl64(out + i, CVT_LOAD(in + i), gain);
+    S32toFl64C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl32toU8SSE2(void *dst, const void *src, size_t count)
+{
+    const float *in = src;
+    uint8_t *out = dst;
+    const __m128 gain = _mm_set1_ps(128.f);
+    const __m128 lo = _mm_set1_ps(-128.f), hi = _mm_set1_ps(127.f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = Fl32ToInt(_mm_loadu_ps(in + i), gain, lo, hi);
+        __m128i b = Fl32ToInt(_mm_loadu_ps(in + i + 4), gain, lo, hi);
+        __m128i c = Fl32ToInt(_mm_loadu_ps(in + i + 8), gain, lo, hi);
+        __m128i d = Fl32ToInt(_mm_loadu_ps(in + i + 12), gain, lo, hi);
+        CVT_STORE(out + i, U8Pack(a, b, c, d));
+    }
+    Fl32toU8C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl32toS16SSE2(void *dst, const void *src, size_t count)
+{
+    const float *in = src;
+    int16_t *out = dst;
+    const __m128 gain = _mm_set1_ps(32768.f);
+    const __m128 lo = _mm_set1_ps(-32768.f), hi = _mm_set1_ps(32767.f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = Fl32ToInt(_mm_loadu_ps(in + i), gain, lo, hi);
+        __m128i b = Fl32ToInt(_mm_loadu_ps(in + i + 4), gain, lo, hi);
+        CVT_STORE(out + i, _mm_packs_epi32(a, b));
+    }
+    Fl32toS16C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl32toS32SSE2(void *dst, const void *src, size_t count)
+{
+    const float *in = src;
+    int32_t *out = dst;
+    const __m128 gain = _mm_set1_ps(2147483648.f);
+    const __m128 lo = _mm_set1_ps(-2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        /* cvtps2dq gives INT32_MIN from 2^31 and above: flip it to
+         * INT32_MAX */
+        __m128 v = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), gain), lo);
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(v, gain));
+        CVT_STORE(out + i, _mm_xor_si128(_mm_cvtps_epi32(v), over));
+    }
+    Fl32toS32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl32toFl64SSE2(void *dst, const void *src, size_t count)
+{
+    const float *in = src;
+    double *out = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(in + i);
+        _mm_storeu_pd(out + i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    Fl32toFl64C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl64toU8SSE2(void *dst, const void *src, size_t count)
+{
+    const double *in = src;
+    uint8_t *out = dst;
+    const __m128d gain = _mm_set1_pd(128.);
+    const __m128d lo = _mm_set1_pd(-128.), hi = _mm_set1_pd(127.);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = Fl64ToInt(in + i, gain, lo, hi);
+        __m128i b = Fl64ToInt(in + i + 4, gain, lo, hi);
+        __m128i c = Fl64ToInt(in + i + 8, gain, lo, hi);
+        __m128i d = Fl64ToInt(in + i + 12, gain, lo, hi);
+        CVT_STORE(out + i, U8Pack(a, b, c, d));
+    }
+    Fl64toU8C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl64toS16SSE2(void *dst, const void *src, size_t count)
+{
+    const double *in = src;
+    int16_t *out = dst;
+    const __m128d gain = _mm_set1_pd(32768.);
+    const __m128d lo = _mm_set1_pd(-32768.), hi = _mm_set1_pd(32767.);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = Fl64ToInt(in + i, gain, lo, hi);
+        __m128i b = Fl64ToInt(in + i + 4, gain, lo, hi);
+        CVT_STORE(out + i, _mm_packs_epi32(a, b));
+    }
+    Fl64toS16C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl64toS32SSE2(void *dst, const void *src, size_t count)
+{
+    const double *in = src;
+    int32_t *out = dst;
+    const __m128d gain = _mm_set1_pd(2147483648.);
+    const __m128d lo = _mm_set1_pd(-2147483648.);
+    const __m128d hi = _mm_set1_pd(2147483647.);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        CVT_STORE(out + i, Fl64ToInt(in + i, gain, lo, hi));
+    Fl64toS32C(out + i, in + i, count - i);
+}
+
+static DSP_SSE2 void Fl64toFl32SSE2(void *dst, const void *src, size_t count)
+{
+    const double *in = src;
+    float *out = dst;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+        __m128 b = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(a, b));
+    }
+    Fl64toFl32C(out + i, in + i, count - i);
+}
+
+static const dsp_convert_t cvtSSE2[CVT_FORMATS][CVT_FORMATS] = {
+    { Copy1, U8toS16SSE2, U8toS32SSE2, U8toFl32SSE2, U8toFl64SSE2 },
+    { S16toU8SSE2, Copy2, S16toS32SSE2, S16toFl32SSE2, S16toFl64SSE2 },
+    { S32toU8SSE2, S32toS16SSE2, Copy4, S32toFl32SSE2, S32toFl64SSE2 },
+    { Fl32toU8SSE2, Fl32toS16SSE2, Fl32toS32SSE2, Copy4, Fl32toFl64SSE2 },
+    { Fl64toU8SSE2, Fl64toS16SSE2, Fl64toS32SSE2, Fl64toFl32SSE2, Copy8 },
+};
+#endif
+
+dsp_convert_t dsp_GetConverter(vlc_fourcc_t dst_format,
+                               vlc_fourcc_t src_format)
+{
+    int src = FormatIndex(src_format), dst = FormatIndex(dst_format);
+
+    if (src < 0 || dst < 0)
+        return NULL;
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        return cvtSSE2[src][dst];
+#endif
+    return cvtC[src][dst];
+}
+
+#define CVT_CHUNK 256 /* frames converted at once, within the L1 cache */
+
+#define CVT_STRIDE(type, out_stride, in_stride) \
+    { \
+        type *out = dst; \
+        const type *in = src; \
+        for (unsigned i = 0; i < count; i++) \
+            out[i * out_stride] = in[i * in_stride]; \
+        break; \
+    }
+
+/* Copies count samples between a plane and a channel of interleaved ones */
+static void Scatter(void *dst, const void *src, size_t size, unsigned count,
+                    unsigned channels)
+{
+    switch (size)
+    {
+        case 1: CVT_STRIDE(uint8_t, channels, 1)
+        case 2: CVT_STRIDE(uint16_t, channels, 1)
+        case 4: CVT_STRIDE(uint32_t, channels, 1)
+        case 8: CVT_STRIDE(uint64_t, channels, 1)
+        default: vlc_assert_unreachable();
+    }
+}
+
+static void Gather(void *dst, const void *src, size_t size, unsigned count,
+                   unsigned channels)
+{
+    switch (size)
+    {
+        case 1: CVT_STRIDE(uint8_t, 1, channels)
+        case 2: CVT_STRIDE(uint16_t, 1, channels)
+        case 4: CVT_STRIDE(uint32_t, 1, channels)
+        case 8: CVT_STRIDE(uint64_t, 1, channels)
+        default: vlc_assert_unreachable();
+    }
+}
+
+void dsp_InterleaveConvert(void *dst, vlc_fourcc_t dst_format,
+                           const void *const *planes,
+                           vlc_fourcc_t src_format, unsigned frames,
+                           unsigned channels)
+{
+    const dsp_convert_t convert = dsp_GetConverter(dst_format, src_format);
+    assert(convert != NULL);
+
+    const size_t src_size = format_sizes[FormatIndex(src_format)];
+    const size_t dst_size = format_sizes[FormatIndex(dst_format)];
+    double buf[CVT_CHUNK];
+
+    for (unsigned offset = 0; offset < frames; offset += CVT_CHUNK)
+    {
+        const unsigned count = __MIN(frames - offset, CVT_CHUNK);
+        uint8_t *out = (uint8_t *)dst + (size_t)offset * channels * dst_size;
+
+        for (unsigned c = 0; c < channels; c++)
+        {
+            const void *in = (const uint8_t *)planes[c] + offset * src_size;
+
+            if (src_format != dst_format)
+            {
+                convert(buf, in, count);
+                in = buf;
+            }
+            Scatter(out + c * dst_size, in, dst_size, count, channels);
+        }
+    }
+}
+
+void dsp_DeinterleaveConvert(void *const *planes, vlc_fourcc_t dst_format,
+                             const void *src, vlc_fourcc_t src_format,
+                             unsigned frames, unsigned channels)
+{
+    const dsp_convert_t convert = dsp_GetConverter(dst_format, src_format);
+    assert(convert != NULL);
+
+    const size_t src_size = format_sizes[FormatIndex(src_format)];
+    const size_t dst_size = format_sizes[FormatIndex(dst_format)];
+    double buf[CVT_CHUNK];
+
+    for (unsigned offset = 0; offset < frames; offset += CVT_CHUNK)
+    {
+        const unsigned count = __MIN(frames - offset, CVT_CHUNK);
+        const uint8_t *in = (const uint8_t *)src
+                          + (size_t)offset * channels * src_size;
+
+        for (unsigned c = 0; c < channels; c++)
+        {
+            void *out = (uint8_t *)planes[c] + offset * dst_size;
+
+            if (src_format == dst_format)
+                Gather(out, in + c * src_size, src_size, count, channels);
+            else
+            {
+                Gather(buf, in + c * src_size, src_size, count, channels);
+                convert(out, buf, count);
+            }
+        }
+    }
+}
+
+#ifdef DSP_TEST
+/* Checks every vector version against the C one */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FRAMES 1001 /* not a multiple of any vector size */
+
+static void Fill(float *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] = (float)rand() / RAND_MAX * 2.f - 1.f;
+}
+
+static void Check(const char *name, const float *ref, const float *buf,
+                  size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        if (!(fabsf(buf[i] - ref[i]) <= 1e-4f * (1.f + fabsf(ref[i]))))
+        {
+            fprintf(stderr, "%s: %f instead of %f at %zu\n", name, buf[i],
+                    ref[i], i);
+            abort();
+        }
+}
+
+/* Checks a dot product against the sequential sum of the scalar loop. They
+ * round differently, but each is within count * epsilon times the sum of the
+ * absolute products from the exact value. */
+static void CheckDot(const char *isa, const float *a, const float *b,
+                     size_t count, float dot)
+{
+    float ref = 0.f, bound = 0.f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ref += a[i] * b[i];
+        bound += fabsf(a[i] * b[i]);
+    }
+    bound *= 2 * count * FLT_EPSILON;
+
+    if (!(fabsf(dot - ref) <= bound))
+    {
+        fprintf(stderr, "%s Dot: %f instead of %f for %zu\n", isa, dot, ref,
+                count);
+        abort();
+    }
+}
+
+static void Test(const char *isa, const struct dsp_ops *ops)
+{
+    static float in[TEST_FRAMES * 9 + 64];
+    static float ref[TEST_FRAMES * 9], out[TEST_FRAMES * 9];
+    static float taps[31];
+    static const unsigned channels_list[] = { 1, 2, 3, 6, 8, 9 };
+
+    printf("%s...\n", isa);
+    Fill(in, ARRAY_SIZE(in));
+    Fill(taps, ARRAY_SIZE(taps));
+
+    for (size_t i = 0; i < ARRAY_SIZE(channels_list); i++)
+    {
+        const unsigned channels = channels_list[i];
+        const size_t count = TEST_FRAMES * channels;
+        float gains[9], ref_frames[TEST_FRAMES], frames[TEST_FRAMES];
+
+        Fill(gains, channels);
+
+        memcpy(ref, in, count * sizeof (float));
+        memcpy(out, in, count * sizeof (float));
+        opsC.scale(ref, .7f, count);
+        ops->scale(out, .7f, count);
+        Check("Scale", ref, out, count);
+
+        opsC.mix_add(ref, in + 1, -.3f, count);
+        ops->mix_add(out, in + 1, -.3f, count);
+        Check("MixAdd", ref, out, count);
+
+        opsC.lerp(ref, ref, in + 2, .4f, count);
+        ops->lerp(out, out, in + 2, .4f, count);
+        Check("Lerp", ref, out, count);
+
+        opsC.scale_channels(ref, gains, TEST_FRAMES, channels);
+        ops->scale_channels(out, gains, TEST_FRAMES, channels);
+        Check("ScaleChannels", ref, out, count);
+
+        opsC.scale_frames(ref, in + 3, TEST_FRAMES, channels);
+        ops->scale_frames(out, in + 3, TEST_FRAMES, channels);
+        Check("ScaleFrames", ref, out, count);
+
+        float ref_energy[9] = { 0.f }, energy[9] = { 0.f };
+        opsC.channel_energy(in, TEST_FRAMES, channels, ref_energy);
+        ops->channel_energy(in, TEST_FRAMES, channels, energy);
+        Check("ChannelEnergy", ref_energy, energy, channels);
+
+        opsC.frame_peak(in, TEST_FRAMES, channels, ref_frames);
+        ops->frame_peak(in, TEST_FRAMES, channels, frames);
+        Check("FramePeak", ref_frames, frames, TEST_FRAMES);
+
+        /* Low and high shelves, and a peak */
+        static const dsp_biquad_t coeffs[3] = {
+            { 1.0207f, -1.9598f, 0.9419f, -1.9601f, 0.9623f },
+            { 1.4464f, -2.0512f, 0.7545f, -1.2099f, 0.3597f },
+            { 1.0125f, -1.8893f, 0.9160f, -1.8893f, 0.9285f },
+        };
+        float ref_state[DSP_BIQUAD_STATE_SIZE(3, 9)] = { 0.f };
+        float state[DSP_BIQUAD_STATE_SIZE(3, 9)] = { 0.f };
+        memcpy(ref, in, count * sizeof (float));
+        memcpy(out, in, count * sizeof (float));
+        for (unsigned j = 0; j < 3; j++) /* check the state continuity */
+        {
+            const unsigned offset = j * 300 * channels;
+            opsC.biquad_cascade(ref + offset, j < 2 ? 300 : TEST_FRAMES - 600,
+                                channels, coeffs, 3, ref_state);
+            ops->biquad_cascade(out + offset, j < 2 ? 300 : TEST_FRAMES - 600,
+                                channels, coeffs, 3, state);
+        }
+        Check("BiquadCascade", ref, out, count);
+
+        dsp_resonators_t bank;
+        memset(&bank, 0, sizeof (bank));
+        bank.count = 10;
+        for (unsigned j = 0; j < bank.count; j++)
+        {
+            bank.alpha[j] = .003f * (j + 1);
+            bank.beta[j] = .99f - .05f * j;
+            bank.gamma[j] = 1.98f - .1f * j;
+            bank.gain[j] = gains[j % channels];
+        }
+        dsp_resonators_state_t ref_res, res;
+        memset(&ref_res, 0, sizeof (ref_res));
+        memset(&res, 0, sizeof (res));
+        memcpy(ref, in, count * sizeof (float));
+        memcpy(out, in, count * sizeof (float));
+        for (unsigned c = 0; c < channels; c++)
+        {
+            opsC.resonators(&bank, &ref_res, ref + c, TEST_FRAMES, channels,
+                            .25f);
+            ops->resonators(&bank, &res, out + c, TEST_FRAMES, channels,
+                            .25f);
+        }
+        Check("Resonators", ref, out, count);
+    }
+
+    /* Comb and all-pass filters, with spans across the end of the lines */
+    float ref_line[331] = { 0.f }, line[331] = { 0.f };
+    dsp_delay_t ref_delay = { ref_line, 331, 0 }, delay = { line, 331, 0 };
+    memset(ref, 0, TEST_FRAMES * sizeof (float));
+    memset(out, 0, TEST_FRAMES * sizeof (float));
+    for (unsigned offset = 0; offset < TEST_FRAMES; offset += 250)
+    {
+        const unsigned n = __MIN(250, TEST_FRAMES - offset);
+        opsC.comb(&ref_delay, .84f, .8f, in + offset, ref + offset, n);
+        ops->comb(&delay, .84f, .8f, in + offset, out + offset, n);
+    }
+    Check("Comb", ref, out, TEST_FRAMES);
+    Check("Comb line", ref_line, line, 331);
+
+    ref_delay.size = delay.size = 225;
+    ref_delay.pos = delay.pos = 0;
+    for (unsigned offset = 0; offset < TEST_FRAMES; offset += 250)
+    {
+        const unsigned n = __MIN(250, TEST_FRAMES - offset);
+        opsC.allpass(&ref_delay, .5f, ref + offset, n);
+        ops->allpass(&delay, .5f, out + offset, n);
+    }
+    Check("Allpass", ref, out, TEST_FRAMES);
+
+    opsC.fir(ref, in, taps, ARRAY_SIZE(taps), TEST_FRAMES);
+    ops->fir(out, in, taps, ARRAY_SIZE(taps), TEST_FRAMES);
+    Check("Fir", ref, out, TEST_FRAMES);
+
+    for (unsigned count = 0; count < 40; count++)
+    {
+        ref[count] = opsC.dot(in, in + 100, TEST_FRAMES - count);
+        out[count] = ops->dot(in, in + 100, TEST_FRAMES - count);
+    }
+    Check("Dot", ref, out, 40);
+
+    /* The overlap search of scaletempo used to sum sequentially */
+    for (unsigned count = 1; count <= TEST_FRAMES; count = 2 * count + 1)
+        CheckDot(isa, in + 3, in + 200, count,
+                 ops->dot(in + 3, in + 200, count));
+
+    const float *planes[] = { in, in + 7, in + 300, in + 11, in + 500 };
+    opsC.dot_planes(ref, planes, ARRAY_SIZE(planes), 3, in + 50, 37);
+    ops->dot_planes(out, planes, ARRAY_SIZE(planes), 3, in + 50, 37);
+    Check("DotPlanes", ref, out, ARRAY_SIZE(planes));
+}
+
+/* Compares the FFT with the DFT, and checks the inverse */
+static void TestFFT(void)
+{
+    enum { N = 64 };
+    float re[N], im[N], ref_re[N], ref_im[N], in_re[N], in_im[N];
+
+    printf("FFT...\n");
+    Fill(in_re, N);
+    Fill(in_im, N);
+
+    for (unsigned k = 0; k < N; k++)
+    {
+        double sum_re = 0., sum_im = 0.;
+
+        for (unsigned n = 0; n < N; n++)
+        {
+            double phase = -2. * M_PI * k * n / N;
+
+            sum_re += in_re[n] * cos(phase) - in_im[n] * sin(phase);
+            sum_im += in_re[n] * sin(phase) + in_im[n] * cos(phase);
+        }
+        ref_re[k] = sum_re;
+        ref_im[k] = sum_im;
+    }
+
+    dsp_fft_t *fft = dsp_FFTNew(N);
+    assert(fft != NULL);
+    assert(dsp_FFTSize(fft) == N);
+    memcpy(re, in_re, sizeof (re));
+    memcpy(im, in_im, sizeof (im));
+    dsp_FFT(fft, re, im, false);
+    Check("FFT", ref_re, re, N);
+    Check("FFT", ref_im, im, N);
+
+    dsp_FFT(fft, re, im, true);
+    for (unsigned n = 0; n < N; n++)
+    {
+        re[n] /= N;
+        im[n] /= N;
+    }
+    Check("IFFT", in_re, re, N);
+    Check("IFFT", in_im, im, N);
+    dsp_FFTDelete(fft);
+}
+
+static const vlc_fourcc_t cvt_formats[CVT_FORMATS] = {
+    VLC_CODEC_U8, VLC_CODEC_S16N, VLC_CODEC_S32N, VLC_CODEC_FL32,
+    VLC_CODEC_FL64,
+};
+
+/* Fills random samples, starting with the clipping and rounding edges */
+static void FillSamples(void *buf, int format, size_t count)
+{
+    static const float floats[] = {
+        1.f, -1.f, 1.5f, -1.5f, INFINITY, -INFINITY, NAN, 0.f, -0.f,
+        .5f / 32768.f, 1.5f / 32768.f, -.5f / 32768.f, .5f / 128.f,
+        -1.5f / 128.f, 127.5f / 128.f, 32767.5f / 32768.f,
+    };
+    static const int32_t ints[] = {
+        INT32_MAX, INT32_MIN, 0x7fff8000, 0x00008000, -0x8000, 0x00018000,
+        0x7f800000, 0x00800000, -0x00800000, 0x01800000,
+    };
+    static const int16_t shorts[] = {
+        INT16_MAX, INT16_MIN, 0x7f80, 0x80, -0x80, 0x180, 0x7f7f,
+    };
+    uint8_t *p = buf;
+
+    for (size_t i = 0; i < count * format_sizes[format]; i++)
+        p[i] = rand();
+    for (size_t i = 0; i < count; i++)
+        switch (format)
+        {
+            case CVT_FL32:
+                ((float *)buf)[i] = i < ARRAY_SIZE(floats) ? floats[i]
+                                  : (float)rand() / RAND_MAX * 2.5f - 1.25f;
+                break;
+            case CVT_FL64:
+                ((double *)buf)[i] = i < ARRAY_SIZE(floats) ? floats[i]
+                                   : (double)rand() / RAND_MAX * 2.5 - 1.25;
+                break;
+            case CVT_S32:
+                if (i < ARRAY_SIZE(ints))
+                    ((int32_t *)buf)[i] = ints[i];
+                break;
+            case CVT_S16:
+                if (i < ARRAY_SIZE(shorts))
+                    ((int16_t *)buf)[i] = shorts[i];
+                break;
+        }
+}
+
+static void CheckSamples(const char *isa, int src, int dst, const void *ref,
+                         const void *buf, size_t count)
+{
+    if (memcmp(ref, buf, count * format_sizes[dst]))
+    {
+        fprintf(stderr, "%s %4.4s->%4.4s conversion mismatch\n", isa,
+                (const char *)&cvt_formats[src],
+                (const char *)&cvt_formats[dst]);
+        abort();
+    }
+}
+
+/* Checks the conversions of some values, the lossless round trips, and
+ * every vector version against the C one, in place when possible */
+static void TestConvert(const char *isa,
+                        const dsp_convert_t (*cvt)[CVT_FORMATS])
+{
+    double in[TEST_FRAMES], ref[TEST_FRAMES], out[TEST_FRAMES];
+
+    printf("%s conversions...\n", isa);
+    for (int src = 0; src < CVT_FORMATS; src++)
+        for (int dst = 0; dst < CVT_FORMATS; dst++)
+        {
+            FillSamples(in, src, TEST_FRAMES);
+            cvtC[src][dst](ref, in, TEST_FRAMES);
+            cvt[src][dst](out, in, TEST_FRAMES);
+            CheckSamples(isa, src, dst, ref, out, TEST_FRAMES);
+
+            if (format_sizes[dst] <= format_sizes[src])
+            {
+                memcpy(out, in, TEST_FRAMES * format_sizes[src]);
+                cvt[src][dst](out, out, TEST_FRAMES);
+                CheckSamples(isa, src, dst, ref, out, TEST_FRAMES);
+            }
+        }
+
+    /* Clipping and rounding */
+    const float f32[] = { 1.f, -1.f, 1.5f, 1.5f / 32768.f, 2.5f / 32768.f };
+    int16_t s16[ARRAY_SIZE(f32)];
+    cvt[CVT_FL32][CVT_S16](s16, f32, ARRAY_SIZE(f32));
+    assert(s16[0] == INT16_MAX && s16[1] == INT16_MIN
+        && s16[2] == INT16_MAX && s16[3] == 2 && s16[4] == 2);
+
+    int32_t s32[ARRAY_SIZE(f32)];
+    cvt[CVT_FL32][CVT_S32](s32, f32, ARRAY_SIZE(f32));
+    assert(s32[0] == INT32_MAX && s32[1] == INT32_MIN
+        && s32[2] == INT32_MAX && s32[3] == 0x18000);
+
+    const int32_t s32_in[] = { INT32_MAX, INT32_MIN, 0x8000, -0x8000 };
+    cvt[CVT_S32][CVT_S16](s16, s32_in, ARRAY_SIZE(s32_in));
+    assert(s16[0] == INT16_MAX && s16[1] == INT16_MIN
+        && s16[2] == 1 && s16[3] == 0);
+
+    uint8_t u8[4];
+    cvt[CVT_S32][CVT_U8](u8, s32_in, ARRAY_SIZE(s32_in));
+    assert(u8[0] == 255 && u8[1] == 0 && u8[2] == 128 && u8[3] == 128);
+
+    /* Lossless round trips */
+    static int16_t s16_all[65536], s16_back[65536];
+    static float f32_all[65536];
+    for (unsigned i = 0; i < 65536; i++)
+        s16_all[i] = i - 32768;
+    cvt[CVT_S16][CVT_FL32](f32_all, s16_all, 65536);
+    cvt[CVT_FL32][CVT_S16](s16_back, f32_all, 65536);
+    assert(!memcmp(s16_all, s16_back, sizeof (s16_all)));
+    cvt[CVT_S16][CVT_FL64](in, s16_all, TEST_FRAMES);
+    cvt[CVT_FL64][CVT_S16](s16_back, in, TEST_FRAMES);
+    assert(!memcmp(s16_all, s16_back, TEST_FRAMES * sizeof (int16_t)));
+    cvt[CVT_S16][CVT_S32](f32_all, s16_all, 65536);
+    cvt[CVT_S32][CVT_S16](s16_back, f32_all, 65536);
+    assert(!memcmp(s16_all, s16_back, sizeof (s16_all)));
+
+    for (unsigned i = 0; i < 256; i++)
+        ((uint8_t *)in)[i] = i;
+    for (int fmt = CVT_S16; fmt < CVT_FORMATS; fmt++)
+    {
+        cvt[CVT_U8][fmt](ref, in, 256);
+        cvt[fmt][CVT_U8](out, ref, 256);
+        assert(!memcmp(in, out, 256));
+    }
+}
+
+/* Interleaves S16 planes to FL32, and back */
+static void TestPlanes(void)
+{
+    enum { CHANNELS = 3, FRAMES = 600 /* more than a chunk */ };
+    int16_t planes[CHANNELS][FRAMES], back[CHANNELS][FRAMES];
+    float interleaved[CHANNELS * FRAMES];
+    const void *in[CHANNELS];
+    void *out[CHANNELS];
+
+    printf("Planar conversions...\n");
+    for (unsigned c = 0; c < CHANNELS; c++)
+    {
+        for (unsigned i = 0; i < FRAMES; i++)
+            planes[c][i] = rand();
+        in[c] = planes[c];
+        out[c] = back[c];
+    }
+
+    dsp_InterleaveConvert(interleaved, VLC_CODEC_FL32, in, VLC_CODEC_S16N,
+                          FRAMES, CHANNELS);
+    for (unsigned c = 0; c < CHANNELS; c++)
+        for (unsigned i = 0; i < FRAMES; i++)
+            assert(interleaved[i * CHANNELS + c] == planes[c][i] / 32768.f);
+
+    dsp_DeinterleaveConvert(out, VLC_CODEC_S16N, interleaved, VLC_CODEC_FL32,
+                            FRAMES, CHANNELS);
+    assert(!memcmp(planes, back, sizeof (planes)));
+
+    memset(back, 0, sizeof (back));
+    dsp_InterleaveConvert(interleaved, VLC_CODEC_S16N, in, VLC_CODEC_S16N,
+                          FRAMES, CHANNELS);
+    dsp_DeinterleaveConvert(out, VLC_CODEC_S16N, interleaved, VLC_CODEC_S16N,
+                            FRAMES, CHANNELS);
+    assert(!memcmp(planes, back, sizeof (planes)));
+}
+
+/* Prints the throughput of each conversion:
+ * $ ./audio_dsp_test bench */
+static void BenchConvert(void)
+{
+    enum { SAMPLES = 4096, LOOPS = 20000 };
+    double *in = malloc(SAMPLES * sizeof (double));
+    double *out = malloc(SAMPLES * sizeof (double));
+    const struct
+    {
+        const char *isa;
+        const dsp_convert_t (*cvt)[CVT_FORMATS];
+    } versions[] = {
+        { "C", cvtC },
+#ifdef HAVE_SSE2_INTRINSICS
+        { "SSE2", vlc_CPU_SSE2() ? cvtSSE2 : NULL },
+#endif
+    };
+
+    assert(in != NULL && out != NULL);
+    for (int src = 0; src < CVT_FORMATS; src++)
+    {
+        FillSamples(in, src, SAMPLES);
+
+        for (int dst = 0; dst < CVT_FORMATS; dst++)
+        {
+            if (src == dst)
+                continue;
+
+            printf("%4.4s->%4.4s", (const char *)&cvt_formats[src],
+                   (const char *)&cvt_formats[dst]);
+            for (size_t v = 0; v < ARRAY_SIZE(versions); v++)
+            {
+                if (versions[v].cvt == NULL)
+                    continue;
+
+                const dsp_convert_t convert = versions[v].cvt[src][dst];
+                mtime_t start = mdate();
+
+                for (unsigned j = 0; j < LOOPS; j++)
+                    convert(out, in, SAMPLES);
+
+                mtime_t elapsed = __MAX(mdate() - start, 1);
+                printf(" %5s %8.1f Msamples/s", versions[v].isa,
+                       (double)SAMPLES * LOOPS / elapsed);
+            }
+            putchar('\n');
+        }
+    }
+    free(in);
+    free(out);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && !strcmp(argv[1], "bench"))
+    {
+        BenchConvert();
+        return 0;
+    }
+
+    srand(0);
+    TestFFT();
+    TestPlanes();
+    TestConvert("C", cvtC);
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        TestConvert("SSE2", cvtSSE2);
+#endif
+    Test("C", &opsC);
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE())
+        Test("SSE", &opsSSE);
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX())
+        Test("AVX", &opsAVX);
+#endif
+#ifdef DSP_NEON
+    if (vlc_CPU_ARM_NEON())
+        Test("NEON", &opsNEON);
+#endif
+    return 0;
+}
+#endif /* DSP_TEST */
@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * dsp.h: vectorized DSP helpers for the audio filters
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_FILTER_DSP_H
+#define VLC_AUDIO_FILTER_DSP_H 1
+
+/* All the helpers work on FL32 samples, see dsp_convert.h for the sample
+ * format conversions. They use the widest of AVX, SSE or NEON supported by
+ * the CPU, and plain C otherwise. Buffers need no particular alignment.
+ * Interleaved buffers have at most DSP_CHANNELS_MAX channels. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DSP_CHANNELS_MAX INPUT_CHAN_MAX
+
+/* buf[i] *= gain */
+void dsp_Scale(float *buf, float gain, size_t count);
+
+/* dst[i] += src[i] * gain */
+void dsp_MixAdd(float *dst, const float *src, float gain, size_t count);
+
+/* out[i] = a[i] + (b[i] - a[i]) * alpha, out may be a */
+void dsp_Lerp(float *out, const float *a, const float *b, float alpha,
+              size_t count);
+
+/* Multiplies each channel of an interleaved buffer by gains[channel] */
+void dsp_ScaleChannels(float *buf, const float *gains, unsigned frames,
+                       unsigned channels);
+
+/* Multiplies each frame of an interleaved buffer by gains[frame] */
+void dsp_ScaleFrames(float *buf, const float *gains, unsigned frames,
+                     unsigned channels);
+
+/* Adds the sum of the squared samples of each channel of an interleaved
+ * buffer to energy[channel] */
+void dsp_ChannelEnergy(const float *buf, unsigned frames, unsigned channels,
+                       float *energy);
+
+/* Stores the largest absolute sample of each frame of an interleaved buffer
+ * to peaks[frame] */
+void dsp_FramePeak(const float *buf, unsigned frames, unsigned channels,
+                   float *peaks);
+
+/* FIR filter: out[i] = sum(in[i + k] * taps[k]) for k < taps_count.
+ * The input holds count + taps_count - 1 samples. */
+void dsp_Fir(float *out, const float *in, const float *taps,
+             unsigned taps_count, size_t count);
+
+/* Dot product of a and b */
+float dsp_Dot(const float *a, const float *b, size_t count);
+
+/* out[i] = dsp_Dot(planes[i] + offset, b, count) for each of the channels */
+void dsp_DotPlanes(float *out, const float *const *planes, unsigned channels,
+                   size_t offset, const float *b, size_t count);
+
+/**
+ * Biquad coefficients, normalized by a0
+ */
+typedef struct
+{
+    float b0, b1, b2, a1, a2;
+} dsp_biquad_t;
+
+/* Number of floats of the state of a biquad cascade */
+#define DSP_BIQUAD_STATE_SIZE(stages, channels) (4 * (stages) * (channels))
+
+/* Filters each channel of an interleaved buffer in place through a cascade
+ * of biquads in direct form I. The state must be zeroed initially. */
+void dsp_BiquadCascade(float *buf, unsigned frames, unsigned channels,
+                       const dsp_biquad_t *coeffs, unsigned stages,
+                       float *state);
+
+#define DSP_RESONATORS_MAX 16
+
+/**
+ * Bank of parallel second order resonators:
+ * y_j[n] = alpha_j (x[n] - x[n-2]) + gamma_j y_j[n-1] - beta_j y_j[n-2]
+ *
+ * The unused entries must be zeroes.
+ */
+typedef struct
+{
+    unsigned count;
+    float alpha[DSP_RESONATORS_MAX];
+    float beta[DSP_RESONATORS_MAX];
+    float gamma[DSP_RESONATORS_MAX];
+    float gain[DSP_RESONATORS_MAX];
+} dsp_resonators_t;
+
+/**
+ * State of a resonators bank for one channel, zeroed initially
+ */
+typedef struct
+{
+    float x1, x2;
+    float y1[DSP_RESONATORS_MAX];
+    float y2[DSP_RESONATORS_MAX];
+} dsp_resonators_state_t;
+
+/* Replaces each sample x of one channel (stride floats apart) by
+ * dry * x + sum(gain_j * y_j) */
+void dsp_Resonators(const dsp_resonators_t *bank,
+                    dsp_resonators_state_t *state, float *buf,
+                    unsigned frames, unsigned stride, float dry);
+
+/**
+ * Circular delay line
+ */
+typedef struct
+{
+    float *buffer;
+    unsigned size;
+    unsigned pos;
+} dsp_delay_t;
+
+/* Feedback comb filter, accumulated to acc: y = flush(line[pos]),
+ * line[pos] = in + flush(y * damp) * feedback, acc += y
+ * where flush() replaces denormals by zeroes */
+void dsp_Comb(dsp_delay_t *line, float feedback, float damp,
+              const float *in, float *acc, unsigned count);
+
+/* All-pass filter in place: y = flush(line[pos]),
+ * line[pos] = x + y * feedback, x = y - x */
+void dsp_Allpass(dsp_delay_t *line, float feedback, float *buf,
+                 unsigned count);
+
+/**
+ * Complex FFT of a power of 2 size
+ */
+typedef struct dsp_fft dsp_fft_t;
+
+dsp_fft_t *dsp_FFTNew(unsigned size);
+void dsp_FFTDelete(dsp_fft_t *fft);
+unsigned dsp_FFTSize(const dsp_fft_t *fft);
+
+/* In place transform of the real and imaginary parts, of size floats each.
+ * The inverse transform is not normalized by 1 / size. */
+void dsp_FFT(const dsp_fft_t *fft, float *re, float *im, bool inverse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
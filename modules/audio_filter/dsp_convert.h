@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * dsp_convert.h: vectorized sample format conversions
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_FILTER_DSP_CONVERT_H
+#define VLC_AUDIO_FILTER_DSP_CONVERT_H 1
+
+/* Unlike dsp.h, this header depends on the VLC types. It is part of the same
+ * library. */
+
+#include <vlc_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Conversion of count samples between the U8, S16N, S32N, FL32 and FL64
+ * formats. Float samples are scaled, clipped to the integer range and
+ * rounded to the nearest, ties to even. Integer samples are rounded, ties
+ * up, and saturated when narrowed. The conversion works in place if the
+ * destination samples are not larger than the source ones. Otherwise the
+ * buffers must not overlap.
+ */
+typedef void (*dsp_convert_t)(void *dst, const void *src, size_t count);
+
+/* Returns the conversion between the formats, a copy if they are the same,
+ * or NULL if either is not supported. The vectorized version uses SSE2. */
+dsp_convert_t dsp_GetConverter(vlc_fourcc_t dst_format,
+                               vlc_fourcc_t src_format);
+
+/* Converts and interleaves the frames samples of each of the planes */
+void dsp_InterleaveConvert(void *dst, vlc_fourcc_t dst_format,
+                           const void *const *planes,
+                           vlc_fourcc_t src_format, unsigned frames,
+                           unsigned channels);
+
+/* Converts and deinterleaves frames of interleaved samples to the planes */
+void dsp_DeinterleaveConvert(void *const *planes, vlc_fourcc_t dst_format,
+                             const void *src, vlc_fourcc_t src_format,
+                             unsigned frames, unsigned channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,459 @@
+/*****************************************************************************
+ * dsp_template.h: DSP helpers for one vector instruction set
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included by dsp.c once per instruction set, with:
+ *  - vec_t: the vector type, of VLANES floats,
+ *  - VATTR: the attributes of the functions (target instruction set),
+ *  - FN(name): the name of a function for this instruction set,
+ *  - vload(p), vstore(p, v): unaligned load and store,
+ *  - vset1(f), vadd(a, b), vsub(a, b), vmul(a, b), vmax(a, b), vabs(v),
+ *  - vflush(v): replaces the denormals by zeroes,
+ *  - vhsum(v), vhmax(v): sum and maximum of the lanes.
+ * The macros are undefined at the end of the file. */
+
+static inline VATTR vec_t FN(LoadPartial)(const float *p, unsigned n)
+{
+    float tmp[VLANES] = { 0.f };
+
+    for (unsigned i = 0; i < n; i++)
+        tmp[i] = p[i];
+    return vload(tmp);
+}
+
+static inline VATTR void FN(StorePartial)(float *p, vec_t v, unsigned n)
+{
+    float tmp[VLANES];
+
+    vstore(tmp, v);
+    for (unsigned i = 0; i < n; i++)
+        p[i] = tmp[i];
+}
+
+static VATTR void FN(Scale)(float *buf, float gain, size_t count)
+{
+    const vec_t g = vset1(gain);
+    size_t i = 0;
+
+    for (; i + VLANES <= count; i += VLANES)
+        vstore(buf + i, vmul(vload(buf + i), g));
+    for (; i < count; i++)
+        buf[i] *= gain;
+}
+
+static VATTR void FN(MixAdd)(float *restrict dst, const float *restrict src,
+                             float gain, size_t count)
+{
+    const vec_t g = vset1(gain);
+    size_t i = 0;
+
+    for (; i + VLANES <= count; i += VLANES)
+        vstore(dst + i, vadd(vload(dst + i), vmul(vload(src + i), g)));
+    for (; i < count; i++)
+        dst[i] += src[i] * gain;
+}
+
+static VATTR void FN(Lerp)(float *out, const float *a,
+                           const float *b, float alpha, size_t count)
+{
+    const vec_t t = vset1(alpha);
+    size_t i = 0;
+
+    for (; i + VLANES <= count; i += VLANES)
+    {
+        vec_t va = vload(a + i);
+
+        vstore(out + i, vadd(va, vmul(vsub(vload(b + i), va), t)));
+    }
+    for (; i < count; i++)
+        out[i] = a[i] + (b[i] - a[i]) * alpha;
+}
+
+static VATTR void FN(ScaleChannels)(float *buf, const float *gains,
+                                    unsigned frames, unsigned channels)
+{
+    /* VLANES frames are channels vectors, each with a fixed gains pattern */
+    float pattern[DSP_CHANNELS_MAX * VLANES];
+    unsigned f = 0;
+
+    for (unsigned i = 0; i < channels * VLANES; i++)
+        pattern[i] = gains[i % channels];
+
+    for (; f + VLANES <= frames; f += VLANES)
+        for (unsigned j = 0; j < channels; j++)
+        {
+            vstore(buf, vmul(vload(buf), vload(pattern + j * VLANES)));
+            buf += VLANES;
+        }
+
+    for (; f < frames; f++)
+        for (unsigned c = 0; c < channels; c++)
+            *(buf++) *= gains[c];
+}
+
+static VATTR void FN(ScaleFrames)(float *buf, const float *gains,
+                                  unsigned frames, unsigned channels)
+{
+    unsigned f = 0;
+
+    if (VLANES % channels == 0)
+    {   /* Several whole frames per vector (mono, stereo...) */
+        const unsigned step = VLANES / channels;
+
+        for (; f + step <= frames; f += step)
+        {
+            float tmp[VLANES];
+
+            for (unsigned i = 0; i < VLANES; i++)
+                tmp[i] = gains[f + i / channels];
+            vstore(buf, vmul(vload(buf), vload(tmp)));
+            buf += VLANES;
+        }
+    }
+
+    for (; f < frames; f++)
+    {
+        const vec_t g = vset1(gains[f]);
+        unsigned c = 0;
+
+        for (; c + VLANES <= channels; c += VLANES)
+            vstore(buf + c, vmul(vload(buf + c), g));
+        for (; c < channels; c++)
+            buf[c] *= gains[f];
+        buf += channels;
+    }
+}
+
+static VATTR void FN(ChannelEnergy)(const float *buf, unsigned frames,
+                                    unsigned channels, float *energy)
+{
+    vec_t acc[DSP_CHANNELS_MAX];
+    float sums[DSP_CHANNELS_MAX * VLANES];
+    unsigned f = 0;
+
+    for (unsigned j = 0; j < channels; j++)
+        acc[j] = vset1(0.f);
+
+    for (; f + VLANES <= frames; f += VLANES)
+        for (unsigned j = 0; j < channels; j++)
+        {
+            const vec_t v = vload(buf);
+
+            acc[j] = vadd(acc[j], vmul(v, v));
+            buf += VLANES;
+        }
+
+    for (unsigned j = 0; j < channels; j++)
+        vstore(sums + j * VLANES, acc[j]);
+    for (unsigned i = 0; i < channels * VLANES; i++)
+        energy[i % channels] += sums[i];
+
+    for (; f < frames; f++)
+        for (unsigned c = 0; c < channels; c++)
+        {
+            energy[c] += buf[0] * buf[0];
+            buf++;
+        }
+}
+
+static VATTR void FN(FramePeak)(const float *buf, unsigned frames,
+                                unsigned channels, float *peaks)
+{
+    for (unsigned f = 0; f < frames; f++)
+    {
+        float peak = 0.f;
+        unsigned c = 0;
+
+        if (channels >= VLANES)
+        {
+            vec_t max = vabs(vload(buf));
+
+            for (c = VLANES; c + VLANES <= channels; c += VLANES)
+                max = vmax(max, vabs(vload(buf + c)));
+            peak = vhmax(max);
+        }
+        for (; c < channels; c++)
+            peak = fmaxf(peak, fabsf(buf[c]));
+
+        peaks[f] = peak;
+        buf += channels;
+    }
+}
+
+static VATTR void FN(Fir)(float *restrict out, const float *restrict in,
+                          const float *restrict taps, unsigned taps_count,
+                          size_t count)
+{
+    size_t i = 0;
+
+    /* Two vectors at once to hide the latency of the additions */
+    for (; i + 2 * VLANES <= count; i += 2 * VLANES)
+    {
+        vec_t acc0 = vset1(0.f), acc1 = vset1(0.f);
+
+        for (unsigned k = 0; k < taps_count; k++)
+        {
+            const vec_t t = vset1(taps[k]);
+
+            acc0 = vadd(acc0, vmul(vload(in + i + k), t));
+            acc1 = vadd(acc1, vmul(vload(in + i + VLANES + k), t));
+        }
+        vstore(out + i, acc0);
+        vstore(out + i + VLANES, acc1);
+    }
+
+    for (; i < count; i++)
+    {
+        float acc = 0.f;
+
+        for (unsigned k = 0; k < taps_count; k++)
+            acc += in[i + k] * taps[k];
+        out[i] = acc;
+    }
+}
+
+static VATTR float FN(Dot)(const float *a, const float *b, size_t count)
+{
+    vec_t acc0 = vset1(0.f), acc1 = vset1(0.f);
+    size_t i = 0;
+
+    for (; i + 2 * VLANES <= count; i += 2 * VLANES)
+    {
+        acc0 = vadd(acc0, vmul(vload(a + i), vload(b + i)));
+        acc1 = vadd(acc1, vmul(vload(a + i + VLANES), vload(b + i + VLANES)));
+    }
+
+    float sum = vhsum(vadd(acc0, acc1));
+
+    for (; i < count; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+static VATTR void FN(DotPlanes)(float *out, const float *const *planes,
+                                unsigned channels, size_t offset,
+                                const float *b, size_t count)
+{
+    for (unsigned i = 0; i < channels; i++)
+        out[i] = FN(Dot)(planes[i] + offset, b, count);
+}
+
+static VATTR void FN(BiquadCascade)(float *buf, unsigned frames,
+                                    unsigned channels,
+                                    const dsp_biquad_t *coeffs,
+                                    unsigned stages, float *state)
+{
+    /* The channels are the lanes. As each stage only depends on the output
+     * of the previous one for the same sample, the stages are applied one
+     * after the other to the whole buffer, with their state in registers. */
+    for (unsigned c = 0; c < channels; c += VLANES)
+    {
+        const unsigned n = channels - c < VLANES ? channels - c : VLANES;
+
+        for (unsigned s = 0; s < stages; s++)
+        {
+            const vec_t b0 = vset1(coeffs[s].b0), b1 = vset1(coeffs[s].b1),
+                        b2 = vset1(coeffs[s].b2), a1 = vset1(coeffs[s].a1),
+                        a2 = vset1(coeffs[s].a2);
+            float *st = state + 4 * s * channels + c;
+            vec_t x1 = FN(LoadPartial)(st, n);
+            vec_t x2 = FN(LoadPartial)(st + channels, n);
+            vec_t y1 = FN(LoadPartial)(st + 2 * channels, n);
+            vec_t y2 = FN(LoadPartial)(st + 3 * channels, n);
+            float *p = buf + c;
+
+#define BIQUAD(load, store) \
+            for (unsigned f = 0; f < frames; f++) \
+            { \
+                const vec_t x = load; \
+                const vec_t y = vsub(vsub(vadd(vadd(vmul(x, b0), \
+                                                    vmul(x1, b1)), \
+                                               vmul(x2, b2)), \
+                                          vmul(y1, a1)), \
+                                     vmul(y2, a2)); \
+                x2 = x1; x1 = x; \
+                y2 = y1; y1 = y; \
+                store; \
+                p += channels; \
+            }
+            if (n == VLANES)
+                BIQUAD(vload(p), vstore(p, y))
+            else
+                BIQUAD(FN(LoadPartial)(p, n), FN(StorePartial)(p, y, n))
+#undef BIQUAD
+
+            FN(StorePartial)(st, x1, n);
+            FN(StorePartial)(st + channels, x2, n);
+            FN(StorePartial)(st + 2 * channels, y1, n);
+            FN(StorePartial)(st + 3 * channels, y2, n);
+        }
+    }
+}
+
+static VATTR void FN(Resonators)(const dsp_resonators_t *bank,
+                                 dsp_resonators_state_t *state, float *buf,
+                                 unsigned frames, unsigned stride, float dry)
+{
+    /* The resonators are the lanes, the unused ones have zero coefficients */
+    const unsigned count = (bank->count + VLANES - 1) / VLANES * VLANES;
+    float x1 = state->x1, x2 = state->x2;
+
+    assert(count <= DSP_RESONATORS_MAX);
+
+    for (unsigned f = 0; f < frames; f++)
+    {
+        const float x = *buf;
+        const vec_t dx = vset1(x - x2);
+        vec_t acc = vset1(0.f);
+
+        for (unsigned j = 0; j < count; j += VLANES)
+        {
+            const vec_t y1 = vload(state->y1 + j);
+            const vec_t y2 = vload(state->y2 + j);
+            const vec_t y = vsub(vadd(vmul(vload(bank->alpha + j), dx),
+                                      vmul(vload(bank->gamma + j), y1)),
+                                 vmul(vload(bank->beta + j), y2));
+
+            vstore(state->y2 + j, y1);
+            vstore(state->y1 + j, y);
+            acc = vadd(acc, vmul(y, vload(bank->gain + j)));
+        }
+
+        *buf = dry * x + vhsum(acc);
+        x2 = x1;
+        x1 = x;
+        buf += stride;
+    }
+
+    state->x1 = x1;
+    state->x2 = x2;
+}
+
+/* There is no dependency between the samples of a span shorter than the
+ * delay line, so the spans up to the end of the line are vectorized. */
+static VATTR void FN(Comb)(dsp_delay_t *line, float feedback, float damp,
+                           const float *restrict in, float *restrict acc,
+                           unsigned count)
+{
+    const vec_t fb = vset1(feedback), dp = vset1(damp);
+
+    while (count > 0)
+    {
+        float *p = line->buffer + line->pos;
+        unsigned n = line->size - line->pos;
+        unsigned i = 0;
+
+        if (n > count)
+            n = count;
+
+        for (; i + VLANES <= n; i += VLANES)
+        {
+            const vec_t y = vflush(vload(p + i));
+
+            vstore(p + i, vadd(vload(in + i), vmul(vflush(vmul(y, dp)), fb)));
+            vstore(acc + i, vadd(vload(acc + i), y));
+        }
+        for (; i < n; i++)
+        {
+            const float y = Flush(p[i]);
+
+            p[i] = in[i] + Flush(y * damp) * feedback;
+            acc[i] += y;
+        }
+
+        line->pos += n;
+        if (line->pos == line->size)
+            line->pos = 0;
+        in += n;
+        acc += n;
+        count -= n;
+    }
+}
+
+static VATTR void FN(Allpass)(dsp_delay_t *line, float feedback,
+                              float *restrict buf, unsigned count)
+{
+    const vec_t fb = vset1(feedback);
+
+    while (count > 0)
+    {
+        float *p = line->buffer + line->pos;
+        unsigned n = line->size - line->pos;
+        unsigned i = 0;
+
+        if (n > count)
+            n = count;
+
+        for (; i + VLANES <= n; i += VLANES)
+        {
+            const vec_t y = vflush(vload(p + i));
+            const vec_t x = vload(buf + i);
+
+            vstore(buf + i, vsub(y, x));
+            vstore(p + i, vadd(x, vmul(y, fb)));
+        }
+        for (; i < n; i++)
+        {
+            const float y = Flush(p[i]);
+            const float x = buf[i];
+
+            buf[i] = y - x;
+            p[i] = x + y * feedback;
+        }
+
+        line->pos += n;
+        if (line->pos == line->size)
+            line->pos = 0;
+        buf += n;
+        count -= n;
+    }
+}
+
+static const struct dsp_ops FN(ops) = {
+    FN(Scale),
+    FN(MixAdd),
+    FN(Lerp),
+    FN(ScaleChannels),
+    FN(ScaleFrames),
+    FN(ChannelEnergy),
+    FN(FramePeak),
+    FN(Fir),
+    FN(Dot),
+    FN(DotPlanes),
+    FN(BiquadCascade),
+    FN(Resonators),
+    FN(Comb),
+    FN(Allpass),
+};
+
+#undef vec_t
+#undef VLANES
+#undef VATTR
+#undef FN
+#undef vload
+#undef vstore
+#undef vset1
+#undef vadd
+#undef vsub
+#undef vmul
+#undef vmax
+#undef vabs
+#undef vflush
+#undef vhsum
+#undef vhmax
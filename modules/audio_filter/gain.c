@@ -98,6 +98,7 @@ static int Open( vlc_object_t *p_this )
 
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = Process;
+    p_filter->b_in_place = true;
     return VLC_SUCCESS;
 }
 
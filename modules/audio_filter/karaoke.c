@@ -55,6 +55,7 @@ static int Open (vlc_object_t *obj)
     aout_FormatPrepare(&filter->fmt_in.audio);
     filter->fmt_out.audio = filter->fmt_in.audio;
     filter->pf_audio_filter = Process;
+    filter->b_in_place = true;
     return VLC_SUCCESS;
 }
 
@@ -44,6 +44,8 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
+#include "dsp.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -121,6 +123,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->b_in_place = true;
 
     return VLC_SUCCESS;
 }
@@ -130,39 +133,22 @@ static int Open( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
 {
-    float *pf_sum;
-    float *pf_gain;
+    float pf_sum[AOUT_CHAN_MAX] = { 0 };
+    float pf_gain[AOUT_CHAN_MAX];
     float f_average = 0;
     int i, i_chan;
 
     int i_samples = p_in_buf->i_nb_samples;
     int i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    float *p_out = (float*)p_in_buf->p_buffer;
-    float *p_in =  (float*)p_in_buf->p_buffer;
+    float *p_buf = (float*)p_in_buf->p_buffer;
 
     struct filter_sys_t *p_sys = p_filter->p_sys;
 
-    pf_sum = calloc( i_channels, sizeof(float) );
-    if( !pf_sum )
-        goto out;
-
-    pf_gain = vlc_alloc( i_channels, sizeof(float) );
-    if( !pf_gain )
-    {
-        free( pf_sum );
-        goto out;
-    }
-
     /* Calculate the average power level on this buffer */
-    for( i = 0 ; i < i_samples; i++ )
-    {
-        for( i_chan = 0; i_chan < i_channels; i_chan++ )
-        {
-            float f_sample = p_in[i_chan];
-            pf_sum[i_chan] += f_sample * f_sample;
-        }
-        p_in += i_channels;
-    }
+    dsp_ChannelEnergy( p_buf, i_samples, i_channels, pf_sum );
+
+    /* Seuil arbitraire */
+    p_sys->f_max = var_GetFloat( p_filter->obj.parent, "norm-max-level" );
 
     /* sum now contains for each channel the sigma(value²) */
     for( i_chan = 0; i_chan < i_channels; i_chan++ )
@@ -176,8 +162,6 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
         p_sys->p_last[ i_chan * p_sys->i_nb + p_sys->i_nb - 1] =
                 sqrt( pf_sum[i_chan] );
 
-        pf_sum[i_chan] = 0;
-
         /* Get the average power on the lastbuff */
         f_average = 0;
         for( i = 0; i < p_sys->i_nb ; i++)
@@ -186,14 +170,10 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
         }
         f_average = f_average / p_sys->i_nb;
 
-        /* Seuil arbitraire */
-        p_sys->f_max = var_GetFloat( p_filter->obj.parent,
-                                     "norm-max-level" );
-
         //fprintf(stderr,"Average %f, max %f\n", f_average, p_sys->f_max );
         if( f_average > p_sys->f_max )
         {
-             pf_gain[i_chan] = f_average / p_sys->f_max;
+             pf_gain[i_chan] = p_sys->f_max / f_average;
         }
         else
         {
@@ -202,22 +182,9 @@ static block_t *DoWork( filter_t *p_filter, block_t *p_in_buf )
     }
 
     /* Apply gain */
-    for( i = 0; i < i_samples; i++)
-    {
-        for( i_chan = 0; i_chan < i_channels; i_chan++ )
-        {
-            p_out[i_chan] /= pf_gain[i_chan];
-        }
-        p_out += i_channels;
-    }
-
-    free( pf_sum );
-    free( pf_gain );
+    dsp_ScaleChannels( p_buf, pf_gain, i_samples, i_channels );
 
     return p_in_buf;
-out:
-    block_Release( p_in_buf );
-    return NULL;
 }
 
 /**********************************************************************
@@ -0,0 +1,541 @@
+/*****************************************************************************
+ * polyphase.c : polyphase windowed sinc resampler
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble:
+ *
+ * Each output sample is the dot product of the input around its position
+ * with a Kaiser-windowed sinc low-pass filter, shifted by the fractional
+ * part of the position. The filter is precomputed for BANK_PHASES shifts,
+ * and the output is linearly interpolated between the two nearest phases.
+ *
+ * The bank only depends on the cut-off frequency, that is on the ratio when
+ * down-sampling. Hence the small rate adjustments for clock drift, or any
+ * change while up-sampling, only change the step between output samples.
+ * The last banks are kept for the playback rate changes.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+
+#include "../dsp.h"
+#include "../dsp_convert.h"
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Open( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_shortname( N_("Polyphase resampler") )
+    set_description( N_("Polyphase windowed sinc audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    set_capability( "audio converter", 30 )
+    set_callbacks( Open, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 30 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+/* Number of filter phases between two input samples */
+#define BANK_PHASES_BITS 8
+#define BANK_PHASES (1 << BANK_PHASES_BITS)
+/* Number of zero crossings of the sinc on each side without down-sampling */
+#define BANK_ZEROS 16
+#define BANK_TAPS_MAX 1024
+/* Kaiser window parameter, about 80 dB of stop-band attenuation */
+#define BANK_BETA 8.
+/* Cut-off frequency relatively to the lowest Nyquist frequency */
+#define BANK_CUTOFF .9
+/* Quantization of the down-sampling ratio */
+#define BANK_RATIO_STEPS 64
+/* Relative change of the ratio before the bank is changed, so that the
+ * drift adjustments keep the same bank. The cut-off margin absorbs it. */
+#define BANK_RATIO_TOLERANCE .03
+#define BANK_CACHE_SIZE 4
+
+/* Fixed point positions in input samples */
+#define POS_FRAC_BITS 32
+
+typedef struct
+{
+    unsigned ratio; /* down-sampling ratio in 1 / BANK_RATIO_STEPS */
+    unsigned taps;  /* multiple of 8 */
+    uint64_t last_use;
+    float coeffs[]; /* BANK_PHASES + 1 phases of taps coefficients */
+} bank_t;
+
+struct filter_sys_t
+{
+    bank_t *banks[BANK_CACHE_SIZE];
+    bank_t *bank; /* current */
+    uint64_t uses;
+
+    /* Input history, one buffer per channel */
+    float **planes;
+    unsigned channels;
+    size_t size;      /* allocated frames per plane */
+    size_t frames;    /* valid frames per plane */
+    uint64_t pos;     /* position of the next output in the planes */
+    mtime_t end_pts;  /* date of the end of the history */
+    bool discontinuity; /* flag for the next output buffer */
+
+    float taps[BANK_TAPS_MAX]; /* interpolated filter */
+};
+
+/*****************************************************************************
+ * Filter banks
+ *****************************************************************************/
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; term > sum * 1e-12; k++ )
+    {
+        term *= ( x / ( 2. * k ) ) * ( x / ( 2. * k ) );
+        sum += term;
+    }
+    return sum;
+}
+
+static bank_t *BankNew( unsigned ratio )
+{
+    const double cutoff = BANK_CUTOFF * ratio / BANK_RATIO_STEPS;
+    unsigned taps = ceil( 2. * BANK_ZEROS * BANK_RATIO_STEPS / ratio );
+
+    taps = __MIN( ( taps + 7 ) & ~7u, BANK_TAPS_MAX );
+
+    bank_t *bank = malloc( sizeof (*bank)
+                         + ( BANK_PHASES + 1 ) * taps * sizeof (float) );
+    if( unlikely(bank == NULL) )
+        return NULL;
+
+    bank->ratio = ratio;
+    bank->taps = taps;
+    bank->last_use = 0;
+
+    /* Phase p filters the input at the fractional position p / BANK_PHASES,
+     * with the tap k at the distance k - (taps / 2 - 1) - p / BANK_PHASES */
+    const double half = taps / 2;
+    const double norm = BesselI0( BANK_BETA );
+
+    for( unsigned p = 0; p <= BANK_PHASES; p++ )
+    {
+        float *h = bank->coeffs + p * taps;
+        double sum = 0.;
+
+        for( unsigned k = 0; k < taps; k++ )
+        {
+            double x = k - ( half - 1. ) - (double)p / BANK_PHASES;
+            double w = x / half;
+            double v = cutoff;
+
+            if( x != 0. )
+                v = sin( M_PI * cutoff * x ) / ( M_PI * x );
+            v *= BesselI0( BANK_BETA * sqrt( fmax( 0., 1. - w * w ) ) ) / norm;
+            h[k] = v;
+            sum += v;
+        }
+
+        /* Unity gain at DC for every phase */
+        for( unsigned k = 0; k < taps; k++ )
+            h[k] /= sum;
+    }
+    return bank;
+}
+
+static bank_t *BankGet( filter_t *p_filter, unsigned in_rate,
+                        unsigned out_rate )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const double ideal = BANK_RATIO_STEPS
+                       * __MIN( (double)out_rate / in_rate, 1. );
+
+    /* The current bank stays the most recently used, so that it is never
+     * evicted */
+    if( p_sys->bank != NULL
+     && fabs( p_sys->bank->ratio - ideal ) <= ideal * BANK_RATIO_TOLERANCE )
+    {
+        p_sys->bank->last_use = ++p_sys->uses;
+        return p_sys->bank;
+    }
+
+    /* Rounded down, so that the cut-off does not exceed the Nyquist
+     * frequency of the output */
+    const unsigned ratio = __MAX( (unsigned)ideal, 1 );
+
+    unsigned lru = 0;
+    for( unsigned i = 0; i < BANK_CACHE_SIZE; i++ )
+    {
+        bank_t *bank = p_sys->banks[i];
+
+        if( bank == NULL )
+        {
+            lru = i;
+            break;
+        }
+        if( bank->ratio == ratio )
+        {
+            bank->last_use = ++p_sys->uses;
+            return bank;
+        }
+        if( bank->last_use < p_sys->banks[lru]->last_use )
+            lru = i;
+    }
+
+    bank_t *bank = BankNew( ratio );
+    if( unlikely(bank == NULL) )
+        return NULL;
+
+    msg_Dbg( p_filter, "new bank for %u/%u Hz: %u taps", in_rate, out_rate,
+             bank->taps );
+    free( p_sys->banks[lru] );
+    p_sys->banks[lru] = bank;
+    bank->last_use = ++p_sys->uses;
+    return bank;
+}
+
+/*****************************************************************************
+ * Resample: convert a buffer
+ *****************************************************************************/
+static void Reset( filter_sys_t *p_sys )
+{
+    /* Starts with half a filter of silence, so that the first output
+     * sample is at the first input sample */
+    const unsigned history = p_sys->bank->taps / 2 - 1;
+
+    for( unsigned i = 0; i < p_sys->channels; i++ )
+        memset( p_sys->planes[i], 0, history * sizeof (float) );
+    p_sys->frames = history;
+    p_sys->pos = 0;
+}
+
+static int Reserve( filter_sys_t *p_sys, size_t frames )
+{
+    if( frames <= p_sys->size )
+        return VLC_SUCCESS;
+
+    for( unsigned i = 0; i < p_sys->channels; i++ )
+    {
+        float *plane = realloc( p_sys->planes[i], frames * sizeof (float) );
+        if( unlikely(plane == NULL) )
+            return VLC_ENOMEM;
+        p_sys->planes[i] = plane;
+    }
+    p_sys->size = frames;
+    return VLC_SUCCESS;
+}
+
+/* Computes the output samples whose filter fits in the history */
+static block_t *Convert( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned channels = p_sys->channels;
+    const bank_t *bank = p_sys->bank;
+    const unsigned taps = bank->taps;
+
+    const uint64_t step = ( (uint64_t)in_rate << POS_FRAC_BITS ) / out_rate;
+    unsigned out_frames = 0;
+
+    if( p_sys->frames >= taps )
+    {
+        uint64_t end = (uint64_t)( p_sys->frames - taps + 1 ) << POS_FRAC_BITS;
+
+        if( end > p_sys->pos )
+            out_frames = ( end - p_sys->pos + step - 1 ) / step;
+    }
+    if( out_frames == 0 )
+        return NULL;
+
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter,
+                                    out_frames * channels * sizeof (float) );
+    if( unlikely(p_out_buf == NULL) )
+        return NULL;
+
+    /* The first output sample is at the center of its filter, behind the
+     * end of the history by the group delay of the filter and the samples
+     * that wait for the next ones */
+    const int64_t center = p_sys->pos
+                         + ( (uint64_t)( taps / 2 - 1 ) << POS_FRAC_BITS );
+    const int64_t delay = ( (int64_t)p_sys->frames << POS_FRAC_BITS ) - center;
+
+    p_out_buf->i_dts =
+    p_out_buf->i_pts = p_sys->end_pts
+                     - ( delay >> 16 ) * CLOCK_FREQ / in_rate
+                       / ( 1 << ( POS_FRAC_BITS - 16 ) );
+
+    float *p_out = (float *)p_out_buf->p_buffer;
+    uint64_t pos = p_sys->pos;
+
+    for( unsigned j = 0; j < out_frames; j++ )
+    {
+        const size_t offset = pos >> POS_FRAC_BITS;
+        const uint32_t frac = pos;
+        const unsigned phase = frac >> ( POS_FRAC_BITS - BANK_PHASES_BITS );
+        const float *h = bank->coeffs + phase * taps;
+        const float alpha = ( frac & ( ( 1u << ( POS_FRAC_BITS
+                                                 - BANK_PHASES_BITS ) ) - 1 ) )
+                          * ( 1.f / ( 1u << ( POS_FRAC_BITS
+                                              - BANK_PHASES_BITS ) ) );
+
+        if( alpha != 0.f )
+        {
+            dsp_Lerp( p_sys->taps, h, h + taps, alpha, taps );
+            h = p_sys->taps;
+        }
+
+        dsp_DotPlanes( p_out, (const float *const *)p_sys->planes, channels,
+                       offset, h, taps );
+        p_out += channels;
+        pos += step;
+    }
+
+    /* Drops the history before the next output */
+    size_t consumed = __MIN( pos >> POS_FRAC_BITS, p_sys->frames );
+    for( unsigned i = 0; i < channels; i++ )
+        memmove( p_sys->planes[i], p_sys->planes[i] + consumed,
+                 ( p_sys->frames - consumed ) * sizeof (float) );
+    p_sys->frames -= consumed;
+    p_sys->pos = pos - ( (uint64_t)consumed << POS_FRAC_BITS );
+
+    p_out_buf->i_nb_samples = out_frames;
+    p_out_buf->i_flags = p_sys->discontinuity ? BLOCK_FLAG_DISCONTINUITY : 0;
+    p_out_buf->i_length = out_frames * CLOCK_FREQ / out_rate;
+    p_sys->discontinuity = false;
+    return p_out_buf;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->bank != NULL )
+        Reset( p_sys );
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out_buf = NULL;
+
+    if( p_sys->bank == NULL )
+        return NULL;
+
+    /* Pads the end with half a filter of silence, so that the last output
+     * sample is at the last input sample */
+    const unsigned pad = p_sys->bank->taps / 2;
+    if( Reserve( p_sys, p_sys->frames + pad ) == VLC_SUCCESS )
+    {
+        for( unsigned i = 0; i < p_sys->channels; i++ )
+            memset( p_sys->planes[i] + p_sys->frames, 0,
+                    pad * sizeof (float) );
+        p_sys->frames += pad;
+        p_sys->end_pts += (mtime_t)pad * CLOCK_FREQ
+                        / p_filter->fmt_in.audio.i_rate;
+        p_out_buf = Convert( p_filter );
+    }
+    Reset( p_sys );
+    return p_out_buf;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in_buf )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned channels = p_sys->channels;
+    block_t *p_out_buf = NULL;
+
+    /* Check if we really need to run the resampler */
+    if( in_rate == out_rate )
+    {
+        if( p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY )
+            Flush( p_filter );
+
+        /* Outputs the end of the history before the input, then starts
+         * over from silence when the rates differ again */
+        block_t *p_tail = Drain( p_filter );
+        p_sys->bank = NULL;
+        if( p_tail == NULL )
+        {
+            if( p_sys->discontinuity )
+                p_in_buf->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+            p_sys->discontinuity = false;
+            return p_in_buf;
+        }
+
+        const unsigned i_nb_samples = p_tail->i_nb_samples
+                                    + p_in_buf->i_nb_samples;
+
+        block_ChainAppend( &p_tail, p_in_buf );
+        p_out_buf = block_ChainGather( p_tail );
+        if( unlikely(p_out_buf == NULL) )
+        {
+            block_ChainRelease( p_tail );
+            return NULL;
+        }
+        p_out_buf->i_nb_samples = i_nb_samples;
+        return p_out_buf;
+    }
+
+    bank_t *bank = BankGet( p_filter, in_rate, out_rate );
+    if( unlikely(bank == NULL) )
+        goto out;
+
+    /* The history is kept across a bank change: the filter keeps the same
+     * center, with more or less samples around it */
+    const unsigned taps = bank->taps;
+    if( p_sys->bank != bank )
+    {
+        if( Reserve( p_sys, p_sys->frames + taps ) )
+            goto out;
+
+        if( p_sys->bank == NULL )
+        {
+            p_sys->bank = bank;
+            Reset( p_sys );
+        }
+        else
+        {
+            const unsigned old_half = p_sys->bank->taps / 2;
+            const unsigned new_half = taps / 2;
+
+            p_sys->bank = bank;
+            if( new_half > old_half )
+            {   /* Pads the start with silence */
+                size_t pad = new_half - old_half;
+
+                for( unsigned i = 0; i < channels; i++ )
+                {
+                    memmove( p_sys->planes[i] + pad, p_sys->planes[i],
+                             p_sys->frames * sizeof (float) );
+                    memset( p_sys->planes[i], 0, pad * sizeof (float) );
+                }
+                p_sys->frames += pad;
+            }
+            else
+                p_sys->pos += (uint64_t)( old_half - new_half )
+                              << POS_FRAC_BITS;
+        }
+    }
+
+    if( p_in_buf->i_flags & BLOCK_FLAG_DISCONTINUITY )
+    {
+        Reset( p_sys );
+        p_sys->discontinuity = true;
+    }
+
+    /* Appends the input to the history */
+    const unsigned in_frames = p_in_buf->i_nb_samples;
+    if( Reserve( p_sys, p_sys->frames + in_frames ) )
+        goto out;
+
+    void *planes[DSP_CHANNELS_MAX];
+    for( unsigned i = 0; i < channels; i++ )
+        planes[i] = p_sys->planes[i] + p_sys->frames;
+    dsp_DeinterleaveConvert( planes, VLC_CODEC_FL32, p_in_buf->p_buffer,
+                             VLC_CODEC_FL32, in_frames, channels );
+    p_sys->frames += in_frames;
+    p_sys->end_pts = p_in_buf->i_pts
+                   + (mtime_t)in_frames * CLOCK_FREQ / in_rate;
+
+    p_out_buf = Convert( p_filter );
+out:
+    block_Release( p_in_buf );
+    return p_out_buf;
+}
+
+/*****************************************************************************
+ * Open:
+ *****************************************************************************/
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_in.audio.i_channels != p_filter->fmt_out.audio.i_channels
+     || p_filter->fmt_in.audio.i_channels == 0
+     || p_filter->fmt_in.audio.i_channels > DSP_CHANNELS_MAX )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->channels = p_filter->fmt_in.audio.i_channels;
+    p_sys->planes = calloc( p_sys->channels, sizeof (*p_sys->planes) );
+    if( unlikely(p_sys->planes == NULL) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+/*****************************************************************************
+ * Close: deallocate data structures
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( unsigned i = 0; i < BANK_CACHE_SIZE; i++ )
+        free( p_sys->banks[i] );
+    for( unsigned i = 0; i < p_sys->channels; i++ )
+        free( p_sys->planes[i] );
+    free( p_sys->planes );
+    free( p_sys );
+}
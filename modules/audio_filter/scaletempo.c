@@ -36,7 +36,8 @@
 #include <vlc_modules.h>
 
 #include <string.h> /* for memset */
-#include <limits.h> /* form INT_MIN */
+
+#include "dsp.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -56,6 +57,24 @@ static block_t *DoPitchWork( filter_t *, block_t * );
 # define MODULES_SHORTNAME N_("Scaletempo")
 #endif
 
+enum
+{
+    SEARCH_AUTO,
+    SEARCH_DIRECT,
+    SEARCH_FFT,
+};
+
+/* Cost of the FFT search per point and pass, relatively to a multiply-add of
+ * the (vectorized) direct search, as measured with SSE and AVX */
+#define SEARCH_FFT_COST 24
+
+static const int search_method_values[] = {
+    SEARCH_AUTO, SEARCH_DIRECT, SEARCH_FFT,
+};
+static const char *const search_method_texts[] = {
+    N_("Automatic"), N_("Direct"), N_("FFT"),
+};
+
 vlc_module_begin ()
     set_description( MODULE_DESC )
     set_shortname( MODULES_SHORTNAME )
@@ -69,6 +88,11 @@ vlc_module_begin ()
         N_("Overlap Length"), N_("Percentage of stride to overlap"), true )
     add_integer_with_range( "scaletempo-search", 14, 0, 200,
         N_("Search Length"), N_("Length in milliseconds to search for best overlap position"), true )
+    add_integer( "scaletempo-search-method", SEARCH_AUTO,
+        N_("Search Method"), N_("Compute the correlations directly, or through a FFT which is faster for long search lengths"), true )
+        change_integer_list( search_method_values, search_method_texts )
+    add_bool( "scaletempo-search-downmix", false,
+        N_("Downmix for Search"), N_("Search the best overlap position on the sum of the channels. Faster but less accurate with several channels"), true )
 #ifdef PITCH_SHIFTER
     add_float_with_range( "pitch-shift", 0, -12, 12,
         N_("Pitch Shift"), N_("Pitch shift in semitones."), false )
@@ -127,8 +151,15 @@ struct filter_sys_t
     void    (*output_overlap)( filter_t *p_filter, void *p_out_buf, unsigned bytes_off );
     /* best overlap */
     unsigned  frames_search;
+    unsigned  frames_pre_corr;
+    int       search_method;
+    bool      search_downmix;
     void     *buf_pre_corr;
     void     *table_window;
+    float    *buf_search;   /* downmixed search area */
+    float    *buf_corr;     /* correlation for each offset */
+    float    *buf_fft;      /* real and imaginary parts, and their sums */
+    dsp_fft_t *fft;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
 #ifdef PITCH_SHIFTER
     /* pitch */
@@ -140,13 +171,19 @@ struct filter_sys_t
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
-static unsigned best_overlap_offset_float( filter_t *p_filter )
+static unsigned best_corr_offset( const float *corr, unsigned count )
 {
-    filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
     unsigned best_off = 0;
-    unsigned i, off;
+    for( unsigned off = 1; off < count; off++ )
+        if( corr[off] > corr[best_off] )
+            best_off = off;
+    return best_off;
+}
+
+static void pre_correlate( filter_sys_t *p )
+{
+    float *pw, *po, *ppc;
+    unsigned i;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -155,23 +192,123 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
       *ppc++ = *pw++ * *po++;
     }
+}
+
+/* Sums the channels of the overlap and of the search area, so that the
+ * correlations are computed once instead of once per channel */
+static void downmix_for_search( filter_sys_t *p )
+{
+    const unsigned channels = p->samples_per_frame;
+    const float *pw = p->table_window;
+    const float *po = (float *)p->buf_overlap + channels;
+    const float *ps = (float *)p->buf_queue + channels;
+    float *ppc = p->buf_pre_corr;
+    float *pd  = p->buf_search;
+    unsigned i, j;
+
+    for( i = 0; i < p->frames_pre_corr; i++ ) {
+        float sum = 0.f;
+        for( j = 0; j < channels; j++ )
+            sum += *po++;
+        *ppc++ = sum * *pw;
+        pw += channels;
+    }
+
+    for( i = 0; i < p->frames_search + p->frames_pre_corr - 1; i++ ) {
+        float sum = 0.f;
+        for( j = 0; j < channels; j++ )
+            sum += *ps++;
+        *pd++ = sum;
+    }
+}
+
+static unsigned best_overlap_offset_float( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const float *search_start;
+    unsigned off;
+
+    pre_correlate( p );
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
-      if( corr > best_corr ) {
-        best_corr = corr;
-        best_off  = off;
-      }
-      search_start += p->samples_per_frame;
+        p->buf_corr[off] = dsp_Dot( p->buf_pre_corr, search_start,
+                                    p->samples_overlap - p->samples_per_frame );
+        search_start += p->samples_per_frame;
+    }
+
+    return best_corr_offset( p->buf_corr, p->frames_search )
+         * p->bytes_per_frame;
+}
+
+static unsigned best_overlap_offset_downmix( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+
+    downmix_for_search( p );
+    dsp_Fir( p->buf_corr, p->buf_search, p->buf_pre_corr,
+             p->frames_pre_corr, p->frames_search );
+
+    return best_corr_offset( p->buf_corr, p->frames_search )
+         * p->bytes_per_frame;
+}
+
+/* Correlates in the frequency domain: corr = IFFT( conj( FFT( pre_corr ) )
+ * * FFT( search area ) ), summed over the channels. Both real signals of a
+ * channel are transformed at once as the real and imaginary parts. The FFT
+ * is large enough for the circular correlation not to wrap over the
+ * searched offsets. */
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned size = dsp_FFTSize( p->fft );
+    const unsigned frames_in = p->frames_search + p->frames_pre_corr - 1;
+    float *re     = p->buf_fft;
+    float *im     = re + size;
+    float *acc_re = im + size;
+    float *acc_im = acc_re + size;
+    const float *pc, *ps;
+    unsigned channels, i, j;
+
+    if( p->search_downmix ) {
+        downmix_for_search( p );
+        channels = 1;
+        ps = p->buf_search;
+    } else {
+        pre_correlate( p );
+        channels = p->samples_per_frame;
+        ps = (float *)p->buf_queue + channels;
     }
+    pc = p->buf_pre_corr;
+
+    memset( acc_re, 0, 2 * size * sizeof (float) );
+    for( j = 0; j < channels; j++ ) {
+        for( i = 0; i < p->frames_pre_corr; i++ )
+            re[i] = pc[i * channels + j];
+        memset( re + i, 0, ( size - i ) * sizeof (float) );
+        for( i = 0; i < frames_in; i++ )
+            im[i] = ps[i * channels + j];
+        memset( im + i, 0, ( size - i ) * sizeof (float) );
+
+        dsp_FFT( p->fft, re, im, false );
+
+        /* Splits X = FFT( pre_corr + i * search ) in
+         * 2 * PRE_CORR = X[k] + conj( X[-k] ) and
+         * 2 * SEARCH = -i * ( X[k] - conj( X[-k] ) ),
+         * and accumulates 4 * conj( PRE_CORR ) * SEARCH */
+        for( i = 0; i < size; i++ ) {
+            unsigned m = ( size - i ) & ( size - 1 );
+            float ar = re[i] + re[m], ai = im[i] - im[m];
+            float br = im[i] + im[m], bi = re[m] - re[i];
+            acc_re[i] += ar * br + ai * bi;
+            acc_im[i] += ar * bi - ai * br;
+        }
+    }
+
+    /* The scaling by 1 / ( 4 * size ) does not change the best offset */
+    dsp_FFT( p->fft, acc_re, acc_im, true );
 
-    return best_off * p->bytes_per_frame;
+    return best_corr_offset( acc_re, p->frames_search ) * p->bytes_per_frame;
 }
 
 /*****************************************************************************
@@ -352,7 +489,8 @@ static int reinit_buffers( filter_t *p_filter )
         unsigned bytes_pre_corr = ( p->samples_overlap - p->samples_per_frame ) * 4; /* sizeof (int32|float) */
         p->buf_pre_corr = malloc( bytes_pre_corr );
         p->table_window = malloc( bytes_pre_corr );
-        if( ! p->buf_pre_corr || ! p->table_window )
+        p->buf_corr     = vlc_alloc( p->frames_search, sizeof (float) );
+        if( ! p->buf_pre_corr || ! p->table_window || ! p->buf_corr )
             return VLC_ENOMEM;
         float *pw = p->table_window;
         for( i = 1; i<frames_overlap; i++ )
@@ -361,7 +499,53 @@ static int reinit_buffers( filter_t *p_filter )
             for( j = 0; j < p->samples_per_frame; j++ )
                 *pw++ = v;
         }
-        p->best_overlap_offset = best_overlap_offset_float;
+
+        p->frames_pre_corr = frames_overlap - 1;
+        unsigned frames_in = p->frames_search + p->frames_pre_corr - 1;
+        if( p->samples_per_frame == 1 )
+            p->search_downmix = false;
+        if( p->search_downmix )
+        {
+            p->buf_search = vlc_alloc( frames_in, sizeof (float) );
+            if( ! p->buf_search )
+                return VLC_ENOMEM;
+        }
+
+        unsigned fft_size = 2;
+        while( fft_size < frames_in )
+            fft_size *= 2;
+
+        bool use_fft = p->search_method == SEARCH_FFT;
+        if( p->search_method == SEARCH_AUTO )
+        {
+            /* The direct search costs one multiply-add per offset and
+             * windowed sample, the FFT search one transform per channel plus
+             * the inverse */
+            unsigned channels = p->search_downmix ? 1 : p->samples_per_frame;
+            unsigned log2_size = 0;
+            while( ( 1u << log2_size ) < fft_size )
+                log2_size++;
+            use_fft = (uint64_t)p->frames_search * p->frames_pre_corr * channels
+                    > (uint64_t)fft_size * log2_size * ( channels + 1 )
+                      * SEARCH_FFT_COST;
+        }
+
+        if( use_fft )
+        {
+            p->fft     = dsp_FFTNew( fft_size );
+            p->buf_fft = vlc_alloc( 4 * fft_size, sizeof (float) );
+            if( ! p->fft || ! p->buf_fft )
+                return VLC_ENOMEM;
+            p->best_overlap_offset = best_overlap_offset_fft;
+        }
+        else if( p->search_downmix )
+            p->best_overlap_offset = best_overlap_offset_downmix;
+        else
+            p->best_overlap_offset = best_overlap_offset_float;
+
+        msg_Dbg( VLC_OBJECT(p_filter), "%s search%s",
+                 use_fft ? "FFT" : "direct",
+                 p->search_downmix ? " on downmix" : "" );
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -432,6 +616,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->percent_overlap = var_InheritFloat( p_this, "scaletempo-overlap" );
     p_sys->ms_search       = var_InheritInteger( p_this, "scaletempo-search" );
 
+    p_sys->search_method   = var_InheritInteger( p_this, "scaletempo-search-method" );
+    p_sys->search_downmix  = var_InheritBool( p_this, "scaletempo-search-downmix" );
+
     msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search",
              p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search );
 
@@ -440,6 +627,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->buf_search     = NULL;
+    p_sys->buf_corr       = NULL;
+    p_sys->buf_fft        = NULL;
+    p_sys->fft            = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -536,6 +727,11 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->buf_search );
+    free( p_sys->buf_corr );
+    free( p_sys->buf_fft );
+    if( p_sys->fft )
+        dsp_FFTDelete( p_sys->fft );
     free( p_sys );
 }
 
@@ -576,7 +772,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
     }
 
     size_t i_outsize = calculate_output_buffer_size ( p_filter, p_in_buf->i_buffer );
-    block_t *p_out_buf = block_Alloc( i_outsize );
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
     if( p_out_buf == NULL )
         return NULL;
 
@@ -9,20 +9,21 @@
 
 allpass::allpass()
 {
-    bufidx = 0;
-    buffer = NULL;
+    line.buffer = NULL;
+    line.size = 0;
+    line.pos = 0;
 }
 
 void allpass::setbuffer(float *buf, int size)
 {
-    buffer = buf;
-    bufsize = size;
+    line.buffer = buf;
+    line.size = size;
 }
 
 void allpass::mute()
 {
-    for (int i=0; i<bufsize; i++)
-        buffer[i]=0;
+    for (unsigned i=0; i<line.size; i++)
+        line.buffer[i]=0;
 }
 
 void allpass::setfeedback(float val)
@@ -6,40 +6,30 @@
 
 #ifndef _allpass_
 #define _allpass_
-#include "denormals.h"
+#include <stddef.h>
+#include "../dsp.h"
 
 class allpass
 {
 public:
         allpass();
     void    setbuffer(float *buf, int size);
-    inline  float    process(float inp);
+    inline  void    process(float *buf, int count);
     void    mute();
     void    setfeedback(float val);
     float    getfeedback();
 // private:
     float    feedback;
-    float    *buffer;
-    int    bufsize;
-    int    bufidx;
+    dsp_delay_t line;
 };
 
 
 // Big to inline - but crucial for speed
 
-inline float allpass::process(float input)
+// Filters count samples in place
+inline void allpass::process(float *buf, int count)
 {
-    float output;
-    float bufout;
-
-    bufout = undenormalise( buffer[bufidx] );
-
-    output = -input + bufout;
-    buffer[bufidx] = input + (bufout*feedback);
-
-    if(++bufidx>=bufsize) bufidx = 0;
-
-    return output;
+    dsp_Allpass(&line, feedback, buf, count);
 }
 
 #endif//_allpass
@@ -9,21 +9,21 @@
 
 comb::comb()
 {
-    filterstore = 0;
-    bufidx = 0;
-    buffer = NULL;
+    line.buffer = NULL;
+    line.size = 0;
+    line.pos = 0;
 }
 
 void comb::setbuffer(float *buf, int size)
 {
-    buffer = buf;
-    bufsize = size;
+    line.buffer = buf;
+    line.size = size;
 }
 
 void comb::mute()
 {
-    for (int i=0; i<bufsize; i++)
-        buffer[i]=0;
+    for (unsigned i=0; i<line.size; i++)
+        line.buffer[i]=0;
 }
 
 void comb::setdamp(float val)
@@ -7,7 +7,8 @@
 #ifndef _comb_
 #define _comb_
 
-#include "denormals.h"
+#include <stddef.h>
+#include "../dsp.h"
 
 /**
 * Combination filter
@@ -18,7 +19,7 @@ class comb
 public:
     comb();
     void    setbuffer(float *buf, int size);
-    inline  float    process(float inp);
+    inline  void    process(const float *inp, float *out, int count);
     void    mute();
     void    setdamp(float val);
     float    getdamp();
@@ -26,33 +27,21 @@ public:
     float    getfeedback();
 private:
     float    feedback;
-    float    filterstore;
     float    damp1;
     float    damp2;
-    float    *buffer;
-    int    bufsize;
-    int    bufidx;
+    dsp_delay_t line;
 };
 
 
 // Big to inline - but crucial for speed
 
-inline float comb::process(float input)
+// Adds the output for count input samples to out
+inline void comb::process(const float *input, float *out, int count)
 {
 /* FIXME
 * comb::process is not really ear-friendly the tunning values must
 * be changed*/
-    float output;
-
-    output = undenormalise( buffer[bufidx] );
-
-    filterstore = undenormalise(output*damp2);
-
-    buffer[bufidx] = input + filterstore*feedback;
-
-    if(++bufidx>=bufsize) bufidx = 0;
-
-    return output;
+    dsp_Comb(&line, feedback, damp2, input, out, count);
 }
 
 #endif //_comb_
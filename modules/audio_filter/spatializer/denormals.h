@@ -1,18 +0,0 @@
-// Macro for killing denormalled numbers
-//
-// Written by Jezar at Dreampoint, June 2000
-// http://www.dreampoint.co.uk
-// Based on IS_DENORMAL macro by Jon Watte
-// This code is public domain
-
-#ifndef _denormals_
-#define _denormals_
-
-
-#ifdef __cplusplus
-extern "C"
-#endif
-float undenormalise( float );
-
-#endif//_denormals_
-
@@ -15,6 +15,9 @@
 #include "tuning.h"
 #include <stdlib.h>
 
+// Number of samples processed at once by the filters
+static const int chunksize = 256;
+
 revmodel::revmodel() : roomsize(initialroom), damp(initialdamp),
                        wet(initialwet), dry(initialdry), width(1.), mode(0.)
 {
@@ -89,70 +92,77 @@ void revmodel::mute()
  * /param long numsamples  number of samples to be processed
  * /param int skip             number of channels in the audio stream
  *****************************************************************************/
-void revmodel::processreplace(float *inputL, float *outputL, long /* numsamples */, int skip)
+void revmodel::processreplace(float *inputL, float *outputL, long numsamples, int skip)
 {
-    float outL,outR,input;
-    float inputR;
-    int i;
-
-    outL = outR = 0;
-        /* TODO this module supports only 2 audio channels, let's improve this */
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
-
-        // Accumulate comb filters in parallel
-        for(i=0; i<numcombs; i++)
-        {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
-        }
-
-        // Feed through allpasses in series
-        for(i=0; i<numallpasses; i++)
-        {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
-        }
+    process(inputL, outputL, numsamples, skip, false);
+}
 
-        // Calculate output REPLACING anything already there
-        outputL[0] = (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] = (outR*wet1 + outL*wet2 + inputR*dry);
+void revmodel::processmix(float *inputL, float *outputL, long numsamples, int skip)
+{
+    process(inputL, outputL, numsamples, skip, true);
 }
 
-void revmodel::processmix(float *inputL, float *outputL, long /* numsamples */, int skip)
+/* The samples are processed by chunks, each filter running over a whole
+ * chunk at once */
+void revmodel::process(float *inputL, float *outputL, long numsamples, int skip,
+                       bool mix)
 {
-    float outL,outR,input;
-    float inputR;
+    float input[chunksize], inputR[chunksize];
+    float outL[chunksize], outR[chunksize];
 
-    outL = outR = 0;
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
+    while (numsamples > 0)
+    {
+        int count = numsamples < chunksize ? numsamples : chunksize;
+
+        /* TODO this module supports only 2 audio channels, let's improve this */
+        for (int j = 0; j < count; j++)
+        {
+            if (skip > 1)
+               inputR[j] = inputL[j * skip + 1];
+            else
+               inputR[j] = inputL[j * skip];
+            input[j] = (inputL[j * skip] + inputR[j]) * gain;
+            outL[j] = outR[j] = 0;
+        }
 
         // Accumulate comb filters in parallel
-        for(int i=0; i<numcombs; i++)
+        for (int i = 0; i < numcombs; i++)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            combL[i].process(input, outL, count);
+            combR[i].process(input, outR, count);
         }
 
         // Feed through allpasses in series
-        for(int i=0; i<numallpasses; i++)
+        for (int i = 0; i < numallpasses; i++)
         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
+            allpassL[i].process(outL, count);
+            allpassR[i].process(outR, count);
         }
 
-        // Calculate output REPLACING anything already there
-        outputL[0] += (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] += (outR*wet1 + outL*wet2 + inputR*dry);
+        // Calculate output, REPLACING or mixing to anything already there
+        for (int j = 0; j < count; j++)
+        {
+            float left = outL[j]*wet1 + outR[j]*wet2 + inputR[j]*dry;
+            float right = outR[j]*wet1 + outL[j]*wet2 + inputR[j]*dry;
+
+            if (mix)
+            {
+                outputL[j * skip] += left;
+                if (skip > 1)
+                    outputL[j * skip + 1] += right;
+            }
+            else
+            {
+                outputL[j * skip] = left;
+                if (skip > 1)
+                    outputL[j * skip + 1] = right;
+            }
+        }
+
+        inputL += count * skip;
+        outputL += count * skip;
+        numsamples -= count;
+    }
 }
 
 void revmodel::update()
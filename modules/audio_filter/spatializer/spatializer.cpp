@@ -163,6 +163,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->b_in_place = true;
     return VLC_SUCCESS;
 }
 
@@ -199,16 +200,13 @@ static void SpatFilter( filter_t *p_filter, float *out, float *in,
     filter_sys_t *p_sys = p_filter->p_sys;
     vlc_mutex_locker locker( &p_sys->lock );
 
-    for( unsigned i = 0; i < i_samples; i++ )
-    {
-        for( unsigned ch = 0 ; ch < 2; ch++)
-        {
-            in[ch] = in[ch] * SPAT_AMP;
-        }
-        p_sys->p_reverbm->processreplace( in, out , 1, i_channels);
-        in  += i_channels;
-        out += i_channels;
-    }
+    /* Only the first two channels are processed */
+    float gains[AOUT_CHAN_MAX];
+    for( unsigned ch = 0; ch < i_channels; ch++ )
+        gains[ch] = ch < 2 ? SPAT_AMP : 1.f;
+
+    dsp_ScaleChannels( in, gains, i_samples, i_channels );
+    p_sys->p_reverbm->processreplace( in, out, i_samples, i_channels );
 }
 
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
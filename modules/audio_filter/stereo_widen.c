@@ -154,6 +154,7 @@ static int Open( vlc_object_t *obj )
     }
 
     p_filter->pf_audio_filter = Filter;
+    p_filter->b_in_place = true;
     return VLC_SUCCESS;
 }
 
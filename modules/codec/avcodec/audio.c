@@ -37,6 +37,7 @@
 #include <vlc_avcodec.h>
 
 #include "avcodec.h"
+#include "../../audio_filter/dsp_convert.h"
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/mem.h>
@@ -479,18 +480,22 @@ static block_t * ConvertAVFrame( decoder_t *p_dec, AVFrame *frame )
     AVCodecContext *ctx = p_sys->p_context;
     block_t *p_block;
 
-    /* Interleave audio if required */
+    /* Interleave audio if required, converting it to the output format in
+     * the same pass */
     if( av_sample_fmt_is_planar( ctx->sample_fmt ) )
     {
-        p_block = block_Alloc(frame->linesize[0] * ctx->channels);
+        const vlc_fourcc_t i_format = p_dec->fmt_out.audio.i_format;
+        p_block = block_Alloc( frame->nb_samples * ctx->channels
+                               * aout_BitsPerSample( i_format ) / 8 );
         if ( likely(p_block) )
         {
             const void *planes[ctx->channels];
             for (int i = 0; i < ctx->channels; i++)
                 planes[i] = frame->extended_data[i];
 
-            aout_Interleave(p_block->p_buffer, planes, frame->nb_samples,
-                            ctx->channels, p_dec->fmt_out.audio.i_format);
+            dsp_InterleaveConvert( p_block->p_buffer, i_format, planes,
+                                   GetVlcAudioFormat( ctx->sample_fmt ),
+                                   frame->nb_samples, ctx->channels );
             p_block->i_nb_samples = frame->nb_samples;
         }
         av_frame_free(&frame);
@@ -573,6 +578,11 @@ static void SetupOutputFormat( decoder_t *p_dec, bool b_trust )
     decoder_sys_t *p_sys = p_dec->p_sys;
 
     p_dec->fmt_out.i_codec = GetVlcAudioFormat( p_sys->p_context->sample_fmt );
+    /* Planar U8 and S16 are losslessly converted to FL32 while interleaved,
+     * instead of by an audio converter in the output */
+    if( p_sys->p_context->sample_fmt == AV_SAMPLE_FMT_U8P
+     || p_sys->p_context->sample_fmt == AV_SAMPLE_FMT_S16P )
+        p_dec->fmt_out.i_codec = VLC_CODEC_FL32;
     p_dec->fmt_out.audio.channel_type = p_dec->fmt_in.audio.channel_type;
     p_dec->fmt_out.audio.i_format = p_dec->fmt_out.i_codec;
     p_dec->fmt_out.audio.i_rate = p_sys->p_context->sample_rate;
@@ -186,6 +186,9 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, mtime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t TSStreamTell( demux_sys_t *p_sys );
+static int TSStreamSeek( demux_sys_t *p_sys, uint64_t i_pos );
+static void TSStreamReset( demux_sys_t *p_sys );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, mtime_t );
@@ -198,6 +201,9 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_HEADER_SIZE 4
 
 #define PROBE_CHUNK_COUNT 500
+
+/* number of packets read from the stream at once */
+#define TS_READ_AHEAD 64
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
 
 static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_offset )
@@ -397,6 +403,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_ts_read = 50;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
+    p_sys->b_record = false;
 
     vlc_dictionary_init( &p_sys->attachments, 0 );
 
@@ -578,6 +585,8 @@ static void Close( vlc_object_t *p_this )
     /* Release all non default pids */
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
+    free( p_sys->readahead.p_buffer );
+
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
@@ -633,9 +642,11 @@ static int Demux( demux_t *p_demux )
             return VLC_DEMUXER_EOF;
         }
 
-        if( p_sys->b_start_record )
+        if( p_sys->b_start_record &&
+            p_sys->readahead.i_pos == p_sys->readahead.i_len )
         {
-            /* Enable recording once synchronized */
+            /* Enable recording once synchronized, and once the stream is
+             * back at the packet boundary (see ReadTSAhead()) */
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE, true,
                                 "ts" );
             p_sys->b_start_record = false;
@@ -944,7 +955,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSStreamTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -991,7 +1002,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TSStreamSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1128,9 +1139,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        TSStreamReset( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        TSStreamReset( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1157,6 +1170,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE,
                                 false );
         p_sys->b_start_record = b_bool;
+        p_sys->b_record = b_bool;
         return VLC_SUCCESS;
 
     case DEMUX_GET_SIGNAL:
@@ -1722,14 +1736,105 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
-static block_t* ReadTSPacket( demux_t *p_demux )
+/* Refills the read ahead buffer, keeping unread data, until it holds
+ * at least i_min bytes */
+static bool ReadTSAhead( demux_sys_t *p_sys, size_t i_min )
+{
+    const size_t i_size = TS_READ_AHEAD * p_sys->i_packet_size;
+    size_t i_left = p_sys->readahead.i_len - p_sys->readahead.i_pos;
+
+    if( unlikely(p_sys->readahead.p_buffer == NULL) )
+    {
+        p_sys->readahead.p_buffer = malloc( i_size );
+        if( !p_sys->readahead.p_buffer )
+            return false;
+    }
+
+    memmove( p_sys->readahead.p_buffer,
+             &p_sys->readahead.p_buffer[p_sys->readahead.i_pos], i_left );
+    p_sys->readahead.i_pos = 0;
+    p_sys->readahead.i_len = i_left;
+
+    /* The data read ahead from the former stream is consumed */
+    if( i_left == 0 && p_sys->readahead.p_next != NULL )
+    {
+        p_sys->stream = p_sys->readahead.p_next;
+        p_sys->readahead.p_next = NULL;
+    }
+
+    /* Do not read past the requested data while recording, or while
+     * switching to another stream, so that the buffer drains and the stream
+     * stays at the position of the next packet to demux: the recording
+     * starts and stops there, and the other stream starts there */
+    const size_t i_max = ( p_sys->b_record || p_sys->readahead.p_next )
+                       ? i_min : i_size;
+
+    /* Only wait for what is needed, so that live streams are not delayed */
+    while( p_sys->readahead.i_len < i_min )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                                &p_sys->readahead.p_buffer[p_sys->readahead.i_len],
+                                i_max - p_sys->readahead.i_len );
+        if( i_read <= 0 )
+            return false;
+        p_sys->readahead.i_len += i_read;
+    }
+    return true;
+}
+
+static uint64_t TSStreamTell( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) -
+           ( p_sys->readahead.i_len - p_sys->readahead.i_pos );
+}
+
+/* Drops the data read ahead, before the stream position changes */
+static void TSStreamReset( demux_sys_t *p_sys )
+{
+    p_sys->readahead.i_pos = p_sys->readahead.i_len = 0;
+    if( p_sys->readahead.p_next != NULL )
+    {
+        p_sys->stream = p_sys->readahead.p_next;
+        p_sys->readahead.p_next = NULL;
+    }
+}
+
+static int TSStreamSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    TSStreamReset( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+/* Switches to a stream filter of the source. The data read ahead from the
+ * source is read again through the filter if the source can seek, or
+ * demuxed before switching otherwise. */
+void TSStreamSwitch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    block_t     *p_pkt;
+    if( p_sys->readahead.i_pos < p_sys->readahead.i_len && p_sys->b_canseek )
+    {
+        uint64_t i_pos = TSStreamTell( p_sys );
+
+        if( vlc_stream_Seek( p_sys->stream, i_pos ) == VLC_SUCCESS )
+            p_sys->readahead.i_pos = p_sys->readahead.i_len = 0;
+    }
+
+    if( p_sys->readahead.i_pos < p_sys->readahead.i_len )
+        p_sys->readahead.p_next = s;
+    else
+        p_sys->stream = s;
+}
+
+static block_t* ReadTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_size = p_sys->i_packet_size;
+    const size_t i_header = p_sys->i_packet_header_size;
 
     /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    if( p_sys->readahead.i_len - p_sys->readahead.i_pos < i_size &&
+        !ReadTSAhead( p_sys, i_size ) )
     {
         int64_t size = stream_Size( p_sys->stream );
         if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
@@ -1739,62 +1844,66 @@ static block_t* ReadTSPacket( demux_t *p_demux )
         return NULL;
     }
 
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
-    {
-        block_Release( p_pkt );
-        return NULL;
-    }
-
-    /* Skip header (BluRay streams).
-     * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
-     * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
-     */
-    p_pkt->p_buffer += p_sys->i_packet_header_size;
-    p_pkt->i_buffer -= p_sys->i_packet_header_size;
-
     /* Check sync byte and re-sync if needed */
-    if( p_pkt->p_buffer[0] != 0x47 )
+    if( p_sys->readahead.p_buffer[p_sys->readahead.i_pos + i_header] != 0x47 )
     {
         msg_Warn( p_demux, "lost synchro" );
-        block_Release( p_pkt );
         for( ;; )
         {
-            const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
-
-            i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                    p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
+            /* Look for two consecutive sync bytes */
+            const size_t i_need = i_header + i_size + 1;
+            if( p_sys->readahead.i_len - p_sys->readahead.i_pos < i_need &&
+                !ReadTSAhead( p_sys, i_need ) )
             {
                 msg_Dbg( p_demux, "eof ?" );
                 return NULL;
             }
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
+            const uint8_t *p_peek = &p_sys->readahead.p_buffer[p_sys->readahead.i_pos];
+            const size_t i_peek = p_sys->readahead.i_len - p_sys->readahead.i_pos;
+            size_t i_skip = 0;
+
+            while( i_skip + i_need <= i_peek )
             {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
+                /* memchr() is vectorized by the C library */
+                const uint8_t *p_sync = memchr( &p_peek[i_skip + i_header], 0x47,
+                                                i_peek - i_need - i_skip + 1 );
+                if( p_sync == NULL )
+                {
+                    i_skip = i_peek - i_need + 1;
+                    break;
+                }
+                i_skip = p_sync - p_peek - i_header;
+                if( p_peek[i_skip + i_header + i_size] == 0x47 )
                 {
                     break;
                 }
                 i_skip++;
             }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-                return NULL;
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage", i_skip );
+            p_sys->readahead.i_pos += i_skip;
 
-            if( i_skip < i_peek - p_sys->i_packet_size )
+            if( i_skip + i_need <= i_peek )
             {
                 break;
             }
         }
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
-        {
-            msg_Dbg( p_demux, "eof ?" );
-            return NULL;
-        }
     }
+
+    block_t *p_pkt = block_Alloc( i_size );
+    if( unlikely(p_pkt == NULL) )
+        return NULL;
+    memcpy( p_pkt->p_buffer, &p_sys->readahead.p_buffer[p_sys->readahead.i_pos],
+            i_size );
+    p_sys->readahead.i_pos += i_size;
+
+    /* Skip header (BluRay streams).
+     * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
+     * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
+     */
+    p_pkt->p_buffer += i_header;
+    p_pkt->i_buffer -= i_header;
+
     return p_pkt;
 }
 
@@ -1904,13 +2013,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TSStreamSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1926,7 +2035,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TSStreamSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1940,7 +2049,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TSStreamTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -1997,7 +2106,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        vlc_stream_Seek( p_sys->stream, i_initial_pos );
+        TSStreamSeek( p_sys, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -2078,7 +2187,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TSStreamTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2106,7 +2215,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2119,7 +2228,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSStreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2129,7 +2238,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && (i_pcr == -1 || !b_found) &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSStreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2138,7 +2247,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSStreamTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2151,7 +2260,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSStreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2161,7 +2270,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && (i_pcr == -1 || !b_found) &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSStreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2212,14 +2321,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, mtime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSStreamTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSStreamTell( p_sys );
             }
         }
     }
@@ -63,6 +63,15 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* packets read ahead from the stream, see ReadTSPacket() */
+    struct
+    {
+        uint8_t *p_buffer;
+        size_t   i_pos;     /* next packet */
+        size_t   i_len;     /* valid bytes */
+        stream_t *p_next;   /* stream to read once the buffer is consumed */
+    } readahead;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -134,10 +143,13 @@ struct demux_sys_t
 
     /* */
     bool        b_start_record;
+    bool        b_record;
 };
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
 
+void TSStreamSwitch( demux_t *p_demux, stream_t *s );
+
 bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
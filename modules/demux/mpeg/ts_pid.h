@@ -79,19 +79,22 @@ struct ts_pid_t
 
 };
 
+/* two levels direct pid index: 128 slices of 64 pids, allocated on use */
+#define PID_INDEX_BITS  6
+#define PID_INDEX_SLICE (1 << PID_INDEX_BITS)
+#define PID_INDEX_MASK  (PID_INDEX_SLICE - 1)
+
 struct ts_pid_list_t
 {
     ts_pid_t   pat;
     ts_pid_t   dummy;
     ts_pid_t   base_si;
-    /* all non commons ones, dynamically allocated */
+    /* all non commons ones, dynamically allocated, sorted by pid */
     ts_pid_t **pp_all;
     int        i_all;
     int        i_all_alloc;
-    /* last recently used */
-    uint16_t   i_last_pid;
-    ts_pid_t  *p_last;
-
+    /* direct access to the non commons ones */
+    ts_pid_t **pp_index[0x2000 >> PID_INDEX_BITS];
 };
 
 /* opacified pid list */
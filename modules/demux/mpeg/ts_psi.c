@@ -1923,7 +1923,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
                 if ( p_sys->standard == TS_STANDARD_ARIB && !p_sys->arib.b25stream )
                 {
                     p_sys->arib.b25stream = vlc_stream_FilterNew( p_demux->s, "aribcam" );
-                    p_sys->stream = ( p_sys->arib.b25stream ) ? p_sys->arib.b25stream : p_demux->s;
+                    if( p_sys->arib.b25stream )
+                        TSStreamSwitch( p_demux, p_sys->arib.b25stream );
                 }
             }
         }
@@ -810,6 +810,16 @@ static int DrawStats(intf_thread_t *intf, input_thread_t *p_input)
             (float)(p_stats->i_read_bytes)/1024);
     MainBoxWrite(sys, l++, _("| input bitrate    :   %6.0f kb/s"),
             p_stats->f_input_bitrate*8000);
+
+    int64_t stream_reads = p_stats->i_stream_cache_hits
+                         + p_stats->i_stream_cache_misses;
+    if (stream_reads > 0)
+        MainBoxWrite(sys, l++, _("| reads cached     :    %5"PRIi64" (%.0f%%)"),
+                p_stats->i_stream_cache_hits,
+                100. * p_stats->i_stream_cache_hits / stream_reads);
+    if (p_stats->i_recv_calls > 0)
+        MainBoxWrite(sys, l++, _("| datagrams/call   :    %5.2f"),
+                (double)p_stats->i_recv_datagrams / p_stats->i_recv_calls);
     MainBoxWrite(sys, l++, _("| demux bytes read : %8.0f KiB"),
             (float)(p_stats->i_demux_read_bytes)/1024);
     MainBoxWrite(sys, l++, _("| demux bitrate    :   %6.0f kb/s"),
@@ -826,6 +836,22 @@ static int DrawStats(intf_thread_t *intf, input_thread_t *p_input)
                 p_stats->i_displayed_pictures);
         MainBoxWrite(sys, l++, _("| frames lost      :    %5"PRIi64),
                 p_stats->i_lost_pictures);
+        MainBoxWrite(sys, l++, _("| frames copied    :    %5"PRIi64" (%.1f/s)"),
+                p_stats->i_copied_pictures, p_stats->f_copy_rate);
+
+        int64_t spu_regions = p_stats->i_spu_cache_hits
+                            + p_stats->i_spu_cache_misses;
+        if (spu_regions > 0)
+            MainBoxWrite(sys, l++, _("| subtitles cached :    %5"PRIi64" (%.0f%%)"),
+                    p_stats->i_spu_cache_hits,
+                    100. * p_stats->i_spu_cache_hits / spu_regions);
+
+        /* 16 ms or more, see input_stats_LatencyBucket() */
+        int64_t late = 0;
+        for (unsigned i = 8; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+            late += p_stats->i_vout_latency[INPUT_STATS_VOUT_LATENESS][i];
+        MainBoxWrite(sys, l++, _("| frames late      :    %5"PRIi64),
+                late);
     }
     /* Audio*/
     if (i_audio) {
@@ -838,6 +864,8 @@ static int DrawStats(intf_thread_t *intf, input_thread_t *p_input)
                 p_stats->i_played_abuffers);
         MainBoxWrite(sys, l++, _("| buffers lost     :    %5"PRIi64),
                 p_stats->i_lost_abuffers);
+        MainBoxWrite(sys, l++, _("| buffers allocated:    %5"PRIi64),
+                p_stats->i_allocated_abuffers);
     }
     if (sys->color) color_set(C_DEFAULT, NULL);
 
@@ -205,6 +205,10 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( read_packets )
         STATS_INT( read_bytes )
         STATS_FLOAT( input_bitrate )
+        STATS_INT( stream_cache_hits )
+        STATS_INT( stream_cache_misses )
+        STATS_INT( recv_calls )
+        STATS_INT( recv_datagrams )
         STATS_INT( demux_read_packets )
         STATS_INT( demux_read_bytes )
         STATS_FLOAT( demux_bitrate )
@@ -214,8 +218,13 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( decoded_video )
         STATS_INT( displayed_pictures )
         STATS_INT( lost_pictures )
+        STATS_INT( copied_pictures )
+        STATS_FLOAT( copy_rate )
+        STATS_INT( spu_cache_hits )
+        STATS_INT( spu_cache_misses )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        STATS_INT( allocated_abuffers )
 #undef STATS_INT
 #undef STATS_FLOAT
     }
@@ -35,6 +35,17 @@
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
 
+/* A buffered range of the stream, stored in a circular buffer */
+typedef struct prefetch_extent
+{
+    uint64_t     offset;  /* stream offset of the first buffered byte */
+    size_t       length;  /* buffered bytes */
+    uint64_t     last;    /* stream offset where downstream left the range */
+    uint64_t     stamp;   /* last use, for least recently used replacement */
+    struct prefetch_extent *next; /* range read after this one, last time */
+    char        *buffer;  /* allocated on first use */
+} prefetch_extent_t;
+
 struct stream_sys_t
 {
     vlc_mutex_t  lock;
@@ -54,14 +65,120 @@ struct stream_sys_t
     int64_t      pts_delay;
     char        *content_type;
 
-    uint64_t     buffer_offset;
     uint64_t     stream_offset;
-    size_t       buffer_length;
-    size_t       buffer_size;
-    char        *buffer;
+    size_t       buffer_size; /* per extent */
     size_t       seek_threshold;
+    size_t       low_water;
+
+    prefetch_extent_t *extents;
+    unsigned     extent_count;
+    prefetch_extent_t *active; /* extent filled from upstream, if any */
+    prefetch_extent_t *reading; /* extent downstream last read from */
+    uint64_t     clock;
+
+    /* statistics */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long cached_seeks;
+    unsigned long upstream_seeks;
 };
 
+/**
+ * Finds the extent holding data at the given offset.
+ */
+static prefetch_extent_t *ExtentFind(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->extent_count; i++)
+    {
+        prefetch_extent_t *ext = &sys->extents[i];
+
+        if (offset >= ext->offset && offset - ext->offset < ext->length)
+            return ext;
+    }
+    return NULL;
+}
+
+/**
+ * Finds the extent whose buffered data ends at the given offset, if any.
+ */
+static prefetch_extent_t *ExtentFindEnd(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->extent_count; i++)
+    {
+        prefetch_extent_t *ext = &sys->extents[i];
+
+        if (ext->buffer != NULL && ext->offset + ext->length == offset)
+            return ext;
+    }
+    return NULL;
+}
+
+/**
+ * Selects the extent to reuse for a new range: an empty one if any,
+ * otherwise the least recently used one. The buffer of an extent is only
+ * allocated once the stream is actually read from that many ranges.
+ */
+static prefetch_extent_t *ExtentVictim(stream_sys_t *sys)
+{
+    prefetch_extent_t *victim = &sys->extents[0];
+
+    for (unsigned i = 0; i < sys->extent_count; i++)
+    {
+        prefetch_extent_t *ext = &sys->extents[i];
+
+        if (ext->buffer == NULL)
+        {
+            ext->buffer = malloc(sys->buffer_size);
+            if (ext->buffer == NULL)
+                break;
+            return ext;
+        }
+        if (ext->length == 0)
+            return ext;
+        if (ext->stamp < victim->stamp)
+            victim = ext;
+    }
+
+    /* Forget what was learnt about the range being replaced */
+    for (unsigned i = 0; i < sys->extent_count; i++)
+        if (sys->extents[i].next == victim)
+            sys->extents[i].next = NULL;
+    victim->next = NULL;
+    if (sys->reading == victim)
+        sys->reading = NULL;
+    return victim;
+}
+
+/**
+ * Computes the data of an extent that downstream already read, and which
+ * can be discarded to make room.
+ */
+static size_t ExtentHistory(const prefetch_extent_t *ext)
+{
+    if (ext->last <= ext->offset)
+        return 0;
+    if (ext->last - ext->offset >= ext->length)
+        return ext->length;
+    return ext->last - ext->offset;
+}
+
+/**
+ * Computes the buffered data that downstream has yet to read from an
+ * extent.
+ */
+static size_t ExtentLevel(const prefetch_extent_t *ext)
+{
+    return ext->length - ExtentHistory(ext);
+}
+
+/**
+ * Computes how much more data an extent can be filled with.
+ */
+static size_t ExtentRoom(const stream_sys_t *sys, const prefetch_extent_t *ext)
+{
+    return sys->buffer_size - ext->length + ExtentHistory(ext);
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -140,67 +257,109 @@ static void *Thread(void *data)
         }
 
         uint_fast64_t stream_offset = sys->stream_offset;
-
-        if (stream_offset < sys->buffer_offset)
-        {   /* Need to seek backward */
+        prefetch_extent_t *active = sys->active;
+        prefetch_extent_t *ext = ExtentFind(sys, stream_offset);
+
+        /* If the downstream offset is not far beyond the upstream offset,
+         * or if upstream cannot seek, read forward until there. */
+        if (ext == NULL && active != NULL
+         && stream_offset >= active->offset + active->length
+         && (!sys->can_seek || stream_offset - active->offset
+                          < active->length + sys->seek_threshold))
+            ext = active;
+        /* If downstream reached the end of another extent, extend it. */
+        if (ext == NULL)
+            ext = ExtentFindEnd(sys, stream_offset);
+
+        if (ext == NULL)
+        {   /* Not buffered anywhere: seek and start a new extent there,
+             * retaining the other extents, in case downstream comes back. */
+            sys->upstream_seeks++;
             if (ThreadSeek(stream, stream_offset) == 0)
             {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
+                ext = ExtentVictim(sys);
+                ext->offset = stream_offset;
+                ext->length = 0;
+                ext->last = stream_offset;
+                ext->stamp = ++sys->clock;
+                sys->active = ext;
                 assert(!sys->error);
                 sys->eof = false;
             }
             else
-            {
+            {   /* Seek failure is not necessarily fatal here. We could read
+                 * data instead until the desired seek offset. But in practice,
+                 * not all upstream accesses handle reads after failed seek
+                 * correctly. Furthermore, sys->stream_offset and/or
+                 * sys->paused might have changed in the mean time. */
                 sys->error = true;
                 vlc_cond_signal(&sys->wait_data);
             }
             continue;
         }
+        ext->last = stream_offset;
 
-        if (sys->eof)
-        {   /* Do not attempt to read at EOF - would busy loop */
-            vlc_cond_wait(&sys->wait_space, &sys->lock);
-            continue;
-        }
-
-        assert(stream_offset >= sys->buffer_offset);
+        /* Select the extent to fill. The extent downstream reads from comes
+         * first whenever it runs low. Otherwise, the extent downstream went
+         * to after this one the last time (if any) is topped up, so that it
+         * does not run dry when downstream switches over again. Failing
+         * that, the active extent is filled, as that needs no upstream
+         * seek. Other extents are not worth seeking for a few bytes. */
+        prefetch_extent_t *fill = ext;
 
-        /* As long as there is space, the buffer will retain already read
-         * ("historical") data. The data can be used if/when seeking backward.
-         * Unread data is however given precedence if the buffer is full. */
-        uint64_t history = stream_offset - sys->buffer_offset;
+        if (ExtentLevel(ext) >= sys->low_water)
+        {
+            prefetch_extent_t *next = ext->next;
+
+            if (next != NULL && next != ext && next != active
+             && ExtentLevel(next) < sys->low_water)
+                fill = next;
+            else if (active != NULL && active != ext && !sys->eof
+                  && ExtentRoom(sys, active) > 0)
+                fill = active;
+            else if (ext != active && ExtentRoom(sys, ext) < sys->low_water)
+            {   /* Wait for data to be read */
+                vlc_cond_wait(&sys->wait_space, &sys->lock);
+                continue;
+            }
+        }
 
-        /* If upstream supports seeking and if the downstream offset is far
-         * beyond the upstream offset, then attempt to skip forward.
-         * If it fails, assume upstream is well-behaved such that the failed
-         * seek is a no-op, and continue as if seeking was not supported.
-         * WARNING: Except problems with misbehaving access plug-ins. */
-        if (sys->can_seek
-         && history >= (sys->buffer_length + sys->seek_threshold))
+        if (fill != active)
         {
-            if (ThreadSeek(stream, stream_offset) == 0)
+            if (ExtentRoom(sys, fill) == 0)
+            {   /* Wait for data to be read */
+                vlc_cond_wait(&sys->wait_space, &sys->lock);
+                continue;
+            }
+
+            sys->upstream_seeks++;
+            if (ThreadSeek(stream, fill->offset + fill->length) == 0)
             {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                assert(!sys->eof);
+                sys->active = fill;
+                sys->eof = false;
             }
             else
-            {   /* Seek failure is not necessarily fatal here. We could read
-                 * data instead until the desired seek offset. But in practice,
-                 * not all upstream accesses handle reads after failed seek
-                 * correctly. Furthermore, sys->stream_offset and/or
-                 * sys->paused might have changed in the mean time. */
+            {
                 sys->error = true;
                 vlc_cond_signal(&sys->wait_data);
             }
             continue;
         }
+        ext = fill;
 
-        assert(sys->buffer_size >= sys->buffer_length);
+        /* Data already read ("historical" data) is retained as long as there
+         * is space, as downstream might seek back to it. */
+        size_t history = ExtentHistory(ext);
 
-        size_t len = sys->buffer_size - sys->buffer_length;
+        if (sys->eof)
+        {   /* Do not attempt to read at EOF - would busy loop */
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
+        assert(sys->buffer_size >= ext->length);
+
+        size_t len = sys->buffer_size - ext->length;
         if (len == 0)
         {   /* Buffer is full */
             if (history == 0)
@@ -212,18 +371,16 @@ static void *Thread(void *data)
             /* Discard some historical data to make room. */
             len = history;
 
-            assert(len <= sys->buffer_length);
-            sys->buffer_offset += len;
-            sys->buffer_length -= len;
+            ext->offset += len;
+            ext->length -= len;
         }
 
-        size_t offset = (sys->buffer_offset + sys->buffer_length)
-                        % sys->buffer_size;
+        size_t offset = (ext->offset + ext->length) % sys->buffer_size;
          /* Do not step past the sharp edge of the circular buffer */
         if (offset + len > sys->buffer_size)
             len = sys->buffer_size - offset;
 
-        ssize_t val = ThreadRead(stream, sys->buffer + offset, len);
+        ssize_t val = ThreadRead(stream, ext->buffer + offset, len);
         if (val < 0)
             continue;
         if (val == 0)
@@ -234,10 +391,8 @@ static void *Thread(void *data)
         }
 
         assert((size_t)val <= len);
-        sys->buffer_length += val;
-        assert(sys->buffer_length <= sys->buffer_size);
-        //msg_Dbg(stream, "buffer: %zu/%zu", sys->buffer_length,
-        //        sys->buffer_size);
+        ext->length += val;
+        assert(ext->length <= sys->buffer_size);
         vlc_cond_signal(&sys->wait_data);
     }
     vlc_assert_unreachable();
@@ -250,6 +405,12 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    prefetch_extent_t *ext = ExtentFind(sys, offset);
+    if (ext != NULL)
+    {
+        ext->last = offset;
+        sys->cached_seeks++;
+    }
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -257,25 +418,30 @@ static int Seek(stream_t *stream, uint64_t offset)
     return 0;
 }
 
-static size_t BufferLevel(const stream_t *stream, bool *eof)
+static size_t BufferLevel(const stream_t *stream, prefetch_extent_t **pext,
+                          bool *eof)
 {
     stream_sys_t *sys = stream->p_sys;
+    prefetch_extent_t *ext = ExtentFind(sys, sys->stream_offset);
 
+    *pext = ext;
     *eof = false;
 
-    if (sys->stream_offset < sys->buffer_offset)
-        return 0;
-    if ((sys->stream_offset - sys->buffer_offset) >= sys->buffer_length)
+    if (ext == NULL)
     {
-        *eof = sys->eof;
+        const prefetch_extent_t *active = sys->active;
+
+        *eof = sys->eof && active != NULL
+            && sys->stream_offset >= active->offset + active->length;
         return 0;
     }
-    return sys->buffer_offset + sys->buffer_length - sys->stream_offset;
+    return ext->offset + ext->length - sys->stream_offset;
 }
 
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
+    prefetch_extent_t *ext;
     size_t copy, offset;
     bool eof;
 
@@ -290,7 +456,18 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_cond_signal(&sys->wait_space);
     }
 
-    while ((copy = BufferLevel(stream, &eof)) == 0 && !eof)
+    if ((copy = BufferLevel(stream, &ext, &eof)) > 0 || eof)
+    {
+        sys->hits++;
+        vlc_stream_AddStats(stream, VLC_STREAM_STAT_CACHE_HITS, 1);
+    }
+    else
+    {
+        sys->misses++;
+        vlc_stream_AddStats(stream, VLC_STREAM_STAT_CACHE_MISSES, 1);
+    }
+
+    while (copy == 0 && !eof)
     {
         void *data[2];
 
@@ -303,17 +480,33 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_interrupt_forward_start(sys->interrupt, data);
         vlc_cond_wait(&sys->wait_data, &sys->lock);
         vlc_interrupt_forward_stop(data);
+        copy = BufferLevel(stream, &ext, &eof);
     }
 
-    offset = sys->stream_offset % sys->buffer_size;
-    if (copy > buflen)
-        copy = buflen;
-    /* Do not step past the sharp edge of the circular buffer */
-    if (offset + copy > sys->buffer_size)
-        copy = sys->buffer_size - offset;
-
-    memcpy(buf, sys->buffer + offset, copy);
-    sys->stream_offset += copy;
+    if (copy > 0)
+    {
+        offset = sys->stream_offset % sys->buffer_size;
+        if (copy > buflen)
+            copy = buflen;
+        /* Do not step past the sharp edge of the circular buffer */
+        if (offset + copy > sys->buffer_size)
+            copy = sys->buffer_size - offset;
+
+        memcpy(buf, ext->buffer + offset, copy);
+        ext->stamp = ++sys->clock;
+        sys->stream_offset += copy;
+        ext->last = sys->stream_offset;
+
+        /* Learn the order in which downstream goes through the extents,
+         * e.g. alternating between the audio and the video data of a file
+         * that is not interleaved. */
+        if (sys->reading != ext)
+        {
+            if (sys->reading != NULL)
+                sys->reading->next = ext;
+            sys->reading = ext;
+        }
+    }
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -422,11 +615,20 @@ static int Open(vlc_object_t *obj)
     sys->eof = false;
     sys->error = false;
     sys->paused = false;
-    sys->buffer_offset = 0;
     sys->stream_offset = 0;
-    sys->buffer_length = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->extents = NULL;
+    sys->extent_count = var_InheritInteger(obj, "prefetch-extents");
+    sys->active = NULL;
+    sys->reading = NULL;
+    sys->clock = 0;
+    sys->hits = sys->misses = 0;
+    sys->cached_seeks = sys->upstream_seeks = 0;
+
+    /* Extents only help if upstream can seek back and forth. */
+    if (!sys->can_seek || sys->extent_count == 0)
+        sys->extent_count = 1;
 
     uint64_t size = stream_Size(stream->s);
     if (size > 0)
@@ -434,9 +636,17 @@ static int Open(vlc_object_t *obj)
         if (sys->buffer_size > size)
             sys->buffer_size = size;
     }
+    /* Refill the extent downstream reads from below a quarter of a buffer */
+    sys->low_water = sys->buffer_size / 4;
+
+    sys->extents = calloc(sys->extent_count, sizeof (*sys->extents));
+    if (sys->extents == NULL)
+        goto error;
 
-    sys->buffer = malloc(sys->buffer_size);
-    if (sys->buffer == NULL)
+    /* Start filling the first extent from the initial upstream offset */
+    sys->active = &sys->extents[0];
+    sys->active->buffer = malloc(sys->buffer_size);
+    if (sys->active->buffer == NULL)
         goto error;
 
     sys->interrupt = vlc_interrupt_create();
@@ -458,13 +668,19 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
+    msg_Dbg(stream, "using %u extent(s) of %zu bytes", sys->extent_count,
+            sys->buffer_size);
     stream->pf_read = Read;
     stream->pf_control = Control;
     return VLC_SUCCESS;
 
 error:
-    free(sys->buffer);
+    if (sys->extents != NULL)
+    {
+        for (unsigned i = 0; i < sys->extent_count; i++)
+            free(sys->extents[i].buffer);
+        free(sys->extents);
+    }
     free(sys->content_type);
     free(sys);
     return VLC_ENOMEM;
@@ -487,7 +703,13 @@ static void Close (vlc_object_t *obj)
     vlc_cond_destroy(&sys->wait_data);
     vlc_mutex_destroy(&sys->lock);
 
-    free(sys->buffer);
+    msg_Dbg(stream, "%lu reads from buffer, %lu reads waiting for data, "
+            "%lu seeks within buffer, %lu upstream seeks", sys->hits,
+            sys->misses, sys->cached_seeks, sys->upstream_seeks);
+
+    for (unsigned i = 0; i < sys->extent_count; i++)
+        free(sys->extents[i].buffer);
+    free(sys->extents);
     free(sys->content_type);
     free(sys);
 }
@@ -507,4 +729,10 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-extents", 4, N_("Buffered ranges"),
+                N_("Number of distinct stream ranges buffered, each with "
+                   "its own buffer of the prefetch buffer size, so that "
+                   "seeking back and forth between them does not discard "
+                   "data"), true)
+        change_integer_range(1, 64)
 vlc_module_end()
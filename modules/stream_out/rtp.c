@@ -137,6 +137,15 @@
     "Default caching value for outbound RTP streams. This " \
     "value should be set in milliseconds." )
 
+#define BATCH_TEXT N_("Transmit batch size")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of RTP packets sent with a single system call " \
+    "(1 disables batching)." )
+#define BATCH_WINDOW_TEXT N_("Transmit batch window (us)")
+#define BATCH_WINDOW_LONGTEXT N_( \
+    "RTP packets due within this delay after the first packet of a batch " \
+    "are sent along with it." )
+
 #define PROTO_TEXT N_("Transport protocol")
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
@@ -182,6 +191,7 @@ static void Close( vlc_object_t * );
 
 #define SOUT_CFG_PREFIX "sout-rtp-"
 #define MAX_EMPTY_BLOCKS 200
+#define MAX_BATCH 64
 
 vlc_module_begin ()
     set_shortname( N_("RTP"))
@@ -227,6 +237,12 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000,
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+#ifdef HAVE_SENDMMSG
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 16, 1, MAX_BATCH,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch-window", 0, 0, 100000,
+                            BATCH_WINDOW_TEXT, BATCH_WINDOW_LONGTEXT, true )
+#endif
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -264,6 +280,9 @@ static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "url", "email",
     "proto", "rtcp-mux", "caching",
+#ifdef HAVE_SENDMMSG
+    "batch", "batch-window",
+#endif
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -385,6 +404,14 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     int64_t           i_caching;
+
+#ifdef HAVE_SENDMMSG
+    /* Batched transmit (sender thread only) */
+    unsigned          i_batch;
+    mtime_t           i_batch_window;
+    struct mmsghdr    msgv[MAX_BATCH];
+    struct iovec      iov[MAX_BATCH];
+#endif
 };
 
 /*****************************************************************************
@@ -982,6 +1009,17 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     id->b_first_packet = true;
     id->i_caching =
         (int64_t)1000 * var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching");
+#ifdef HAVE_SENDMMSG
+    id->i_batch = var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch" );
+    id->i_batch_window = var_GetInteger( p_stream,
+                                         SOUT_CFG_PREFIX "batch-window" );
+    memset( id->msgv, 0, sizeof (id->msgv) );
+    for( unsigned i = 0; i < MAX_BATCH; i++ )
+    {
+        id->msgv[i].msg_hdr.msg_iov = &id->iov[i];
+        id->msgv[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1182,7 +1220,7 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
         id->rtsp_id = RtspAddId( p_sys->rtsp, id, GetDWBE( id->ssrc ),
                                  id->rtp_fmt.clock_rate, mcast_fd );
 
-    id->p_fifo = block_FifoNew();
+    id->p_fifo = block_FifoNewLockless();
     if( unlikely(id->p_fifo == NULL) )
         goto error;
     if( vlc_clone( &id->thread, ThreadSend, id, VLC_THREAD_PRIORITY_HIGHEST ) )
@@ -1392,13 +1430,89 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/**
+ * Handles a failure to send a packet to a sink.
+ * @return true if the sink is dead, false if the error can be ignored.
+ */
+static bool rtp_send_error( int fd, const block_t *out )
+{
+    if( net_errno == EAGAIN || net_errno == EWOULDBLOCK
+     || net_errno == ENOBUFS || net_errno == ENOMEM )
+        return false;
+
+    int type;
+    getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &(socklen_t){ sizeof(type) });
+    if( type == SOCK_DGRAM )
+    {   /* ICMP soft error: ignore and retry */
+        send( fd, out->p_buffer, out->i_buffer, 0 );
+        return false;
+    }
+    return true; /* Broken connection */
+}
+
+#ifdef HAVE_SENDMMSG
+/**
+ * Sends a batch of packets to a sink with as few system calls as possible.
+ * @return true if the sink is dead.
+ */
+static bool rtp_send_batch( sout_stream_id_sys_t *id, int fd,
+                            block_t *const *outv, unsigned count )
+{
+    for( unsigned sent = 0; sent < count; )
+    {
+        int val = sendmmsg( fd, id->msgv + sent, count - sent, 0 );
+        if( val == -1 )
+        {
+            if( rtp_send_error( fd, outv[sent] ) )
+                return true;
+            val = 1; /* skip the failed packet */
+        }
+        sent += val;
+    }
+    return false;
+}
+#endif
+
+#ifdef HAVE_SRTP
+/**
+ * Encrypts an RTP packet if SRTP is enabled.
+ * @return the packet to send, or NULL if it was dropped.
+ */
+static block_t *rtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    if( id->srtp == NULL )
+        return out;
+
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     unsigned i_caching = id->i_caching;
 
@@ -1408,25 +1522,7 @@ static void* ThreadSend( void *data )
         block_cleanup_push (out);
 
 #ifdef HAVE_SRTP
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
-        }
+        out = rtp_protect( id, out );
         if (out)
             mwait (out->i_dts + i_caching);
         vlc_cleanup_pop ();
@@ -1437,38 +1533,68 @@ static void* ThreadSend( void *data )
         vlc_cleanup_pop ();
 #endif
 
-        ssize_t len = out->i_buffer;
+        block_t *outv[MAX_BATCH] = { out };
+        unsigned outc = 1;
         int canc = vlc_savecancel ();
 
+#ifdef HAVE_SENDMMSG
+        /* Gather the packets due within the batch window */
+        mtime_t limit = __MAX(out->i_dts + i_caching, mdate())
+                      + id->i_batch_window;
+        while( outc < id->i_batch )
+        {
+            block_t *next = block_FifoShow( id->p_fifo );
+
+            if( next == NULL || next->i_dts + i_caching > limit )
+                break;
+            next = block_FifoGet( id->p_fifo );
+# ifdef HAVE_SRTP
+            next = rtp_protect( id, next );
+            if( next == NULL )
+                continue;
+# endif
+            outv[outc++] = next;
+        }
+
+        for( unsigned j = 0; j < outc; j++ )
+        {
+            id->iov[j].iov_base = outv[j]->p_buffer;
+            id->iov[j].iov_len = outv[j]->i_buffer;
+        }
+#endif
+
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
 
         for( int i = 0; i < id->sinkc; i++ )
         {
+            int fd = id->sinkv[i].rtp_fd;
+            bool dead = false;
+
+            for( unsigned j = 0; j < outc; j++ )
 #ifdef HAVE_SRTP
-            if( !id->srtp ) /* FIXME: SRTCP support */
+                if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                    SendRTCP( id->sinkv[i].rtcp, outv[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+#ifdef HAVE_SENDMMSG
+            if( outc > 1 )
+                dead = rtp_send_batch( id, fd, outv, outc );
+            else
+#endif
+            if( send( fd, out->p_buffer, out->i_buffer, 0 ) == -1 )
+                dead = rtp_send_error( fd, out );
+
+            if( dead )
+                deadv[deadc++] = fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next =
+            ntohs(((uint16_t *) outv[outc - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        for( unsigned j = 0; j < outc; j++ )
+            block_Release( outv[j] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
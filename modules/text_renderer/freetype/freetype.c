@@ -111,6 +111,13 @@ static void Destroy( vlc_object_t * );
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
 
+#define CACHE_TEXT N_("Glyph cache size")
+#define CACHE_LONGTEXT N_("Memory used to keep loaded and rendered glyphs " \
+    "for the next subtitles, in kilobytes. 0 disables the cache.")
+#define SHAPING_CACHE_TEXT N_("Shaping cache size")
+#define SHAPING_CACHE_LONGTEXT N_("Memory used to keep shaped text " \
+    "for the next subtitles, in kilobytes. 0 disables the cache.")
+
 #define YUVP_TEXT N_("Use YUVP renderer")
 #define YUVP_LONGTEXT N_("This renders the font using \"paletized YUV\". " \
   "This option is only needed if you want to encode into DVB subtitles" )
@@ -214,6 +221,13 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-cache-size", 4096, 0, 65536,
+                            CACHE_TEXT, CACHE_LONGTEXT, true )
+#ifdef HAVE_HARFBUZZ
+    add_integer_with_range( "freetype-shaping-cache-size", 512, 0, 65536,
+                            SHAPING_CACHE_TEXT, SHAPING_CACHE_LONGTEXT, true )
+#endif
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -1421,6 +1435,18 @@ static int Create( vlc_object_t *p_this )
         p_sys->p_stroker = NULL;
     }
 
+    /* Caches of glyphs and shaped text, reused across subtitles */
+    int i_cache_size = var_InheritInteger( p_filter, "freetype-cache-size" );
+    if( i_cache_size > 0 )
+        p_sys->p_glyph_cache = LRUCache_New( (size_t)i_cache_size << 10,
+                                             ReleaseCachedGlyph );
+#ifdef HAVE_HARFBUZZ
+    i_cache_size = var_InheritInteger( p_filter, "freetype-shaping-cache-size" );
+    if( i_cache_size > 0 )
+        p_sys->p_shaping_cache = LRUCache_New( (size_t)i_cache_size << 10,
+                                               free );
+#endif
+
     /* Dictionnaries for fonts and families */
     vlc_dictionary_init( &p_sys->face_map, 50 );
     vlc_dictionary_init( &p_sys->family_map, 50 );
@@ -1575,6 +1601,12 @@ static void Destroy( vlc_object_t *p_this )
         ReleaseDWrite( p_filter );
 #endif
 
+    /* Caches */
+    if( p_sys->p_glyph_cache )
+        LRUCache_Delete( p_sys->p_glyph_cache );
+    if( p_sys->p_shaping_cache )
+        LRUCache_Delete( p_sys->p_shaping_cache );
+
     /* Freetype */
     if( p_sys->p_stroker )
         FT_Stroker_Done( p_sys->p_stroker );
@@ -42,6 +42,8 @@
 #include <vlc_text_style.h>                             /* text_style_t */
 #include <vlc_arrays.h>                                 /* vlc_dictionary_t */
 
+#include "lru_cache.h"
+
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
@@ -116,6 +118,12 @@ struct filter_sys_t
     /* Current scaling of the text, default is 100 (%) */
     int               i_scale;
 
+    /** Loaded and rendered glyphs, NULL if disabled */
+    lru_cache_t      *p_glyph_cache;
+
+    /** Shaped runs of text, NULL if disabled */
+    lru_cache_t      *p_shaping_cache;
+
     /**
      * Select a font, based on the family, the styles and the codepoint
      */
@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * lru_cache.c : Size bounded least recently used cache
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Size bounded least recently used cache
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "lru_cache.h"
+
+typedef struct lru_entry_t lru_entry_t;
+
+struct lru_entry_t
+{
+    lru_entry_t *p_hash_next;   /**< Next entry in the same bucket */
+    lru_entry_t *p_prev;        /**< More recently used entry */
+    lru_entry_t *p_next;        /**< Less recently used entry */
+    void        *p_value;
+    size_t       i_size;
+    uint32_t     i_hash;
+    size_t       i_key_size;
+    unsigned char key[];
+};
+
+struct lru_cache_t
+{
+    lru_entry_t **pp_buckets;
+    unsigned      i_buckets;    /**< Power of 2 */
+    unsigned      i_count;
+
+    lru_entry_t  *p_first;      /**< Most recently used entry */
+    lru_entry_t  *p_last;       /**< Least recently used entry */
+
+    size_t        i_size;
+    size_t        i_max_size;
+    void        (*pf_release)( void * );
+};
+
+/* FNV-1a */
+static uint32_t Hash( const void *p_key, size_t i_key_size )
+{
+    const unsigned char *p = p_key;
+    uint32_t i_hash = 2166136261u;
+
+    for( size_t i = 0; i < i_key_size; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= 16777619u;
+    }
+    return i_hash;
+}
+
+lru_cache_t *LRUCache_New( size_t i_max_size, void (*pf_release)( void * ) )
+{
+    lru_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( unlikely(!p_cache) )
+        return NULL;
+
+    p_cache->i_buckets = 64;
+    p_cache->pp_buckets = calloc( p_cache->i_buckets,
+                                  sizeof( *p_cache->pp_buckets ) );
+    if( unlikely(!p_cache->pp_buckets) )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    p_cache->i_max_size = i_max_size;
+    p_cache->pf_release = pf_release;
+    return p_cache;
+}
+
+static void Unlink( lru_cache_t *p_cache, lru_entry_t *p_entry )
+{
+    if( p_entry->p_prev )
+        p_entry->p_prev->p_next = p_entry->p_next;
+    else
+        p_cache->p_first = p_entry->p_next;
+    if( p_entry->p_next )
+        p_entry->p_next->p_prev = p_entry->p_prev;
+    else
+        p_cache->p_last = p_entry->p_prev;
+}
+
+static void LinkFirst( lru_cache_t *p_cache, lru_entry_t *p_entry )
+{
+    p_entry->p_prev = NULL;
+    p_entry->p_next = p_cache->p_first;
+    if( p_cache->p_first )
+        p_cache->p_first->p_prev = p_entry;
+    else
+        p_cache->p_last = p_entry;
+    p_cache->p_first = p_entry;
+}
+
+static void Remove( lru_cache_t *p_cache, lru_entry_t *p_entry )
+{
+    lru_entry_t **pp = &p_cache->pp_buckets[p_entry->i_hash
+                                            & (p_cache->i_buckets - 1)];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    Unlink( p_cache, p_entry );
+    p_cache->i_size -= p_entry->i_size;
+    p_cache->i_count--;
+
+    p_cache->pf_release( p_entry->p_value );
+    free( p_entry );
+}
+
+/* Doubles the bucket count, keeping chains short as the cache grows */
+static void Grow( lru_cache_t *p_cache )
+{
+    unsigned i_buckets = p_cache->i_buckets * 2;
+    lru_entry_t **pp_buckets = calloc( i_buckets, sizeof( *pp_buckets ) );
+    if( !pp_buckets )
+        return; /* longer chains, still working */
+
+    for( unsigned i = 0; i < p_cache->i_buckets; i++ )
+    {
+        for( lru_entry_t *p_entry = p_cache->pp_buckets[i]; p_entry; )
+        {
+            lru_entry_t *p_next = p_entry->p_hash_next;
+            lru_entry_t **pp = &pp_buckets[p_entry->i_hash & (i_buckets - 1)];
+            p_entry->p_hash_next = *pp;
+            *pp = p_entry;
+            p_entry = p_next;
+        }
+    }
+    free( p_cache->pp_buckets );
+    p_cache->pp_buckets = pp_buckets;
+    p_cache->i_buckets = i_buckets;
+}
+
+void LRUCache_Delete( lru_cache_t *p_cache )
+{
+    for( lru_entry_t *p_entry = p_cache->p_first; p_entry; )
+    {
+        lru_entry_t *p_next = p_entry->p_next;
+        p_cache->pf_release( p_entry->p_value );
+        free( p_entry );
+        p_entry = p_next;
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+static lru_entry_t *Find( lru_cache_t *p_cache, uint32_t i_hash,
+                          const void *p_key, size_t i_key_size )
+{
+    for( lru_entry_t *p_entry =
+            p_cache->pp_buckets[i_hash & (p_cache->i_buckets - 1)];
+         p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->i_hash == i_hash && p_entry->i_key_size == i_key_size
+         && !memcmp( p_entry->key, p_key, i_key_size ) )
+            return p_entry;
+    }
+    return NULL;
+}
+
+void *LRUCache_Get( lru_cache_t *p_cache, const void *p_key, size_t i_key_size )
+{
+    lru_entry_t *p_entry = Find( p_cache, Hash( p_key, i_key_size ),
+                                 p_key, i_key_size );
+    if( !p_entry )
+        return NULL;
+
+    if( p_entry != p_cache->p_first )
+    {
+        Unlink( p_cache, p_entry );
+        LinkFirst( p_cache, p_entry );
+    }
+    return p_entry->p_value;
+}
+
+void LRUCache_Put( lru_cache_t *p_cache, const void *p_key, size_t i_key_size,
+                   void *p_value, size_t i_size )
+{
+    i_size += sizeof( lru_entry_t ) + i_key_size;
+    if( i_size > p_cache->i_max_size )
+    {
+        p_cache->pf_release( p_value );
+        return;
+    }
+
+    uint32_t i_hash = Hash( p_key, i_key_size );
+    lru_entry_t *p_old = Find( p_cache, i_hash, p_key, i_key_size );
+    if( p_old )
+        Remove( p_cache, p_old );
+
+    while( p_cache->i_size + i_size > p_cache->i_max_size )
+        Remove( p_cache, p_cache->p_last );
+
+    lru_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key_size );
+    if( unlikely(!p_entry) )
+    {
+        p_cache->pf_release( p_value );
+        return;
+    }
+
+    if( p_cache->i_count >= p_cache->i_buckets )
+        Grow( p_cache );
+
+    p_entry->p_value = p_value;
+    p_entry->i_size = i_size;
+    p_entry->i_hash = i_hash;
+    p_entry->i_key_size = i_key_size;
+    memcpy( p_entry->key, p_key, i_key_size );
+
+    lru_entry_t **pp = &p_cache->pp_buckets[i_hash & (p_cache->i_buckets - 1)];
+    p_entry->p_hash_next = *pp;
+    *pp = p_entry;
+    LinkFirst( p_cache, p_entry );
+
+    p_cache->i_size += i_size;
+    p_cache->i_count++;
+}
+
+/** @} */
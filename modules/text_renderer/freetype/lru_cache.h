@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * lru_cache.h : Size bounded least recently used cache
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Size bounded least recently used cache
+ *
+ * Values are stored under keys compared as raw bytes, so keys must not
+ * contain uninitialized padding. When adding a value would exceed the
+ * maximum size, the least recently used values are released first.
+ */
+
+typedef struct lru_cache_t lru_cache_t;
+
+/**
+ * Creates a cache.
+ *
+ * \param i_max_size maximum accumulated size of the values [IN]
+ * \param pf_release callback releasing a value [IN]
+ * \return the cache, or NULL on allocation error
+ */
+lru_cache_t *LRUCache_New( size_t i_max_size, void (*pf_release)( void * ) );
+
+/**
+ * Releases all values and destroys the cache.
+ */
+void LRUCache_Delete( lru_cache_t *p_cache );
+
+/**
+ * Looks up a value, and marks it as the most recently used on success.
+ *
+ * \return the value, or NULL if not cached. The value remains valid until
+ * the next call to LRUCache_Put().
+ */
+void *LRUCache_Get( lru_cache_t *p_cache, const void *p_key, size_t i_key_size );
+
+/**
+ * Adds a value to the cache, which takes ownership of it.
+ *
+ * The value is released immediately if it is larger than the cache
+ * or on error.
+ *
+ * \param i_size size of the value, accounted against the maximum size [IN]
+ */
+void LRUCache_Put( lru_cache_t *p_cache, const void *p_key, size_t i_key_size,
+                   void *p_value, size_t i_size );
+
+/** @} */
+
+#endif
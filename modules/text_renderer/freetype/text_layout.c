@@ -111,10 +111,44 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    void                       *p_shaped;   /**< Copy of a cached shaped run */
 #endif
 
 } run_desc_t;
 
+/**
+ * Key of a glyph in the glyph cache. Faces are loaded for a single size,
+ * so the face and glyph index identify the glyph, to which synthetic
+ * styles and the outline stroker were applied. Bitmaps rendered from the
+ * glyph or its outline are keyed by the subpixel part of their origin.
+ * Keys are compared as raw bytes and must not contain padding.
+ */
+typedef struct glyph_key_t
+{
+    FT_Face  p_face;
+    unsigned i_glyph_index;
+    int      i_style_flags;     /**< Synthetic STYLE_BOLD, STYLE_ITALIC, STYLE_OUTLINE */
+    int      i_outline_radius;
+    int      i_bitmap;          /**< GLYPH_KEY_* */
+    int      i_x_origin;        /**< 26.6 subpixel origin of bitmaps */
+    int      i_y_origin;
+} glyph_key_t;
+
+#define GLYPH_KEY_OUTLINES 0
+#define GLYPH_KEY_GLYPH    1
+#define GLYPH_KEY_OUTLINE  2
+
+/**
+ * Value of the glyph cache: the glyph and its outline as loaded and
+ * stroked, or a single rendered bitmap.
+ */
+typedef struct cached_glyph_t
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_glyph_t;
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -130,6 +164,7 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_key_t key;
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -731,6 +766,53 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
 }
 
 #ifdef HAVE_HARFBUZZ
+/**
+ * Key of a run in the shaping cache, followed by the code points of the run
+ */
+typedef struct shaping_key_t
+{
+    FT_Face             p_face;
+    hb_direction_t      direction;
+    hb_script_t         script;
+} shaping_key_t;
+
+/**
+ * Glyphs and positions of a shaped run, allocated along with the structure
+ */
+typedef struct shaped_run_t
+{
+    unsigned int         i_glyph_count;
+    hb_glyph_info_t     *p_glyph_infos;
+    hb_glyph_position_t *p_glyph_positions;
+} shaped_run_t;
+
+static size_t ShapedRunSize( const shaped_run_t *p_shaped )
+{
+    return sizeof( *p_shaped ) + p_shaped->i_glyph_count
+         * ( sizeof( hb_glyph_info_t ) + sizeof( hb_glyph_position_t ) );
+}
+
+static shaped_run_t *NewShapedRun( unsigned int i_glyph_count,
+                                   const hb_glyph_info_t *p_glyph_infos,
+                                   const hb_glyph_position_t *p_glyph_positions )
+{
+    shaped_run_t *p_shaped = malloc( sizeof( *p_shaped ) + i_glyph_count
+                                     * ( sizeof( *p_glyph_infos )
+                                       + sizeof( *p_glyph_positions ) ) );
+    if( !p_shaped )
+        return NULL;
+
+    p_shaped->i_glyph_count = i_glyph_count;
+    p_shaped->p_glyph_positions = (hb_glyph_position_t *) ( p_shaped + 1 );
+    p_shaped->p_glyph_infos =
+        (hb_glyph_info_t *) ( p_shaped->p_glyph_positions + i_glyph_count );
+    memcpy( p_shaped->p_glyph_infos, p_glyph_infos,
+            i_glyph_count * sizeof( *p_glyph_infos ) );
+    memcpy( p_shaped->p_glyph_positions, p_glyph_positions,
+            i_glyph_count * sizeof( *p_glyph_positions ) );
+    return p_shaped;
+}
+
 /**
  * Shape an itemized paragraph using HarfBuzz.
  * This is where the glyphs of complex scripts get their positions
@@ -784,11 +866,42 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        shaping_key_t *p_key = NULL;
+        size_t i_key_size = sizeof( *p_key ) + sizeof( uni_char_t ) *
+                            ( p_run->i_end_offset - p_run->i_start_offset );
+        if( p_sys->p_shaping_cache )
+            p_key = calloc( 1, i_key_size );
+        if( p_key )
+        {
+            p_key->p_face = p_face;
+            p_key->direction = p_run->direction;
+            p_key->script = p_run->script;
+            memcpy( p_key + 1, p_paragraph->p_code_points + p_run->i_start_offset,
+                    i_key_size - sizeof( *p_key ) );
+
+            const shaped_run_t *p_cached =
+                LRUCache_Get( p_sys->p_shaping_cache, p_key, i_key_size );
+            shaped_run_t *p_shaped = p_cached ?
+                NewShapedRun( p_cached->i_glyph_count, p_cached->p_glyph_infos,
+                              p_cached->p_glyph_positions ) : NULL;
+            if( p_shaped )
+            {
+                free( p_key );
+                p_run->p_shaped = p_shaped;
+                p_run->p_glyph_infos = p_shaped->p_glyph_infos;
+                p_run->p_glyph_positions = p_shaped->p_glyph_positions;
+                p_run->i_glyph_count = p_shaped->i_glyph_count;
+                i_total_glyphs += p_run->i_glyph_count;
+                continue;
+            }
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_ft_font_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -797,6 +910,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_buffer_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -823,9 +937,21 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz() invalid glyph count in shaped run" );
+            free( p_key );
             goto error;
         }
 
+        if( p_key )
+        {
+            shaped_run_t *p_shaped = NewShapedRun( p_run->i_glyph_count,
+                                                   p_run->p_glyph_infos,
+                                                   p_run->p_glyph_positions );
+            if( p_shaped )
+                LRUCache_Put( p_sys->p_shaping_cache, p_key, i_key_size,
+                              p_shaped, ShapedRunSize( p_shaped ) );
+            free( p_key );
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -899,8 +1025,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -914,6 +1043,7 @@ error:
             hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
         if( p_paragraph->p_runs[ i ].p_buffer )
             hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
 
     if( p_new_paragraph )
@@ -1013,6 +1143,171 @@ static int ZeroNsmAdvance( paragraph_t *p_paragraph )
 #endif
 #endif
 
+static size_t GlyphSize( FT_Glyph p_glyph )
+{
+    if( !p_glyph )
+        return 0;
+
+    switch( p_glyph->format )
+    {
+        case FT_GLYPH_FORMAT_OUTLINE:
+        {
+            const FT_Outline *p_outline = &((FT_OutlineGlyph) p_glyph)->outline;
+            return sizeof( FT_OutlineGlyphRec )
+                 + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+                 + p_outline->n_contours * sizeof( short );
+        }
+        case FT_GLYPH_FORMAT_BITMAP:
+        {
+            const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph) p_glyph)->bitmap;
+            return sizeof( FT_BitmapGlyphRec )
+                 + p_bitmap->rows * abs( p_bitmap->pitch );
+        }
+        default:
+            return sizeof( FT_GlyphRec );
+    }
+}
+
+void ReleaseCachedGlyph( void *p_value )
+{
+    cached_glyph_t *p_cached = p_value;
+    if( p_cached->p_glyph )
+        FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static void CacheGlyph( filter_sys_t *p_sys, const glyph_key_t *p_key,
+                        FT_Glyph p_glyph, FT_Glyph p_outline,
+                        const FT_Vector *p_advance )
+{
+    cached_glyph_t *p_cached = calloc( 1, sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_cached->p_glyph )
+     || ( p_outline && FT_Glyph_Copy( p_outline, &p_cached->p_outline ) ) )
+    {
+        ReleaseCachedGlyph( p_cached );
+        return;
+    }
+    if( p_advance )
+        p_cached->advance = *p_advance;
+
+    LRUCache_Put( p_sys->p_glyph_cache, p_key, sizeof( *p_key ), p_cached,
+                  sizeof( *p_cached ) + GlyphSize( p_cached->p_glyph )
+                                      + GlyphSize( p_cached->p_outline ) );
+}
+
+/**
+ * Load a glyph and its outline as described by the key, using the glyph
+ * cache when available. The stroker must be set up for the outline radius.
+ */
+static int LoadGlyph( filter_t *p_filter, const glyph_key_t *p_key,
+                      glyph_bitmaps_t *p_bitmaps, FT_Vector *p_advance )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    FT_Face p_face = p_key->p_face;
+
+    const cached_glyph_t *p_cached = p_sys->p_glyph_cache ?
+        LRUCache_Get( p_sys->p_glyph_cache, p_key, sizeof( *p_key ) ) : NULL;
+    if( p_cached )
+    {
+        if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+            return VLC_ENOMEM;
+        if( !p_cached->p_outline
+         || FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+            p_bitmaps->p_outline = 0;
+        *p_advance = p_cached->advance;
+        return VLC_SUCCESS;
+    }
+
+    if( FT_Load_Glyph( p_face, p_key->i_glyph_index,
+                       FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+     && FT_Load_Glyph( p_face, p_key->i_glyph_index, FT_LOAD_DEFAULT ) )
+        return VLC_EGENERIC;
+
+    if( p_key->i_style_flags & STYLE_BOLD )
+        FT_GlyphSlot_Embolden( p_face->glyph );
+    if( p_key->i_style_flags & STYLE_ITALIC )
+        FT_GlyphSlot_Oblique( p_face->glyph );
+
+    if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+        return VLC_EGENERIC;
+
+    p_bitmaps->p_outline = 0;
+    if( p_key->i_style_flags & STYLE_OUTLINE )
+    {
+        p_bitmaps->p_outline = p_bitmaps->p_glyph;
+        if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                   p_sys->p_stroker, 0, 0 ) )
+            p_bitmaps->p_outline = 0;
+    }
+
+    p_advance->x = p_face->glyph->advance.x;
+    p_advance->y = p_face->glyph->advance.y;
+
+    if( p_sys->p_glyph_cache )
+        CacheGlyph( p_sys, p_key, p_bitmaps->p_glyph, p_bitmaps->p_outline,
+                    p_advance );
+    return VLC_SUCCESS;
+}
+
+/**
+ * Render a glyph loaded by LoadGlyph() or its outline to a bitmap glyph at
+ * the given pen position, like FT_Glyph_To_Bitmap() does. Bitmaps are
+ * cached per subpixel origin; the integral part of the pen position only
+ * moves the bitmap.
+ */
+static int RenderGlyph( filter_t *p_filter, FT_Glyph *pp_glyph,
+                        const glyph_key_t *p_key, int i_bitmap,
+                        const FT_Vector *p_pen, bool b_destroy )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_sys->p_glyph_cache
+     || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   (FT_Vector *) p_pen, b_destroy );
+
+    FT_Vector origin = { .x = p_pen->x & 63, .y = p_pen->y & 63 };
+    glyph_key_t key = *p_key;
+    key.i_bitmap = i_bitmap;
+    key.i_x_origin = origin.x;
+    key.i_y_origin = origin.y;
+
+    FT_Glyph p_bitmap;
+    const cached_glyph_t *p_cached =
+        LRUCache_Get( p_sys->p_glyph_cache, &key, sizeof( key ) );
+    if( p_cached )
+    {
+        if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmap ) )
+            return VLC_ENOMEM;
+    }
+    else
+    {
+        p_bitmap = *pp_glyph;
+        if( FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                &origin, 0 ) )
+            return VLC_EGENERIC;
+        CacheGlyph( p_sys, &key, p_bitmap, NULL, NULL );
+    }
+
+    /* FreeType does not position empty bitmaps */
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph) p_bitmap;
+    if( p_bitmap_glyph->bitmap.rows && p_bitmap_glyph->bitmap.width )
+    {
+        p_bitmap_glyph->left += ( p_pen->x - origin.x ) / 64;
+        p_bitmap_glyph->top  += ( p_pen->y - origin.y ) / 64;
+    }
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return VLC_SUCCESS;
+}
+
 /**
  * Load the glyphs of a paragraph. When shaping with HarfBuzz the glyph indices
  * have already been determined at this point, as well as the advance values.
@@ -1055,6 +1350,16 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_style_flags = 0;
+        int i_outline_radius = 0;
+
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_style_flags |= STYLE_BOLD;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_style_flags |= STYLE_ITALIC;
+
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
@@ -1065,6 +1370,8 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
+            i_style_flags |= STYLE_OUTLINE;
+            i_outline_radius = i_radius;
         }
 
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
@@ -1117,39 +1424,27 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
-
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            glyph_key_t *p_key = &p_bitmaps->key;
+            memset( p_key, 0, sizeof( *p_key ) );
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_style_flags = i_style_flags;
+            p_key->i_outline_radius = i_outline_radius;
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+            FT_Vector advance;
+            if( LoadGlyph( p_filter, p_key, p_bitmaps, &advance ) )
                 SKIP_GLYPH( p_bitmaps )
 
 #undef SKIP_GLYPH
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_filter->p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
-            }
-
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
         }
 
@@ -1256,8 +1551,10 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->p_shadow, &p_bitmaps->key,
+                             p_bitmaps->p_shadow == p_bitmaps->p_outline ?
+                             GLYPH_KEY_OUTLINE : GLYPH_KEY_GLYPH,
+                             &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1265,8 +1562,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->p_glyph, &p_bitmaps->key,
+                             GLYPH_KEY_GLYPH, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1281,8 +1578,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->p_outline, &p_bitmaps->key,
+                             GLYPH_KEY_OUTLINE, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -108,3 +108,8 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Release a value of the glyph cache \ref filter_sys_t::p_glyph_cache
+ */
+void ReleaseCachedGlyph( void *p_cached );
@@ -26,15 +26,22 @@
 # include "config.h"
 #endif
 
-#ifdef COPY_TEST
+#if defined(COPY_TEST) && !defined(COPY_BENCH)
 # undef NDEBUG
 #endif
 
 #include <vlc_common.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 #include <assert.h>
 
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define COPY_AVX2
+# define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+
 #include "copy.h"
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
@@ -52,7 +59,7 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
 #define ASSERT_3PLANES ASSERT_2PLANES; \
     ASSERT_PLANE(2)
 
-int CopyInitCache(copy_cache_t *cache, unsigned width)
+static int CopyInitBuffer(copy_cache_t *cache, unsigned width)
 {
 #ifdef CAN_COMPILE_SSE2
     cache->size = __MAX((width + 0x3f) & ~ 0x3f, 16384);
@@ -65,7 +72,7 @@ int CopyInitCache(copy_cache_t *cache, unsigned width)
     return VLC_SUCCESS;
 }
 
-void CopyCleanCache(copy_cache_t *cache)
+static void CopyCleanBuffer(copy_cache_t *cache)
 {
 #ifdef CAN_COMPILE_SSE2
     aligned_free(cache->buffer);
@@ -76,6 +83,189 @@ void CopyCleanCache(copy_cache_t *cache)
 #endif
 }
 
+/* Pictures at least that wide (in bytes) are copied by bands on several
+ * threads, as a single core cannot use the whole memory bandwidth. */
+#define COPY_THREADS_WIDTH 3840
+#define COPY_THREADS_MAX   4
+
+#ifdef COPY_TEST
+/* Number of threads forced by the tests, or 0 for the automatic choice */
+static unsigned copy_test_threads = 0;
+#endif
+
+/* Copies the lines [0, height) of a picture, or of a band of it */
+typedef void (*copy_band_cb)(picture_t *dst, const uint8_t *src[],
+                             const size_t src_pitch[], unsigned height,
+                             int bitshift, const copy_cache_t *cache);
+
+/* Slice threads, with one cache each: the calling thread uses the cache
+ * given to the copy functions */
+struct copy_threads
+{
+    vlc_slices_t *slices;
+    unsigned      count;
+    copy_cache_t  caches[];
+};
+
+/* Picture being copied by bands */
+typedef struct
+{
+    copy_band_cb         cb;
+    picture_t           *dst;
+    const uint8_t      **src;
+    const size_t        *src_pitch;
+    unsigned             planes;
+    unsigned             height;
+    unsigned             band_height;
+    int                  bitshift;
+    const copy_cache_t  *cache;
+} copy_bands_t;
+
+/* Copies the lines [y, y + height) of 4:2:0 (or single plane) pictures */
+static void CopyBand(copy_band_cb cb, picture_t *dst, const uint8_t *src[],
+                     const size_t src_pitch[], unsigned planes,
+                     unsigned y, unsigned height, int bitshift,
+                     const copy_cache_t *cache)
+{
+    assert((y & 1) == 0);
+
+    picture_t band = *dst;
+    const uint8_t *band_src[3];
+
+    for (unsigned n = 0; n < planes; n++)
+        band_src[n] = src[n] + (n > 0 ? y / 2 : y) * src_pitch[n];
+    for (int n = 0; n < dst->i_planes; n++)
+        band.p[n].p_pixels += (n > 0 ? y / 2 : y) * dst->p[n].i_pitch;
+
+    cb(&band, band_src, src_pitch, height, bitshift, cache);
+}
+
+static void CopyBandSlice(void *opaque, unsigned index, unsigned worker)
+{
+    const copy_bands_t *bands = opaque;
+    const copy_cache_t *cache = bands->cache;
+    unsigned y = index * bands->band_height;
+    unsigned height = __MIN(bands->band_height, bands->height - y);
+
+    if (worker > 0)
+        cache = &cache->threads->caches[worker - 1];
+    CopyBand(bands->cb, bands->dst, bands->src, bands->src_pitch,
+             bands->planes, y, height, bands->bitshift, cache);
+}
+
+static void CopyThreadsDelete(struct copy_threads *threads)
+{
+    vlc_slices_Delete(threads->slices);
+    for (unsigned i = 0; i < threads->count; i++)
+        CopyCleanBuffer(&threads->caches[i]);
+    free(threads);
+}
+
+static struct copy_threads *CopyThreadsNew(unsigned width)
+{
+    unsigned count;
+
+#ifdef COPY_TEST
+    if (copy_test_threads != 0)
+        count = copy_test_threads;
+    else
+#endif
+    if (width < COPY_THREADS_WIDTH)
+        return NULL;
+    else
+        count = __MIN(vlc_GetCPUCount(), COPY_THREADS_MAX);
+
+    /* The calling thread copies bands too */
+    if (count <= 1)
+        return NULL;
+
+    struct copy_threads *threads =
+        malloc(sizeof (*threads) + (count - 1) * sizeof (threads->caches[0]));
+    if (unlikely(threads == NULL))
+        return NULL;
+
+    for (threads->count = 0; threads->count < count - 1; threads->count++)
+    {
+        copy_cache_t *cache = &threads->caches[threads->count];
+
+        cache->threads = NULL;
+        if (CopyInitBuffer(cache, width))
+            break;
+    }
+
+    threads->slices = vlc_slices_New(threads->count + 1,
+                                     VLC_THREAD_PRIORITY_VIDEO);
+    if (threads->slices == NULL)
+    {
+        for (unsigned i = 0; i < threads->count; i++)
+            CopyCleanBuffer(&threads->caches[i]);
+        free(threads);
+        return NULL;
+    }
+    return threads;
+}
+
+/**
+ * Copies a picture, by bands on the copy threads and the calling thread if
+ * the cache has threads, or at once otherwise.
+ */
+static void CopyBands(copy_band_cb cb, picture_t *dst, const uint8_t *src[],
+                      const size_t src_pitch[], unsigned planes,
+                      unsigned height, int bitshift, const copy_cache_t *cache)
+{
+    struct copy_threads *threads = cache->threads;
+
+    if (threads == NULL)
+    {
+        cb(dst, src, src_pitch, height, bitshift, cache);
+        return;
+    }
+
+    /* A few bands per thread balance the load if some threads lag */
+    unsigned count = 2 * vlc_slices_GetThreads(threads->slices);
+    unsigned band_height = (height + count - 1) / count;
+
+    band_height = (band_height + 15) & ~15u;
+    if (band_height >= height)
+    {
+        cb(dst, src, src_pitch, height, bitshift, cache);
+        return;
+    }
+
+    copy_bands_t bands = {
+        .cb = cb,
+        .dst = dst,
+        .src = src,
+        .src_pitch = src_pitch,
+        .planes = planes,
+        .height = height,
+        .band_height = band_height,
+        .bitshift = bitshift,
+        .cache = cache,
+    };
+
+    vlc_slices_Run(threads->slices, (height + band_height - 1) / band_height,
+                   CopyBandSlice, &bands);
+}
+
+int CopyInitCache(copy_cache_t *cache, unsigned width)
+{
+    if (CopyInitBuffer(cache, width))
+        return VLC_EGENERIC;
+    cache->threads = CopyThreadsNew(width);
+    return VLC_SUCCESS;
+}
+
+void CopyCleanCache(copy_cache_t *cache)
+{
+    if (cache->threads != NULL)
+    {
+        CopyThreadsDelete(cache->threads);
+        cache->threads = NULL;
+    }
+    CopyCleanBuffer(cache);
+}
+
 #ifdef CAN_COMPILE_SSE2
 /* Copy 16/64 bytes from srcp to dstp loading data with the SSE>=2 instruction
  * load and storing data with the SSE>=2 instruction store.
@@ -131,6 +321,22 @@ void CopyCleanCache(copy_cache_t *cache)
 # define vlc_CPU_SSSE3() (0)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+#elif defined(COPY_BENCH)
+/* The benchmark compares the versions by masking CPU features out */
+static unsigned copy_bench_cpu = ~0u;
+# define COPY_BENCH_CPU(flag) ((vlc_CPU() & copy_bench_cpu & (flag)) != 0)
+# undef vlc_CPU_SSE4_1
+# define vlc_CPU_SSE4_1() COPY_BENCH_CPU(VLC_CPU_SSE4_1)
+# undef vlc_CPU_SSE3
+# define vlc_CPU_SSE3() COPY_BENCH_CPU(VLC_CPU_SSE3)
+# undef vlc_CPU_SSSE3
+# define vlc_CPU_SSSE3() COPY_BENCH_CPU(VLC_CPU_SSSE3)
+# undef vlc_CPU_SSE2
+# define vlc_CPU_SSE2() COPY_BENCH_CPU(VLC_CPU_SSE2)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() COPY_BENCH_CPU(VLC_CPU_AVX2)
 #endif
 
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
@@ -197,7 +403,7 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
             SSE_USWC_COPY(COPY16_SHIFTR("$4"), COPY64_SHIFTR("$4"))
             break;
         case -4:
-            SSE_USWC_COPY(COPY16_SHIFTL("$2"), COPY64_SHIFTL("$2"))
+            SSE_USWC_COPY(COPY16_SHIFTL("$4"), COPY64_SHIFTL("$4"))
             break;
         default:
             vlc_assert_unreachable();
@@ -607,6 +813,363 @@ static void SSE_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
 #undef COPY64
 #endif /* CAN_COMPILE_SSE2 */
 
+#ifdef COPY_AVX2
+VLC_AVX2
+static inline __m256i AVX2_Shift(__m256i v, int bitshift)
+{
+    if (bitshift > 0)
+        return _mm256_srli_epi16(v, bitshift);
+    if (bitshift < 0)
+        return _mm256_slli_epi16(v, -bitshift);
+    return v;
+}
+
+/* AVX2 version of CopyFromUswc(), to a 32 bytes aligned destination */
+VLC_AVX2
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    assert(((intptr_t)dst & 0x1f) == 0 && (dst_pitch & 0x1f) == 0);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = (-(uintptr_t)src) & 0x1f;
+
+        /* The following should not happen since buffers are generally well
+         * aligned: copy the first bytes to reach the alignment of src */
+        if (x > width)
+            x = width;
+        if (x > 0)
+            CopyPlane(dst, x, src, x, 1, bitshift);
+
+        if (x == 0) {
+            for (; x+127 < width; x += 128) {
+                __m256i a = _mm256_stream_load_si256((void *)&src[x]);
+                __m256i b = _mm256_stream_load_si256((void *)&src[x+32]);
+                __m256i c = _mm256_stream_load_si256((void *)&src[x+64]);
+                __m256i d = _mm256_stream_load_si256((void *)&src[x+96]);
+                _mm256_store_si256((__m256i *)&dst[x],    AVX2_Shift(a, bitshift));
+                _mm256_store_si256((__m256i *)&dst[x+32], AVX2_Shift(b, bitshift));
+                _mm256_store_si256((__m256i *)&dst[x+64], AVX2_Shift(c, bitshift));
+                _mm256_store_si256((__m256i *)&dst[x+96], AVX2_Shift(d, bitshift));
+            }
+        } else {
+            for (; x+127 < width; x += 128) {
+                __m256i a = _mm256_stream_load_si256((void *)&src[x]);
+                __m256i b = _mm256_stream_load_si256((void *)&src[x+32]);
+                __m256i c = _mm256_stream_load_si256((void *)&src[x+64]);
+                __m256i d = _mm256_stream_load_si256((void *)&src[x+96]);
+                _mm256_storeu_si256((__m256i *)&dst[x],    AVX2_Shift(a, bitshift));
+                _mm256_storeu_si256((__m256i *)&dst[x+32], AVX2_Shift(b, bitshift));
+                _mm256_storeu_si256((__m256i *)&dst[x+64], AVX2_Shift(c, bitshift));
+                _mm256_storeu_si256((__m256i *)&dst[x+96], AVX2_Shift(d, bitshift));
+            }
+        }
+        if (x < width)
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift);
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (((intptr_t)dst & 0x1f) == 0) {
+            for (; x+127 < width; x += 128) {
+                __m256i a = _mm256_load_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_load_si256((const __m256i *)&src[x+32]);
+                __m256i c = _mm256_load_si256((const __m256i *)&src[x+64]);
+                __m256i d = _mm256_load_si256((const __m256i *)&src[x+96]);
+                _mm256_stream_si256((__m256i *)&dst[x],    a);
+                _mm256_stream_si256((__m256i *)&dst[x+32], b);
+                _mm256_stream_si256((__m256i *)&dst[x+64], c);
+                _mm256_stream_si256((__m256i *)&dst[x+96], d);
+            }
+        } else {
+            for (; x+127 < width; x += 128) {
+                __m256i a = _mm256_load_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_load_si256((const __m256i *)&src[x+32]);
+                __m256i c = _mm256_load_si256((const __m256i *)&src[x+64]);
+                __m256i d = _mm256_load_si256((const __m256i *)&src[x+96]);
+                _mm256_storeu_si256((__m256i *)&dst[x],    a);
+                _mm256_storeu_si256((__m256i *)&dst[x+32], b);
+                _mm256_storeu_si256((__m256i *)&dst[x+64], c);
+                _mm256_storeu_si256((__m256i *)&dst[x+96], d);
+            }
+        }
+
+        memcpy(&dst[x], &src[x], width - x);
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_sfence();
+}
+
+VLC_AVX2
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned width, unsigned height,
+                              uint8_t pixel_size)
+{
+    assert(pixel_size == 1 || pixel_size == 2);
+    assert(!((intptr_t)srcu & 0x1f) && !(srcu_pitch & 0x1f) &&
+           !((intptr_t)srcv & 0x1f) && !(srcv_pitch & 0x1f));
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i u = _mm256_load_si256((const __m256i *)&srcu[x]);
+            __m256i v = _mm256_load_si256((const __m256i *)&srcv[x]);
+            __m256i lo, hi;
+
+            /* Interleaving works within each 128-bits lane */
+            if (pixel_size == 1) {
+                lo = _mm256_unpacklo_epi8(u, v);
+                hi = _mm256_unpackhi_epi8(u, v);
+            } else {
+                lo = _mm256_unpacklo_epi16(u, v);
+                hi = _mm256_unpackhi_epi16(u, v);
+            }
+            _mm256_storeu_si256((__m256i *)&dst[2*x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2*x+32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        if (pixel_size == 1)
+        {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        }
+        else
+        {
+            for (; x < width; x+= 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+}
+
+VLC_AVX2
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    assert(pixel_size == 1 || pixel_size == 2);
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    /* Gather U then V in each 128-bits lane, as 64-bits words */
+    const __m256i shuffle = pixel_size == 1
+        ? _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15)
+        : _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                           0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i a = _mm256_load_si256((const __m256i *)&src[2*x]);
+            __m256i b = _mm256_load_si256((const __m256i *)&src[2*x+32]);
+
+            /* U0 V0 U1 V1 -> U0 U1 V0 V1 (64-bits words) */
+            a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+            b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute2x128_si256(a, b, 0x31));
+        }
+
+        if (pixel_size == 1)
+        {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        }
+        else
+        {
+            for (; x < width; x+= 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+
+static void AVX2_CopyPlane(uint8_t *dst, size_t dst_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           uint8_t *cache, size_t cache_size,
+                           unsigned height, int bitshift)
+{
+    const size_t copy_pitch = __MIN(src_pitch, dst_pitch);
+    const unsigned w32 = (copy_pitch+31) & ~31;
+    const unsigned hstep = cache_size / w32;
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, src, src_pitch, copy_pitch, hblock,
+                          bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_Copy2d(dst, dst_pitch, cache, w32, copy_pitch, hblock);
+
+        /* */
+        src += src_pitch * hblock;
+        dst += dst_pitch * hblock;
+    }
+}
+
+static void
+AVX2_InterleavePlanes(uint8_t *dst, size_t dst_pitch,
+                      const uint8_t *srcu, size_t srcu_pitch,
+                      const uint8_t *srcv, size_t srcv_pitch,
+                      uint8_t *cache, size_t cache_size,
+                      unsigned int height, uint8_t pixel_size, int bitshift)
+{
+    assert(srcu_pitch == srcv_pitch);
+    unsigned int const  w32 = (srcu_pitch+31) & ~31;
+    unsigned int const  hstep = (cache_size) / (2*w32);
+    assert(hstep > 0);
+
+    for (unsigned int y = 0; y < height; y += hstep)
+    {
+        unsigned int const      hblock = __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, srcu, srcu_pitch, srcu_pitch, hblock,
+                          bitshift);
+        AVX2_CopyFromUswc(cache+w32*hblock, w32, srcv, srcv_pitch,
+                          srcv_pitch, hblock, bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_InterleaveUV(dst, dst_pitch, cache, w32,
+                          cache + w32 * hblock, w32,
+                          srcu_pitch, hblock, pixel_size);
+
+        /* */
+        srcu += hblock * srcu_pitch;
+        srcv += hblock * srcv_pitch;
+        dst += hblock * dst_pitch;
+    }
+}
+
+static void AVX2_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
+                             uint8_t *dstv, size_t dstv_pitch,
+                             const uint8_t *src, size_t src_pitch,
+                             uint8_t *cache, size_t cache_size,
+                             unsigned height, uint8_t pixel_size, int bitshift)
+{
+    const unsigned w32 = (src_pitch+31) & ~31;
+    const unsigned hstep = cache_size / w32;
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, src, src_pitch, src_pitch, hblock,
+                          bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                     cache, w32, src_pitch / 2, hblock, pixel_size);
+
+        /* */
+        src  += src_pitch  * hblock;
+        dstu += dstu_pitch * hblock;
+        dstv += dstv_pitch * hblock;
+    }
+}
+
+static void AVX2_Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                                const size_t src_pitch[static 3],
+                                unsigned height, const copy_cache_t *cache)
+{
+    for (unsigned n = 0; n < 3; n++) {
+        const unsigned d = n > 0 ? 2 : 1;
+        AVX2_CopyPlane(dst->p[n].p_pixels, dst->p[n].i_pitch,
+                       src[n], src_pitch[n],
+                       cache->buffer, cache->size,
+                       (height+d-1)/d, 0);
+    }
+}
+
+static void AVX2_Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                                  const size_t src_pitch[static 2],
+                                  unsigned height, const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
+                   cache->buffer, cache->size, height, 0);
+    AVX2_CopyPlane(dst->p[1].p_pixels, dst->p[1].i_pitch, src[1], src_pitch[1],
+                   cache->buffer, cache->size, (height+1) / 2, 0);
+}
+
+static void
+AVX2_Copy420_SP_to_P(picture_t *dest, const uint8_t *src[static 2],
+                     const size_t src_pitch[static 2], unsigned int height,
+                     uint8_t pixel_size, int bitshift, const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dest->p[0].p_pixels, dest->p[0].i_pitch,
+                   src[0], src_pitch[0], cache->buffer, cache->size, height,
+                   bitshift);
+
+    AVX2_SplitPlanes(dest->p[1].p_pixels, dest->p[1].i_pitch,
+                     dest->p[2].p_pixels, dest->p[2].i_pitch,
+                     src[1], src_pitch[1], cache->buffer, cache->size,
+                     (height+1) / 2, pixel_size, bitshift);
+}
+
+static void AVX2_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                                 const size_t src_pitch[static 3],
+                                 unsigned height, uint8_t pixel_size,
+                                 int bitshift, const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
+                   cache->buffer, cache->size, height, bitshift);
+    AVX2_InterleavePlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                          src[U_PLANE], src_pitch[U_PLANE],
+                          src[V_PLANE], src_pitch[V_PLANE],
+                          cache->buffer, cache->size, (height+1) / 2,
+                          pixel_size, bitshift);
+}
+#endif /* COPY_AVX2 */
+
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
                       unsigned height, int bitshift)
@@ -639,29 +1202,48 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
     }
 }
 
-void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
-                unsigned height, const copy_cache_t *cache)
+static void CopyPackedBand(picture_t *dst, const uint8_t *src[],
+                           const size_t src_pitch[], unsigned height,
+                           int bitshift, const copy_cache_t *cache)
 {
-    assert(dst);
-    assert(src); assert(src_pitch);
-    assert(height);
-
+    (void) bitshift;
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                              src[0], src_pitch[0],
+                              cache->buffer, cache->size, height, 0);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE4_1())
-        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                             src[0], src_pitch[0],
                              cache->buffer, cache->size, height, 0);
 #else
     (void) cache;
 #endif
-        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
                   height, 0);
 }
 
-void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
-                      const size_t src_pitch[static 2], unsigned height,
-                      const copy_cache_t *cache)
+void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
+                unsigned height, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    assert(dst);
+    assert(src); assert(src_pitch);
+    assert(height);
+
+    CopyBands(CopyPackedBand, dst, &src, &src_pitch, 1, height, 0, cache);
+}
+
+static void Copy420_SP_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                  const size_t src_pitch[], unsigned height,
+                                  int bitshift, const copy_cache_t *cache)
+{
+    (void) bitshift;
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
@@ -675,6 +1257,14 @@ void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
               src[1], src_pitch[1], (height+1)/2, 0);
 }
 
+void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                      const size_t src_pitch[static 2], unsigned height,
+                      const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    CopyBands(Copy420_SP_to_SP_Band, dst, src, src_pitch, 2, height, 0, cache);
+}
+
 #define SPLIT_PLANES(type, pitch_den) do { \
     for (unsigned y = 0; y < height; y++) { \
         for (unsigned x = 0; x < src_pitch / pitch_den; x++) { \
@@ -731,11 +1321,15 @@ static void SplitPlanes16(uint8_t *dstu, size_t dstu_pitch,
         SPLIT_PLANES_SHIFTL(uint16_t, 4, (-bitshift) & 0xf);
 }
 
-void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                     const size_t src_pitch[static 2], unsigned height,
-                     const copy_cache_t *cache)
+static void Copy420_SP_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    (void) bitshift;
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
@@ -750,13 +1344,23 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                 src[1], src_pitch[1], (height+1)/2);
 }
 
-void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                        const size_t src_pitch[static 2], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                     const size_t src_pitch[static 2], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_2PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(Copy420_SP_to_P_Band, dst, src, src_pitch, 2, height, 0, cache);
+}
 
+static void Copy420_16_SP_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                    const size_t src_pitch[], unsigned height,
+                                    int bitshift, const copy_cache_t *cache)
+{
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift,
+                                    cache);
+#endif
 #ifdef CAN_COMPILE_SSE3
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -771,6 +1375,17 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                   src[1], src_pitch[1], (height+1)/2, bitshift);
 }
 
+void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                        const size_t src_pitch[static 2], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+
+    CopyBands(Copy420_16_SP_to_P_Band, dst, src, src_pitch, 2, height,
+              bitshift, cache);
+}
+
 #define INTERLEAVE_UV() do { \
     for ( unsigned int line = 0; line < copy_lines; line++ ) { \
         for ( unsigned int col = 0; col < copy_pitch; col++ ) { \
@@ -807,11 +1422,15 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
     } \
 }while(0)
 
-void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                     const size_t src_pitch[static 3], unsigned height,
-                     const copy_cache_t *cache)
+static void Copy420_P_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_3PLANES;
+    (void) bitshift;
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
@@ -835,12 +1454,23 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     INTERLEAVE_UV();
 }
 
-void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                        const size_t src_pitch[static 3], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                     const size_t src_pitch[static 3], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(Copy420_P_to_SP_Band, dst, src, src_pitch, 3, height, 0, cache);
+}
+
+static void Copy420_16_P_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                    const size_t src_pitch[], unsigned height,
+                                    int bitshift, const copy_cache_t *cache)
+{
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift,
+                                    cache);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -870,11 +1500,26 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
         INTERLEAVE_UV_SHIFTL((-bitshift) & 0xf);
 }
 
-void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
-                    const size_t src_pitch[static 3], unsigned height,
-                    const copy_cache_t *cache)
+void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                        const size_t src_pitch[static 3], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+
+    CopyBands(Copy420_16_P_to_SP_Band, dst, src, src_pitch, 3, height,
+              bitshift, cache);
+}
+
+static void Copy420_P_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                const size_t src_pitch[], unsigned height,
+                                int bitshift, const copy_cache_t *cache)
+{
+    (void) bitshift;
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_P(dst, src, src_pitch, height, cache);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_P(dst, src, src_pitch, height, cache);
@@ -890,6 +1535,14 @@ void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
                src[2], src_pitch[2], (height+1) / 2, 0);
 }
 
+void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                    const size_t src_pitch[static 3], unsigned height,
+                    const copy_cache_t *cache)
+{
+    ASSERT_3PLANES;
+    CopyBands(Copy420_P_to_P_Band, dst, src, src_pitch, 3, height, 0, cache);
+}
+
 int picture_UpdatePlanes(picture_t *picture, uint8_t *data, unsigned pitch)
 {
     /* fill in buffer info in first plane */
@@ -1096,9 +1749,143 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
+static void test_copy(const struct test_dst *test_dst, picture_t *dst,
+                      picture_t *src, const copy_cache_t *cache)
+{
+    const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                      src->p[U_PLANE].p_pixels,
+                                      src->p[V_PLANE].p_pixels };
+    const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                       src->p[U_PLANE].i_pitch,
+                                       src->p[V_PLANE].i_pitch };
+
+    if (test_dst->bitshift == 0)
+        test_dst->conv(dst, src_planes, src_pitches,
+                       src->format.i_visible_height, cache);
+    else
+        test_dst->conv16(dst, src_planes, src_pitches,
+                         src->format.i_visible_height, test_dst->bitshift,
+                         cache);
+}
+
+#ifdef COPY_BENCH
+#define SSSE3_CPU (VLC_CPU_SSE2 | VLC_CPU_SSE3 | VLC_CPU_SSSE3)
+
+static const struct
+{
+    const char *name;
+    unsigned cpu;
+} bench_cpus[] = {
+    { "C",      0 },
+    { "SSE2",   VLC_CPU_SSE2 },
+    { "SSSE3",  SSSE3_CPU },
+    { "SSE4.1", SSSE3_CPU | VLC_CPU_SSE4_1 },
+    { "AVX2",   SSSE3_CPU | VLC_CPU_SSE4_1 | VLC_CPU_AVX2 },
+};
+
+static const struct test_size bench_sizes[] = {
+    { 1920, 1080, 1920, 1080 },
+    { 3840, 2160, 3840, 2160 },
+};
+
+/* Reports the throughput of each copy routine, in bytes read and written per
+ * second, for each CPU features set and with or without threads. */
+int main(void)
+{
+    const unsigned max_threads = __MIN(vlc_GetCPUCount(), COPY_THREADS_MAX);
+
+    for (size_t i = 0; i < NB_CONVS; ++i)
+    {
+        const struct test_conv *conv = &convs[i];
+        const vlc_chroma_description_t *src_dsc =
+            vlc_fourcc_GetChromaDescription(conv->src_chroma);
+        assert(src_dsc);
+
+        for (size_t j = 0; j < ARRAY_SIZE(bench_sizes); ++j)
+        {
+            const struct test_size *size = &bench_sizes[j];
+
+            video_format_t fmt;
+            video_format_Init(&fmt, 0);
+            video_format_Setup(&fmt, conv->src_chroma,
+                               size->i_width, size->i_height,
+                               size->i_visible_width, size->i_visible_height,
+                               1, 1);
+            picture_t *src = pic_new_unaligned(&fmt);
+            assert(src);
+            piccheck(src, src_dsc, true);
+
+            size_t bytes = 0;
+            for (int p = 0; p < src->i_planes; p++)
+                bytes += src->p[p].i_visible_lines * src->p[p].i_visible_pitch;
+            bytes *= 2; /* read and written */
+
+            for (unsigned threads = 1; threads <= max_threads;
+                 threads = threads < max_threads ? max_threads : threads + 1)
+            {
+                copy_test_threads = threads;
+
+                copy_cache_t cache;
+                int ret = CopyInitCache(&cache, src->format.i_width
+                                        * src_dsc->pixel_size);
+                assert(ret == VLC_SUCCESS);
+
+                for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+                {
+                    const struct test_dst *test_dst = &conv->dsts[f];
+                    const vlc_chroma_description_t *dst_dsc =
+                        vlc_fourcc_GetChromaDescription(test_dst->chroma);
+                    assert(dst_dsc);
+                    fmt.i_chroma = test_dst->chroma;
+                    picture_t *dst = picture_NewFromFormat(&fmt);
+                    assert(dst);
+
+                    for (size_t k = 0; k < ARRAY_SIZE(bench_cpus); ++k)
+                    {
+                        if ((vlc_CPU() & bench_cpus[k].cpu) != bench_cpus[k].cpu)
+                            continue;
+                        copy_bench_cpu = bench_cpus[k].cpu;
+
+                        /* Warm up, and check the result once */
+                        test_copy(test_dst, dst, src, &cache);
+                        piccheck(dst, dst_dsc, false);
+
+                        unsigned count = 0;
+                        mtime_t start = mdate(), elapsed;
+                        do
+                        {
+                            test_copy(test_dst, dst, src, &cache);
+                            count++;
+                            elapsed = mdate() - start;
+                        }
+                        while (elapsed < CLOCK_FREQ / 4);
+
+                        printf("%4.4s -> %4.4s %4d x %-4d %-6s %u thread(s): "
+                               "%6.2f GB/s\n",
+                               (const char *) &src->format.i_chroma,
+                               (const char *) &dst->format.i_chroma,
+                               size->i_visible_width, size->i_visible_height,
+                               bench_cpus[k].name, threads,
+                               (double) bytes * count * CLOCK_FREQ
+                                   / elapsed / 1e9);
+                    }
+                    picture_Release(dst);
+                }
+                CopyCleanCache(&cache);
+            }
+            picture_Release(src);
+        }
+    }
+    return 0;
+}
+
+#else /* COPY_BENCH */
 int main(void)
 {
-    alarm(10);
+    /* Test without threads, and with more threads than bands sometimes */
+    static const unsigned test_threads[] = { 1, COPY_THREADS_MAX };
+
+    alarm(20);
 
 #ifndef COPY_TEST_NOOPTIM
     if (!vlc_CPU_SSE2())
@@ -1108,10 +1895,13 @@ int main(void)
     }
 #endif
 
+    for (size_t t = 0; t < ARRAY_SIZE(test_threads); ++t)
     for (size_t i = 0; i < NB_CONVS; ++i)
     {
         const struct test_conv *conv = &convs[i];
 
+        copy_test_threads = test_threads[t];
+
         for (size_t j = 0; j < NB_SIZES; ++j)
         {
             const struct test_size *size = &sizes[j];
@@ -1146,25 +1936,14 @@ int main(void)
                 picture_t *dst = picture_NewFromFormat(&fmt);
                 assert(dst);
 
-                const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
-                                                  src->p[U_PLANE].p_pixels,
-                                                  src->p[V_PLANE].p_pixels };
-                const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
-                                                   src->p[U_PLANE].i_pitch,
-                                                   src->p[V_PLANE].i_pitch };
-
-                fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s\n",
+                fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s"
+                        " (%u thread(s))\n",
                         size->i_width, size->i_height,
                         size->i_visible_width, size->i_visible_height,
                         (const char *) &src->format.i_chroma,
-                        (const char *) &dst->format.i_chroma);
-                if (test_dst->bitshift == 0)
-                    test_dst->conv(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, &cache);
-                else
-                    test_dst->conv16(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, test_dst->bitshift,
-                                   &cache);
+                        (const char *) &dst->format.i_chroma,
+                        copy_test_threads);
+                test_copy(test_dst, dst, src, &cache);
                 piccheck(dst, dst_dsc, false);
                 picture_Release(dst);
             }
@@ -1174,5 +1953,6 @@ int main(void)
     }
     return 0;
 }
+#endif /* COPY_BENCH */
 
 #endif
@@ -31,8 +31,12 @@ typedef struct {
     uint8_t *buffer;
     size_t  size;
 # endif
+    struct copy_threads *threads;
 } copy_cache_t;
 
+/* Initializes a copy cache for pictures up to width bytes wide. Caches for
+ * large pictures also start threads copying the pictures by bands: a cache
+ * must not be used by several threads at once. */
 int  CopyInitCache(copy_cache_t *cache, unsigned width);
 void CopyCleanCache(copy_cache_t *cache);
 
@@ -0,0 +1,855 @@
+/*****************************************************************************
+ * yuv_rgb.c : YUV to 32-bits RGB conversions
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef YUV_RGB_TEST
+# undef NDEBUG
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+static int  Open ( vlc_object_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_description( N_("YUV to RGB32 and RGBA conversions") )
+    /* Ahead of swscale */
+    set_capability( "video converter", 155 )
+    set_callbacks( Open, NULL )
+vlc_module_end ()
+
+/*
+ * Samples are converted in fixed point with 13 bits of precision, plus the
+ * bits beyond 8 of the input samples:
+ *  R = (Y' cy + round + U' ru + V' rv) >> shift
+ * and so on for G and B, where Y', U' and V' have the black and grey offsets
+ * subtracted. All the coefficients fit in 16-bits signed integers, and the
+ * sums fit in 32-bits signed integers for input samples of up to 10 bits.
+ *
+ * The chroma samples are shared by two horizontally adjacent pixels (4:2:0
+ * and 4:2:2). All the versions compute the same values.
+ */
+#define YUV_RGB_PRECISION 13
+
+typedef struct
+{
+    int16_t y_offset, c_offset;
+    int16_t y, round;
+    int16_t ru, rv, gu, gv, bu, bv;
+    int shift;
+    /* Offsets of the components in the output pixels */
+    uint8_t r, g, b, a;
+} yuv_rgb_coeffs_t;
+
+/* Layouts of the input samples */
+enum
+{
+    YUV_PLANAR_8,
+    YUV_SEMIPLANAR_8,
+    YUV_PLANAR_16,     /* Samples in the low bits */
+    YUV_SEMIPLANAR_16, /* Samples in the high 10 bits (P010) */
+};
+
+/**
+ * Converts the pixels [x, width) of one row. For semi-planar layouts, u
+ * points to the interleaved chroma samples and v is not used.
+ */
+typedef void (*yuv_rgb_row_t)( uint8_t *dst, const uint8_t *y,
+                               const uint8_t *u, const uint8_t *v,
+                               unsigned x, unsigned width,
+                               const yuv_rgb_coeffs_t *c );
+
+struct filter_sys_t
+{
+    yuv_rgb_row_t row;
+    yuv_rgb_coeffs_t coeffs;
+    unsigned pixel_size;    /* bytes per luma sample */
+    unsigned chroma_vshift; /* 1 for 4:2:0, 0 for 4:2:2 */
+    int u_plane, v_plane;
+};
+
+/*****************************************************************************
+ * C version
+ *****************************************************************************/
+static inline unsigned Sample( const uint8_t *p, unsigned i, unsigned layout )
+{
+    switch( layout )
+    {
+        case YUV_PLANAR_8:
+        case YUV_SEMIPLANAR_8:
+            return p[i];
+        case YUV_PLANAR_16:
+            return ((const uint16_t *)p)[i];
+        default:
+            return ((const uint16_t *)p)[i] >> 6;
+    }
+}
+
+static inline uint8_t Clip( int v, int shift )
+{
+    v >>= shift;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline void RowC( uint8_t *dst, const uint8_t *py, const uint8_t *pu,
+                         const uint8_t *pv, unsigned x, unsigned width,
+                         const yuv_rgb_coeffs_t *c, unsigned layout )
+{
+    const bool semiplanar = layout == YUV_SEMIPLANAR_8
+                         || layout == YUV_SEMIPLANAR_16;
+
+    for( ; x < width; x++ )
+    {
+        unsigned i = x / 2;
+        int y = Sample( py, x, layout ) - c->y_offset;
+        int u, v;
+
+        if( semiplanar )
+        {
+            u = Sample( pu, 2 * i, layout );
+            v = Sample( pu, 2 * i + 1, layout );
+        }
+        else
+        {
+            u = Sample( pu, i, layout );
+            v = Sample( pv, i, layout );
+        }
+        u -= c->c_offset;
+        v -= c->c_offset;
+        y = y * c->y + c->round;
+
+        uint8_t *p = &dst[4 * x];
+        p[c->r] = Clip( y + u * c->ru + v * c->rv, c->shift );
+        p[c->g] = Clip( y + u * c->gu + v * c->gv, c->shift );
+        p[c->b] = Clip( y + u * c->bu + v * c->bv, c->shift );
+        p[c->a] = 0xff;
+    }
+}
+
+#define ROW_C( name, layout ) \
+static void name( uint8_t *dst, const uint8_t *y, const uint8_t *u, \
+                  const uint8_t *v, unsigned x, unsigned width, \
+                  const yuv_rgb_coeffs_t *c ) \
+{ \
+    RowC( dst, y, u, v, x, width, c, layout ); \
+}
+
+ROW_C( RowPlanar8C, YUV_PLANAR_8 )
+ROW_C( RowSemiPlanar8C, YUV_SEMIPLANAR_8 )
+ROW_C( RowPlanar16C, YUV_PLANAR_16 )
+ROW_C( RowSemiPlanar16C, YUV_SEMIPLANAR_16 )
+
+static const yuv_rgb_row_t rows_c[] = {
+    [YUV_PLANAR_8]      = RowPlanar8C,
+    [YUV_SEMIPLANAR_8]  = RowSemiPlanar8C,
+    [YUV_PLANAR_16]     = RowPlanar16C,
+    [YUV_SEMIPLANAR_16] = RowSemiPlanar16C,
+};
+
+/*****************************************************************************
+ * AVX2 version: 16 pixels per iteration
+ *****************************************************************************/
+#ifdef HAVE_AVX2_INTRINSICS
+# define AVX2 __attribute__ ((__target__ ("avx2")))
+
+typedef struct
+{
+    __m256i y_offset, c_offset, ones;
+    __m256i y, r, g, b; /* pairs of coefficients */
+    __m256i alpha;
+    __m128i shift, rs, gs, bs;
+} yuv_rgb_avx2_t;
+
+AVX2 static inline __m256i Pair16AVX2( int16_t lo, int16_t hi )
+{
+    return _mm256_unpacklo_epi16( _mm256_set1_epi16( lo ),
+                                  _mm256_set1_epi16( hi ) );
+}
+
+AVX2 static inline void SetupAVX2( yuv_rgb_avx2_t *k,
+                                   const yuv_rgb_coeffs_t *c )
+{
+    k->y_offset = _mm256_set1_epi16( c->y_offset );
+    k->c_offset = _mm256_set1_epi16( c->c_offset );
+    k->ones = _mm256_set1_epi16( 1 );
+    k->y = Pair16AVX2( c->y, c->round );
+    k->r = Pair16AVX2( c->ru, c->rv );
+    k->g = Pair16AVX2( c->gu, c->gv );
+    k->b = Pair16AVX2( c->bu, c->bv );
+    k->alpha = _mm256_set1_epi32( (int)(0xffu << (8 * c->a)) );
+    k->shift = _mm_cvtsi32_si128( c->shift );
+    k->rs = _mm_cvtsi32_si128( 8 * c->r );
+    k->gs = _mm_cvtsi32_si128( 8 * c->g );
+    k->bs = _mm_cvtsi32_si128( 8 * c->b );
+}
+
+AVX2 static inline __m256i ComponentAVX2( __m256i y, __m256i uv, __m256i coeffs,
+                                          __m128i shift, __m128i pos )
+{
+    __m256i v = _mm256_add_epi32( y, _mm256_madd_epi16( uv, coeffs ) );
+
+    v = _mm256_sra_epi32( v, shift );
+    v = _mm256_min_epi32( _mm256_max_epi32( v, _mm256_setzero_si256() ),
+                          _mm256_set1_epi32( 255 ) );
+    return _mm256_sll_epi32( v, pos );
+}
+
+/* Converts 8 pixels given as 32-bits lanes of Y' (with rounding) and pairs
+ * of U', V' */
+AVX2 static inline __m256i PixelsAVX2( __m256i y, __m256i uv,
+                                       const yuv_rgb_avx2_t *k )
+{
+    __m256i px = k->alpha;
+
+    px = _mm256_or_si256( px, ComponentAVX2( y, uv, k->r, k->shift, k->rs ) );
+    px = _mm256_or_si256( px, ComponentAVX2( y, uv, k->g, k->shift, k->gs ) );
+    px = _mm256_or_si256( px, ComponentAVX2( y, uv, k->b, k->shift, k->bs ) );
+    return px;
+}
+
+/* Converts 16 pixels, from 16-bits samples in pixel order (the chroma samples
+ * are already duplicated for each pixel) */
+AVX2 static inline void ConvertAVX2( uint8_t *dst, __m256i y, __m256i u,
+                                     __m256i v, const yuv_rgb_avx2_t *k )
+{
+    y = _mm256_sub_epi16( y, k->y_offset );
+    u = _mm256_sub_epi16( u, k->c_offset );
+    v = _mm256_sub_epi16( v, k->c_offset );
+
+    /* Pixels 0-3 and 8-11 in lo, 4-7 and 12-15 in hi */
+    __m256i ylo = _mm256_madd_epi16( _mm256_unpacklo_epi16( y, k->ones ), k->y );
+    __m256i yhi = _mm256_madd_epi16( _mm256_unpackhi_epi16( y, k->ones ), k->y );
+    __m256i lo = PixelsAVX2( ylo, _mm256_unpacklo_epi16( u, v ), k );
+    __m256i hi = PixelsAVX2( yhi, _mm256_unpackhi_epi16( u, v ), k );
+
+    _mm256_storeu_si256( (__m256i *)dst,
+                         _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(dst + 32),
+                         _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+/* Duplicates 8 chroma samples of 16-bits for 16 pixels */
+AVX2 static inline __m256i Dup16AVX2( __m128i c )
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256( _mm_unpacklo_epi16( c, c ) ),
+        _mm_unpackhi_epi16( c, c ), 1 );
+}
+
+AVX2 static void RowPlanar8AVX2( uint8_t *dst, const uint8_t *py,
+                                 const uint8_t *pu, const uint8_t *pv,
+                                 unsigned x, unsigned width,
+                                 const yuv_rgb_coeffs_t *c )
+{
+    yuv_rgb_avx2_t k;
+
+    SetupAVX2( &k, c );
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m128i u = _mm_loadl_epi64( (const __m128i *)(pu + x / 2) );
+        __m128i v = _mm_loadl_epi64( (const __m128i *)(pv + x / 2) );
+
+        ConvertAVX2( dst + 4 * x,
+            _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)(py + x) ) ),
+            _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( u, u ) ),
+            _mm256_cvtepu8_epi16( _mm_unpacklo_epi8( v, v ) ), &k );
+    }
+    RowPlanar8C( dst, py, pu, pv, x, width, c );
+}
+
+AVX2 static void RowSemiPlanar8AVX2( uint8_t *dst, const uint8_t *py,
+                                     const uint8_t *puv, const uint8_t *pv,
+                                     unsigned x, unsigned width,
+                                     const yuv_rgb_coeffs_t *c )
+{
+    const __m256i shuf_u = _mm256_setr_epi8(
+        0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13,
+        0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13 );
+    const __m256i shuf_v = _mm256_add_epi8( shuf_u, _mm256_set1_epi8( 2 ) );
+    yuv_rgb_avx2_t k;
+
+    SetupAVX2( &k, c );
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m256i uv = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)(puv + x) ) );
+
+        ConvertAVX2( dst + 4 * x,
+            _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)(py + x) ) ),
+            _mm256_shuffle_epi8( uv, shuf_u ),
+            _mm256_shuffle_epi8( uv, shuf_v ), &k );
+    }
+    RowSemiPlanar8C( dst, py, puv, pv, x, width, c );
+}
+
+AVX2 static void RowPlanar16AVX2( uint8_t *dst, const uint8_t *py,
+                                  const uint8_t *pu, const uint8_t *pv,
+                                  unsigned x, unsigned width,
+                                  const yuv_rgb_coeffs_t *c )
+{
+    yuv_rgb_avx2_t k;
+
+    SetupAVX2( &k, c );
+    for( ; x + 16 <= width; x += 16 )
+    {
+        ConvertAVX2( dst + 4 * x,
+            _mm256_loadu_si256( (const __m256i *)(py + 2 * x) ),
+            Dup16AVX2( _mm_loadu_si128( (const __m128i *)(pu + x) ) ),
+            Dup16AVX2( _mm_loadu_si128( (const __m128i *)(pv + x) ) ), &k );
+    }
+    RowPlanar16C( dst, py, pu, pv, x, width, c );
+}
+
+AVX2 static void RowSemiPlanar16AVX2( uint8_t *dst, const uint8_t *py,
+                                      const uint8_t *puv, const uint8_t *pv,
+                                      unsigned x, unsigned width,
+                                      const yuv_rgb_coeffs_t *c )
+{
+    const __m256i shuf_u = _mm256_setr_epi8(
+        0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13,
+        0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13 );
+    const __m256i shuf_v = _mm256_add_epi8( shuf_u, _mm256_set1_epi8( 2 ) );
+    yuv_rgb_avx2_t k;
+
+    SetupAVX2( &k, c );
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m256i y = _mm256_loadu_si256( (const __m256i *)(py + 2 * x) );
+        __m256i uv = _mm256_loadu_si256( (const __m256i *)(puv + 2 * x) );
+
+        y = _mm256_srli_epi16( y, 6 );
+        uv = _mm256_srli_epi16( uv, 6 );
+        ConvertAVX2( dst + 4 * x, y, _mm256_shuffle_epi8( uv, shuf_u ),
+                     _mm256_shuffle_epi8( uv, shuf_v ), &k );
+    }
+    RowSemiPlanar16C( dst, py, puv, pv, x, width, c );
+}
+
+static const yuv_rgb_row_t rows_avx2[] = {
+    [YUV_PLANAR_8]      = RowPlanar8AVX2,
+    [YUV_SEMIPLANAR_8]  = RowSemiPlanar8AVX2,
+    [YUV_PLANAR_16]     = RowPlanar16AVX2,
+    [YUV_SEMIPLANAR_16] = RowSemiPlanar16AVX2,
+};
+#endif
+
+/*****************************************************************************
+ * NEON version: 16 pixels per iteration
+ *****************************************************************************/
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static inline uint8x8_t ComponentNEON( int32x4_t ylo, int32x4_t yhi,
+                                       int16x8_t u, int16x8_t v,
+                                       int16_t cu, int16_t cv, int32x4_t shift )
+{
+    int32x4_t lo = vmlal_n_s16( vmlal_n_s16( ylo, vget_low_s16( u ), cu ),
+                                vget_low_s16( v ), cv );
+    int32x4_t hi = vmlal_n_s16( vmlal_n_s16( yhi, vget_high_s16( u ), cu ),
+                                vget_high_s16( v ), cv );
+
+    lo = vshlq_s32( lo, shift );
+    hi = vshlq_s32( hi, shift );
+    return vqmovn_u16( vcombine_u16( vqmovun_s32( lo ), vqmovun_s32( hi ) ) );
+}
+
+/* Converts 8 pixels, from 16-bits samples in pixel order */
+static inline void ConvertNEON( uint8_t *dst, uint16x8_t y, uint16x8_t u,
+                                uint16x8_t v, const yuv_rgb_coeffs_t *c )
+{
+    const int32x4_t shift = vdupq_n_s32( -c->shift );
+    const int32x4_t round = vdupq_n_s32( c->round );
+    int16x8_t ys = vsubq_s16( vreinterpretq_s16_u16( y ),
+                              vdupq_n_s16( c->y_offset ) );
+    int16x8_t us = vsubq_s16( vreinterpretq_s16_u16( u ),
+                              vdupq_n_s16( c->c_offset ) );
+    int16x8_t vs = vsubq_s16( vreinterpretq_s16_u16( v ),
+                              vdupq_n_s16( c->c_offset ) );
+    int32x4_t ylo = vmlal_n_s16( round, vget_low_s16( ys ), c->y );
+    int32x4_t yhi = vmlal_n_s16( round, vget_high_s16( ys ), c->y );
+    uint8x8x4_t px;
+
+    px.val[c->r] = ComponentNEON( ylo, yhi, us, vs, c->ru, c->rv, shift );
+    px.val[c->g] = ComponentNEON( ylo, yhi, us, vs, c->gu, c->gv, shift );
+    px.val[c->b] = ComponentNEON( ylo, yhi, us, vs, c->bu, c->bv, shift );
+    px.val[c->a] = vdup_n_u8( 0xff );
+    vst4_u8( dst, px );
+}
+
+static void RowPlanar8NEON( uint8_t *dst, const uint8_t *py,
+                            const uint8_t *pu, const uint8_t *pv,
+                            unsigned x, unsigned width,
+                            const yuv_rgb_coeffs_t *c )
+{
+    for( ; x + 16 <= width; x += 16 )
+    {
+        uint8x16_t y = vld1q_u8( py + x );
+        uint8x8_t u = vld1_u8( pu + x / 2 ), v = vld1_u8( pv + x / 2 );
+        uint8x8x2_t uu = vzip_u8( u, u ), vv = vzip_u8( v, v );
+
+        ConvertNEON( dst + 4 * x, vmovl_u8( vget_low_u8( y ) ),
+                     vmovl_u8( uu.val[0] ), vmovl_u8( vv.val[0] ), c );
+        ConvertNEON( dst + 4 * (x + 8), vmovl_u8( vget_high_u8( y ) ),
+                     vmovl_u8( uu.val[1] ), vmovl_u8( vv.val[1] ), c );
+    }
+    RowPlanar8C( dst, py, pu, pv, x, width, c );
+}
+
+static void RowSemiPlanar8NEON( uint8_t *dst, const uint8_t *py,
+                                const uint8_t *puv, const uint8_t *pv,
+                                unsigned x, unsigned width,
+                                const yuv_rgb_coeffs_t *c )
+{
+    for( ; x + 16 <= width; x += 16 )
+    {
+        uint8x16_t y = vld1q_u8( py + x );
+        uint8x8x2_t uv = vld2_u8( puv + x );
+        uint8x8x2_t uu = vzip_u8( uv.val[0], uv.val[0] );
+        uint8x8x2_t vv = vzip_u8( uv.val[1], uv.val[1] );
+
+        ConvertNEON( dst + 4 * x, vmovl_u8( vget_low_u8( y ) ),
+                     vmovl_u8( uu.val[0] ), vmovl_u8( vv.val[0] ), c );
+        ConvertNEON( dst + 4 * (x + 8), vmovl_u8( vget_high_u8( y ) ),
+                     vmovl_u8( uu.val[1] ), vmovl_u8( vv.val[1] ), c );
+    }
+    RowSemiPlanar8C( dst, py, puv, pv, x, width, c );
+}
+
+static void RowPlanar16NEON( uint8_t *dst, const uint8_t *py,
+                             const uint8_t *pu, const uint8_t *pv,
+                             unsigned x, unsigned width,
+                             const yuv_rgb_coeffs_t *c )
+{
+    const uint16_t *y16 = (const uint16_t *)py;
+    const uint16_t *u16 = (const uint16_t *)pu, *v16 = (const uint16_t *)pv;
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        uint16x8_t u = vld1q_u16( u16 + x / 2 ), v = vld1q_u16( v16 + x / 2 );
+        uint16x8x2_t uu = vzipq_u16( u, u ), vv = vzipq_u16( v, v );
+
+        ConvertNEON( dst + 4 * x, vld1q_u16( y16 + x ),
+                     uu.val[0], vv.val[0], c );
+        ConvertNEON( dst + 4 * (x + 8), vld1q_u16( y16 + x + 8 ),
+                     uu.val[1], vv.val[1], c );
+    }
+    RowPlanar16C( dst, py, pu, pv, x, width, c );
+}
+
+static void RowSemiPlanar16NEON( uint8_t *dst, const uint8_t *py,
+                                 const uint8_t *puv, const uint8_t *pv,
+                                 unsigned x, unsigned width,
+                                 const yuv_rgb_coeffs_t *c )
+{
+    const uint16_t *y16 = (const uint16_t *)py;
+    const uint16_t *uv16 = (const uint16_t *)puv;
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        uint16x8x2_t uv = vld2q_u16( uv16 + x );
+        uint16x8_t u = vshrq_n_u16( uv.val[0], 6 );
+        uint16x8_t v = vshrq_n_u16( uv.val[1], 6 );
+        uint16x8x2_t uu = vzipq_u16( u, u ), vv = vzipq_u16( v, v );
+
+        ConvertNEON( dst + 4 * x, vshrq_n_u16( vld1q_u16( y16 + x ), 6 ),
+                     uu.val[0], vv.val[0], c );
+        ConvertNEON( dst + 4 * (x + 8),
+                     vshrq_n_u16( vld1q_u16( y16 + x + 8 ), 6 ),
+                     uu.val[1], vv.val[1], c );
+    }
+    RowSemiPlanar16C( dst, py, puv, pv, x, width, c );
+}
+
+static const yuv_rgb_row_t rows_neon[] = {
+    [YUV_PLANAR_8]      = RowPlanar8NEON,
+    [YUV_SEMIPLANAR_8]  = RowSemiPlanar8NEON,
+    [YUV_PLANAR_16]     = RowPlanar16NEON,
+    [YUV_SEMIPLANAR_16] = RowSemiPlanar16NEON,
+};
+#endif
+
+/*****************************************************************************
+ * Filter
+ *****************************************************************************/
+static void Slice( filter_t *p_filter, picture_t *p_dst,
+                   const picture_t *p_src, unsigned y0, unsigned y1 )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const plane_t *y = &p_src->p[0];
+    const plane_t *u = &p_src->p[p_sys->u_plane];
+    const plane_t *v = &p_src->p[p_sys->v_plane];
+    const plane_t *d = &p_dst->p[0];
+    unsigned width = __MIN( y->i_visible_pitch / p_sys->pixel_size,
+                            d->i_visible_pitch / 4 );
+
+    for( unsigned i = y0; i < y1; i++ )
+    {
+        unsigned ci = i >> p_sys->chroma_vshift;
+
+        p_sys->row( &d->p_pixels[i * d->i_pitch],
+                    &y->p_pixels[i * y->i_pitch],
+                    &u->p_pixels[ci * u->i_pitch],
+                    &v->p_pixels[ci * v->i_pitch],
+                    0, width, &p_sys->coeffs );
+    }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_src )
+{
+    picture_t *p_dst = filter_NewPicture( p_filter );
+    if( p_dst == NULL )
+    {
+        picture_Release( p_src );
+        return NULL;
+    }
+
+    Slice( p_filter, p_dst, p_src, 0, __MIN( p_src->p[0].i_visible_lines,
+                                             p_dst->p[0].i_visible_lines ) );
+
+    picture_CopyProperties( p_dst, p_src );
+    picture_Release( p_src );
+    return p_dst;
+}
+
+/*****************************************************************************
+ * Open: check the formats and compute the coefficients
+ *****************************************************************************/
+
+/* Memory offset of a 8-bits component of a RV32 pixel */
+static int MaskOffset( uint32_t mask )
+{
+    if( mask == 0 )
+        return -1;
+
+    unsigned shift = ctz( mask );
+    if( (shift % 8) != 0 || (mask >> shift) != 0xff )
+        return -1;
+#ifdef WORDS_BIGENDIAN
+    return 3 - shift / 8;
+#else
+    return shift / 8;
+#endif
+}
+
+static int SetOutput( yuv_rgb_coeffs_t *c, const video_format_t *fmt )
+{
+    switch( fmt->i_chroma )
+    {
+        case VLC_CODEC_RGBA:
+            c->r = 0; c->g = 1; c->b = 2; c->a = 3;
+            return VLC_SUCCESS;
+        case VLC_CODEC_BGRA:
+            c->b = 0; c->g = 1; c->r = 2; c->a = 3;
+            return VLC_SUCCESS;
+        case VLC_CODEC_RGB32:
+        {
+            video_format_t rgb = *fmt;
+            video_format_FixRgb( &rgb );
+
+            int r = MaskOffset( rgb.i_rmask );
+            int g = MaskOffset( rgb.i_gmask );
+            int b = MaskOffset( rgb.i_bmask );
+            if( r < 0 || g < 0 || b < 0 || r == g || g == b || b == r )
+                return VLC_EGENERIC;
+            c->r = r; c->g = g; c->b = b;
+            c->a = 6 - r - g - b; /* the unused byte */
+            return VLC_SUCCESS;
+        }
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void SetMatrix( yuv_rgb_coeffs_t *c, video_color_space_t space,
+                       bool full_range, unsigned bits, bool swap_uv )
+{
+    double kr, kb;
+
+    switch( space )
+    {
+        case COLOR_SPACE_BT709:
+            kr = 0.2126; kb = 0.0722;
+            break;
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627; kb = 0.0593;
+            break;
+        default:
+            kr = 0.299; kb = 0.114;
+            break;
+    }
+
+    const double kg = 1. - kr - kb;
+    const double scale = 1 << YUV_RGB_PRECISION;
+    const double ys = full_range ? 1. : 255. / 219.;
+    const double cs = full_range ? 1. : 255. / 224.;
+
+    c->y_offset = full_range ? 0 : 16 << (bits - 8);
+    c->c_offset = 128 << (bits - 8);
+    c->shift = YUV_RGB_PRECISION + bits - 8;
+    c->round = 1 << (c->shift - 1);
+    c->y = lround( ys * scale );
+    c->ru = 0;
+    c->rv = lround( cs * 2. * (1. - kr) * scale );
+    c->gu = -lround( cs * 2. * kb * (1. - kb) / kg * scale );
+    c->gv = -lround( cs * 2. * kr * (1. - kr) / kg * scale );
+    c->bu = lround( cs * 2. * (1. - kb) * scale );
+    c->bv = 0;
+
+    if( swap_uv )
+    {
+        int16_t tmp;
+
+        tmp = c->ru; c->ru = c->rv; c->rv = tmp;
+        tmp = c->gu; c->gu = c->gv; c->gv = tmp;
+        tmp = c->bu; c->bu = c->bv; c->bv = tmp;
+    }
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *in = &p_filter->fmt_in.video;
+    const video_format_t *out = &p_filter->fmt_out.video;
+    unsigned layout, bits = 8, vshift = 1;
+    bool full_range = in->b_color_range_full;
+    bool swap_planes = false, swap_uv = false;
+
+    if( in->i_x_offset != out->i_x_offset
+     || in->i_y_offset != out->i_y_offset
+     || in->i_visible_width != out->i_visible_width
+     || in->i_visible_height != out->i_visible_height
+     || in->orientation != out->orientation )
+        return VLC_EGENERIC;
+
+    switch( in->i_chroma )
+    {
+        case VLC_CODEC_J420:
+            full_range = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+            layout = YUV_PLANAR_8;
+            break;
+        case VLC_CODEC_YV12:
+            layout = YUV_PLANAR_8;
+            swap_planes = true;
+            break;
+        case VLC_CODEC_J422:
+            full_range = true;
+            /* fall through */
+        case VLC_CODEC_I422:
+            layout = YUV_PLANAR_8;
+            vshift = 0;
+            break;
+        case VLC_CODEC_NV21:
+            swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_NV12:
+            layout = YUV_SEMIPLANAR_8;
+            break;
+        case VLC_CODEC_I420_10L:
+            layout = YUV_PLANAR_16;
+            bits = 10;
+            break;
+        case VLC_CODEC_I422_10L:
+            layout = YUV_PLANAR_16;
+            bits = 10;
+            vshift = 0;
+            break;
+        case VLC_CODEC_P010:
+            layout = YUV_SEMIPLANAR_16;
+            bits = 10;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    yuv_rgb_coeffs_t coeffs;
+    if( SetOutput( &coeffs, out ) )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = vlc_obj_malloc( p_this, sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    video_color_space_t space = in->space;
+    if( space == COLOR_SPACE_UNDEF )
+        space = in->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                           : COLOR_SPACE_BT601;
+    SetMatrix( &coeffs, space, full_range, bits, swap_uv );
+    p_sys->coeffs = coeffs;
+
+    p_sys->row = rows_c[layout];
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        p_sys->row = rows_avx2[layout];
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->row = rows_neon[layout];
+#endif
+    p_sys->pixel_size = bits > 8 ? 2 : 1;
+    p_sys->chroma_vshift = vshift;
+    if( layout == YUV_SEMIPLANAR_8 || layout == YUV_SEMIPLANAR_16 )
+        p_sys->u_plane = p_sys->v_plane = 1;
+    else
+    {
+        p_sys->u_plane = swap_planes ? 2 : 1;
+        p_sys->v_plane = swap_planes ? 1 : 2;
+    }
+
+    msg_Dbg( p_filter, "%4.4s to %4.4s, %s matrix, %s range",
+             (const char *)&in->i_chroma, (const char *)&out->i_chroma,
+             space == COLOR_SPACE_BT2020 ? "BT.2020" :
+             space == COLOR_SPACE_BT709 ? "BT.709" : "BT.601",
+             full_range ? "full" : "limited" );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_slice = Slice;
+    return VLC_SUCCESS;
+}
+
+#ifdef YUV_RGB_TEST
+/* Checks every vector version against the C one, on the same input */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_WIDTH 1937 /* not a multiple of any vector size */
+
+static const char *const layout_names[] = {
+    [YUV_PLANAR_8]      = "planar 8-bits",
+    [YUV_SEMIPLANAR_8]  = "semi-planar 8-bits",
+    [YUV_PLANAR_16]     = "planar 10-bits",
+    [YUV_SEMIPLANAR_16] = "semi-planar 10-bits",
+};
+
+/* Fills a row with random samples, covering the whole range */
+static void Fill( uint8_t *buf, unsigned count, unsigned layout )
+{
+    for( unsigned i = 0; i < count; i++ )
+        switch( layout )
+        {
+            case YUV_PLANAR_8:
+            case YUV_SEMIPLANAR_8:
+                buf[i] = rand();
+                break;
+            case YUV_PLANAR_16:
+                ((uint16_t *)buf)[i] = rand() & 0x3ff;
+                break;
+            default:
+                ((uint16_t *)buf)[i] = rand() << 6;
+                break;
+        }
+}
+
+static void Test( const char *isa, const yuv_rgb_row_t *rows )
+{
+    static uint16_t y[TEST_WIDTH], u[TEST_WIDTH + 1], v[TEST_WIDTH];
+    static uint8_t ref[4 * TEST_WIDTH], out[4 * TEST_WIDTH];
+    static const video_color_space_t spaces[] = {
+        COLOR_SPACE_BT601, COLOR_SPACE_BT709, COLOR_SPACE_BT2020,
+    };
+    static const vlc_fourcc_t chromas[] = {
+        VLC_CODEC_RGBA, VLC_CODEC_BGRA, VLC_CODEC_RGB32,
+    };
+    static const unsigned widths[] = { 1, 2, 15, 16, 17, 31, 33, TEST_WIDTH };
+
+    printf( "%s...\n", isa );
+
+    for( unsigned layout = 0; layout < ARRAY_SIZE(rows_c); layout++ )
+    {
+        const bool semiplanar = layout == YUV_SEMIPLANAR_8
+                             || layout == YUV_SEMIPLANAR_16;
+        const unsigned bits = layout >= YUV_PLANAR_16 ? 10 : 8;
+
+        Fill( (uint8_t *)y, TEST_WIDTH, layout );
+        Fill( (uint8_t *)u, semiplanar ? TEST_WIDTH + 1 : TEST_WIDTH / 2 + 1,
+              layout );
+        Fill( (uint8_t *)v, TEST_WIDTH / 2 + 1, layout );
+
+        for( size_t s = 0; s < ARRAY_SIZE(spaces); s++ )
+            for( size_t c = 0; c < ARRAY_SIZE(chromas); c++ )
+                for( unsigned flags = 0; flags < 4; flags++ )
+                {
+                    video_format_t fmt;
+                    yuv_rgb_coeffs_t coeffs;
+
+                    video_format_Init( &fmt, chromas[c] );
+                    if( SetOutput( &coeffs, &fmt ) )
+                        abort();
+                    SetMatrix( &coeffs, spaces[s], flags & 1, bits,
+                               flags & 2 );
+
+                    for( size_t w = 0; w < ARRAY_SIZE(widths); w++ )
+                    {
+                        memset( ref, 0, sizeof (ref) );
+                        memset( out, 0, sizeof (out) );
+                        rows_c[layout]( ref, (uint8_t *)y, (uint8_t *)u,
+                                        (uint8_t *)v, 0, widths[w], &coeffs );
+                        rows[layout]( out, (uint8_t *)y, (uint8_t *)u,
+                                      (uint8_t *)v, 0, widths[w], &coeffs );
+
+                        if( memcmp( ref, out, sizeof (ref) ) )
+                        {
+                            fprintf( stderr, "%s %s, width %u: mismatch\n",
+                                     isa, layout_names[layout], widths[w] );
+                            abort();
+                        }
+                    }
+                }
+    }
+}
+
+int main( void )
+{
+    srand( 0 );
+    Test( "C", rows_c );
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        Test( "AVX2", rows_avx2 );
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if( vlc_CPU_ARM_NEON() )
+        Test( "NEON", rows_neon );
+#endif
+    return 0;
+}
+#endif /* YUV_RGB_TEST */
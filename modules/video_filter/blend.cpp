@@ -32,17 +32,35 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define KERNEL_TEXT N_("Blending kernels")
+#define KERNEL_LONGTEXT N_( \
+    "Force the blending routines to use: \"generic\" per-pixel code, " \
+    "\"c\" row code, or vectorized \"sse2\", \"avx2\" or \"neon\" " \
+    "row code. This is for testing purposes; by default, the fastest " \
+    "supported one is used.")
+
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_capability("video blending", 100)
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VFILTER)
+    add_string("blend-kernel", NULL, KERNEL_TEXT, KERNEL_LONGTEXT, true)
     set_callbacks(Open, Close)
 vlc_module_end()
 
@@ -83,6 +101,18 @@ public:
     {
         return true;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
 
 protected:
     template <unsigned ry>
@@ -548,6 +578,667 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/*****************************************************************************
+ * Row kernels
+ *****************************************************************************
+ * The most common cases (YUVA or RGBA onto I420, YV12, NV12, NV21 and RV32)
+ * are blended by whole rows, with vectorized kernels where available.
+ * They give the same results as the per-pixel templates above.
+ *****************************************************************************/
+struct blend_kernels_t {
+    const char *name;
+    bool (*available)(void);
+    /* dst[i] = src[i] with alpha a[i] */
+    void (*row)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                unsigned alpha, unsigned count);
+    /* dst[i] = src[2 * i] with alpha a[2 * i] */
+    void (*row_sub2)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                     unsigned alpha, unsigned count);
+    /* dst[2 * i] = u[2 * i] and dst[2 * i + 1] = v[2 * i], with alpha
+     * a[2 * i] */
+    void (*row_uv)(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                   const uint8_t *a, unsigned alpha, unsigned count);
+    /* Packed RGBA onto 32-bits RGB (R, G, B, X or B, G, R, X if swap) */
+    void (*row_rgbx)(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                     unsigned count, bool swap);
+};
+
+static bool KernelAlways(void)
+{
+    return true;
+}
+
+static void blend_row_c(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        merge(&dst[i], src[i], div255(alpha * a[i]));
+}
+
+static void blend_row_sub2_c(uint8_t *dst, const uint8_t *src,
+                             const uint8_t *a, unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+        merge(&dst[i], src[2 * i], div255(alpha * a[2 * i]));
+}
+
+static void blend_row_uv_c(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                           const uint8_t *a, unsigned alpha, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        unsigned f = div255(alpha * a[2 * i]);
+
+        merge(&dst[2 * i + 0], u[2 * i], f);
+        merge(&dst[2 * i + 1], v[2 * i], f);
+    }
+}
+
+static void blend_row_rgbx_c(uint8_t *dst, const uint8_t *src,
+                             unsigned alpha, unsigned count, bool swap)
+{
+    const unsigned offset_r = swap ? 2 : 0;
+    const unsigned offset_b = swap ? 0 : 2;
+
+    for (unsigned i = 0; i < count; i++, dst += 4, src += 4) {
+        unsigned f = div255(alpha * src[3]);
+
+        merge(&dst[offset_r], src[0], f);
+        merge(&dst[1],        src[1], f);
+        merge(&dst[offset_b], src[2], f);
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+# define SSE2 __attribute__ ((__target__ ("sse2")))
+
+static bool KernelSSE2(void)
+{
+    return vlc_CPU_SSE2();
+}
+
+SSE2 static inline __m128i div255_sse2(__m128i v)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)),
+                                        one), 8);
+}
+
+/* Merges 8 pixels, in 16-bits lanes */
+SSE2 static inline __m128i merge_sse2(__m128i d, __m128i s, __m128i a,
+                                      __m128i alpha)
+{
+    const __m128i max = _mm_set1_epi16(255);
+
+    a = div255_sse2(_mm_mullo_epi16(a, alpha));
+    return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, a), d),
+                                     _mm_mullo_epi16(s, a)));
+}
+
+SSE2 static void blend_row_sse2(uint8_t *dst, const uint8_t *src,
+                                const uint8_t *a, unsigned alpha,
+                                unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i f = _mm_loadu_si128((const __m128i *)&a[i]);
+        __m128i lo = merge_sse2(_mm_unpacklo_epi8(d, zero),
+                                _mm_unpacklo_epi8(s, zero),
+                                _mm_unpacklo_epi8(f, zero), va);
+        __m128i hi = merge_sse2(_mm_unpackhi_epi8(d, zero),
+                                _mm_unpackhi_epi8(s, zero),
+                                _mm_unpackhi_epi8(f, zero), va);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    blend_row_c(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+SSE2 static void blend_row_sub2_sse2(uint8_t *dst, const uint8_t *src,
+                                     const uint8_t *a, unsigned alpha,
+                                     unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0xff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    /* Do not read past the last used source byte */
+    for (; i + 16 < count; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        __m128i s0 = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+        __m128i s1 = _mm_loadu_si128((const __m128i *)&src[2 * i + 16]);
+        __m128i f0 = _mm_loadu_si128((const __m128i *)&a[2 * i]);
+        __m128i f1 = _mm_loadu_si128((const __m128i *)&a[2 * i + 16]);
+        __m128i lo = merge_sse2(_mm_unpacklo_epi8(d, zero),
+                                _mm_and_si128(s0, even),
+                                _mm_and_si128(f0, even), va);
+        __m128i hi = merge_sse2(_mm_unpackhi_epi8(d, zero),
+                                _mm_and_si128(s1, even),
+                                _mm_and_si128(f1, even), va);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    blend_row_sub2_c(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+SSE2 static void blend_row_uv_sse2(uint8_t *dst, const uint8_t *u,
+                                   const uint8_t *v, const uint8_t *a,
+                                   unsigned alpha, unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0xff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 8 < count; i += 8) {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[2 * i]);
+        __m128i su = _mm_and_si128(_mm_loadu_si128((const __m128i *)&u[2 * i]),
+                                   even);
+        __m128i sv = _mm_and_si128(_mm_loadu_si128((const __m128i *)&v[2 * i]),
+                                   even);
+        __m128i f = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * i]),
+                                  even);
+        __m128i lo = merge_sse2(_mm_unpacklo_epi8(d, zero),
+                                _mm_unpacklo_epi16(su, sv),
+                                _mm_unpacklo_epi16(f, f), va);
+        __m128i hi = merge_sse2(_mm_unpackhi_epi8(d, zero),
+                                _mm_unpackhi_epi16(su, sv),
+                                _mm_unpackhi_epi16(f, f), va);
+        _mm_storeu_si128((__m128i *)&dst[2 * i], _mm_packus_epi16(lo, hi));
+    }
+    blend_row_uv_c(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha,
+                   count - i);
+}
+
+/* Spreads the alpha of 2 pixels to their color components, and clears it
+ * for the fourth (unused) component. */
+SSE2 static inline __m128i rgbx_alpha_sse2(__m128i s)
+{
+    const __m128i rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    __m128i f = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    return _mm_and_si128(f, rgb);
+}
+
+template <bool swap>
+SSE2 static inline __m128i rgbx_order_sse2(__m128i s)
+{
+    if (!swap)
+        return s;
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3,0,1,2)),
+                               _MM_SHUFFLE(3,0,1,2));
+}
+
+template <bool swap>
+SSE2 static void blend_rgbx_sse2(uint8_t *dst, const uint8_t *src,
+                                 unsigned alpha, unsigned count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+        __m128i slo = _mm_unpacklo_epi8(s, zero);
+        __m128i shi = _mm_unpackhi_epi8(s, zero);
+        __m128i lo = merge_sse2(_mm_unpacklo_epi8(d, zero),
+                                rgbx_order_sse2<swap>(slo),
+                                rgbx_alpha_sse2(slo), va);
+        __m128i hi = merge_sse2(_mm_unpackhi_epi8(d, zero),
+                                rgbx_order_sse2<swap>(shi),
+                                rgbx_alpha_sse2(shi), va);
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+    }
+    blend_row_rgbx_c(&dst[4 * i], &src[4 * i], alpha, count - i, swap);
+}
+
+SSE2 static void blend_row_rgbx_sse2(uint8_t *dst, const uint8_t *src,
+                                     unsigned alpha, unsigned count, bool swap)
+{
+    if (swap)
+        blend_rgbx_sse2<true>(dst, src, alpha, count);
+    else
+        blend_rgbx_sse2<false>(dst, src, alpha, count);
+}
+
+# ifdef HAVE_AVX2_INTRINSICS
+#  define HAVE_BLEND_AVX2
+#  define AVX2 __attribute__ ((__target__ ("avx2")))
+
+static bool KernelAVX2(void)
+{
+    return vlc_CPU_AVX2();
+}
+
+AVX2 static inline __m256i div255_avx2(__m256i v)
+{
+    const __m256i one = _mm256_set1_epi16(1);
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v,
+                                              _mm256_srli_epi16(v, 8)), one), 8);
+}
+
+/* Merges 16 pixels, in 16-bits lanes */
+AVX2 static inline __m256i merge_avx2(__m256i d, __m256i s, __m256i a,
+                                      __m256i alpha)
+{
+    const __m256i max = _mm256_set1_epi16(255);
+
+    a = div255_avx2(_mm256_mullo_epi16(a, alpha));
+    return div255_avx2(_mm256_add_epi16(
+                _mm256_mullo_epi16(_mm256_sub_epi16(max, a), d),
+                _mm256_mullo_epi16(s, a)));
+}
+
+/* Loads 16 bytes into 16-bits lanes, in order */
+AVX2 static inline __m256i load16_avx2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+/* Packs two vectors of 16-bits lanes into 32 bytes, in order */
+AVX2 static inline void store32_avx2(uint8_t *p, __m256i lo, __m256i hi)
+{
+    __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                         _MM_SHUFFLE(3,1,2,0));
+    _mm256_storeu_si256((__m256i *)p, v);
+}
+
+AVX2 static void blend_row_avx2(uint8_t *dst, const uint8_t *src,
+                                const uint8_t *a, unsigned alpha,
+                                unsigned count)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        __m256i lo = merge_avx2(load16_avx2(&dst[i]), load16_avx2(&src[i]),
+                                load16_avx2(&a[i]), va);
+        __m256i hi = merge_avx2(load16_avx2(&dst[i + 16]),
+                                load16_avx2(&src[i + 16]),
+                                load16_avx2(&a[i + 16]), va);
+        store32_avx2(&dst[i], lo, hi);
+    }
+    blend_row_sse2(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+AVX2 static void blend_row_sub2_avx2(uint8_t *dst, const uint8_t *src,
+                                     const uint8_t *a, unsigned alpha,
+                                     unsigned count)
+{
+    const __m256i even = _mm256_set1_epi16(0xff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 < count; i += 32) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i *)&src[2 * i]);
+        __m256i s1 = _mm256_loadu_si256((const __m256i *)&src[2 * i + 32]);
+        __m256i f0 = _mm256_loadu_si256((const __m256i *)&a[2 * i]);
+        __m256i f1 = _mm256_loadu_si256((const __m256i *)&a[2 * i + 32]);
+        __m256i lo = merge_avx2(load16_avx2(&dst[i]),
+                                _mm256_and_si256(s0, even),
+                                _mm256_and_si256(f0, even), va);
+        __m256i hi = merge_avx2(load16_avx2(&dst[i + 16]),
+                                _mm256_and_si256(s1, even),
+                                _mm256_and_si256(f1, even), va);
+        store32_avx2(&dst[i], lo, hi);
+    }
+    blend_row_sub2_sse2(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+AVX2 static void blend_row_uv_avx2(uint8_t *dst, const uint8_t *u,
+                                   const uint8_t *v, const uint8_t *a,
+                                   unsigned alpha, unsigned count)
+{
+    const __m256i even = _mm256_set1_epi16(0xff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < count; i += 16) {
+        __m256i su = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&u[2 * i]), even);
+        __m256i sv = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&v[2 * i]), even);
+        __m256i f = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&a[2 * i]), even);
+        /* Interleave within 128-bits lanes, then restore the order */
+        __m256i uvlo = _mm256_unpacklo_epi16(su, sv);
+        __m256i uvhi = _mm256_unpackhi_epi16(su, sv);
+        __m256i flo = _mm256_unpacklo_epi16(f, f);
+        __m256i fhi = _mm256_unpackhi_epi16(f, f);
+        __m256i lo = merge_avx2(load16_avx2(&dst[2 * i]),
+                                _mm256_permute2x128_si256(uvlo, uvhi, 0x20),
+                                _mm256_permute2x128_si256(flo, fhi, 0x20), va);
+        __m256i hi = merge_avx2(load16_avx2(&dst[2 * i + 16]),
+                                _mm256_permute2x128_si256(uvlo, uvhi, 0x31),
+                                _mm256_permute2x128_si256(flo, fhi, 0x31), va);
+        store32_avx2(&dst[2 * i], lo, hi);
+    }
+    blend_row_uv_sse2(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha,
+                      count - i);
+}
+
+AVX2 static inline __m256i rgbx_alpha_avx2(__m256i s)
+{
+    const __m256i rgb = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                         0, -1, -1, -1, 0, -1, -1, -1);
+    __m256i f = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+    return _mm256_and_si256(f, rgb);
+}
+
+template <bool swap>
+AVX2 static inline __m256i rgbx_order_avx2(__m256i s)
+{
+    if (!swap)
+        return s;
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s,
+                                  _MM_SHUFFLE(3,0,1,2)), _MM_SHUFFLE(3,0,1,2));
+}
+
+template <bool swap>
+AVX2 static void blend_rgbx_avx2(uint8_t *dst, const uint8_t *src,
+                                 unsigned alpha, unsigned count)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i slo = load16_avx2(&src[4 * i]);
+        __m256i shi = load16_avx2(&src[4 * i + 16]);
+        __m256i lo = merge_avx2(load16_avx2(&dst[4 * i]),
+                                rgbx_order_avx2<swap>(slo),
+                                rgbx_alpha_avx2(slo), va);
+        __m256i hi = merge_avx2(load16_avx2(&dst[4 * i + 16]),
+                                rgbx_order_avx2<swap>(shi),
+                                rgbx_alpha_avx2(shi), va);
+        store32_avx2(&dst[4 * i], lo, hi);
+    }
+    blend_row_rgbx_sse2(&dst[4 * i], &src[4 * i], alpha, count - i, swap);
+}
+
+AVX2 static void blend_row_rgbx_avx2(uint8_t *dst, const uint8_t *src,
+                                     unsigned alpha, unsigned count, bool swap)
+{
+    if (swap)
+        blend_rgbx_avx2<true>(dst, src, alpha, count);
+    else
+        blend_rgbx_avx2<false>(dst, src, alpha, count);
+}
+# endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define HAVE_BLEND_NEON
+
+static inline uint16x8_t div255_neon(uint16x8_t v)
+{
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(v, vshrq_n_u16(v, 8)),
+                                 vdupq_n_u16(1)), 8);
+}
+
+/* Merges 8 pixels, alpha already multiplied by the global alpha */
+static inline uint8x8_t merge_neon(uint8x8_t d, uint8x8_t s, uint8x8_t a)
+{
+    uint16x8_t v = vmull_u8(vsub_u8(vdup_n_u8(255), a), d);
+    return vmovn_u16(div255_neon(vmlal_u8(v, s, a)));
+}
+
+static inline uint8x16_t merge16_neon(uint8x16_t d, uint8x16_t s,
+                                      uint8x16_t a)
+{
+    return vcombine_u8(merge_neon(vget_low_u8(d), vget_low_u8(s),
+                                  vget_low_u8(a)),
+                       merge_neon(vget_high_u8(d), vget_high_u8(s),
+                                  vget_high_u8(a)));
+}
+
+static inline uint8x16_t alpha16_neon(uint8x16_t a, uint8x8_t alpha)
+{
+    return vcombine_u8(vmovn_u16(div255_neon(vmull_u8(vget_low_u8(a), alpha))),
+                       vmovn_u16(div255_neon(vmull_u8(vget_high_u8(a), alpha))));
+}
+
+static void blend_row_neon(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                           unsigned alpha, unsigned count)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t f = alpha16_neon(vld1q_u8(&a[i]), va);
+        vst1q_u8(&dst[i], merge16_neon(vld1q_u8(&dst[i]), vld1q_u8(&src[i]), f));
+    }
+    blend_row_c(&dst[i], &src[i], &a[i], alpha, count - i);
+}
+
+static void blend_row_sub2_neon(uint8_t *dst, const uint8_t *src,
+                                const uint8_t *a, unsigned alpha,
+                                unsigned count)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < count; i += 16) {
+        uint8x16_t s = vld2q_u8(&src[2 * i]).val[0];
+        uint8x16_t f = alpha16_neon(vld2q_u8(&a[2 * i]).val[0], va);
+        vst1q_u8(&dst[i], merge16_neon(vld1q_u8(&dst[i]), s, f));
+    }
+    blend_row_sub2_c(&dst[i], &src[2 * i], &a[2 * i], alpha, count - i);
+}
+
+static void blend_row_uv_neon(uint8_t *dst, const uint8_t *u,
+                              const uint8_t *v, const uint8_t *a,
+                              unsigned alpha, unsigned count)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < count; i += 16) {
+        uint8x16x2_t d = vld2q_u8(&dst[2 * i]);
+        uint8x16_t f = alpha16_neon(vld2q_u8(&a[2 * i]).val[0], va);
+
+        d.val[0] = merge16_neon(d.val[0], vld2q_u8(&u[2 * i]).val[0], f);
+        d.val[1] = merge16_neon(d.val[1], vld2q_u8(&v[2 * i]).val[0], f);
+        vst2q_u8(&dst[2 * i], d);
+    }
+    blend_row_uv_c(&dst[2 * i], &u[2 * i], &v[2 * i], &a[2 * i], alpha,
+                   count - i);
+}
+
+static void blend_row_rgbx_neon(uint8_t *dst, const uint8_t *src,
+                                unsigned alpha, unsigned count, bool swap)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    const unsigned offset_r = swap ? 2 : 0;
+    const unsigned offset_b = swap ? 0 : 2;
+    unsigned i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t d = vld4q_u8(&dst[4 * i]);
+        uint8x16x4_t s = vld4q_u8(&src[4 * i]);
+        uint8x16_t f = alpha16_neon(s.val[3], va);
+
+        d.val[offset_r] = merge16_neon(d.val[offset_r], s.val[0], f);
+        d.val[1]        = merge16_neon(d.val[1],        s.val[1], f);
+        d.val[offset_b] = merge16_neon(d.val[offset_b], s.val[2], f);
+        vst4q_u8(&dst[4 * i], d);
+    }
+    blend_row_rgbx_c(&dst[4 * i], &src[4 * i], alpha, count - i, swap);
+}
+#endif
+
+/* In order of preference */
+static const blend_kernels_t blend_kernels[] = {
+#ifdef HAVE_BLEND_NEON
+    { "neon", KernelAlways, blend_row_neon, blend_row_sub2_neon,
+      blend_row_uv_neon, blend_row_rgbx_neon },
+#endif
+#ifdef HAVE_BLEND_AVX2
+    { "avx2", KernelAVX2, blend_row_avx2, blend_row_sub2_avx2,
+      blend_row_uv_avx2, blend_row_rgbx_avx2 },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { "sse2", KernelSSE2, blend_row_sse2, blend_row_sub2_sse2,
+      blend_row_uv_sse2, blend_row_rgbx_sse2 },
+#endif
+    { "c", KernelAlways, blend_row_c, blend_row_sub2_c,
+      blend_row_uv_c, blend_row_rgbx_c },
+};
+
+/* Source rows, in planar YUVA */
+struct CRowsYUVA {
+    const uint8_t *y, *u, *v, *a;
+};
+
+template <bool semiplanar, bool swap_uv>
+static void BlendRowYUV420(const blend_kernels_t *k, const picture_t *dst,
+                           unsigned dx, unsigned dy, const CRowsYUVA &src,
+                           unsigned width, int alpha)
+{
+    const plane_t *py = &dst->p[0];
+    k->row(&py->p_pixels[dy * py->i_pitch + dx], src.y, src.a, alpha, width);
+
+    /* Chroma is blended from the top-left source pixel of each 2x2 block */
+    const unsigned first = dx & 1;
+    if ((dy & 1) || width <= first)
+        return;
+
+    const unsigned count = (width - first + 1) / 2;
+    const unsigned cx = (dx + first) / 2;
+    const unsigned cy = dy / 2;
+
+    if (semiplanar) {
+        const plane_t *puv = &dst->p[1];
+        uint8_t *line = &puv->p_pixels[cy * puv->i_pitch + 2 * cx];
+
+        if (swap_uv)
+            k->row_uv(line, &src.v[first], &src.u[first], &src.a[first],
+                      alpha, count);
+        else
+            k->row_uv(line, &src.u[first], &src.v[first], &src.a[first],
+                      alpha, count);
+    } else {
+        const plane_t *pu = &dst->p[swap_uv ? 2 : 1];
+        const plane_t *pv = &dst->p[swap_uv ? 1 : 2];
+
+        k->row_sub2(&pu->p_pixels[cy * pu->i_pitch + cx], &src.u[first],
+                    &src.a[first], alpha, count);
+        k->row_sub2(&pv->p_pixels[cy * pv->i_pitch + cx], &src.v[first],
+                    &src.a[first], alpha, count);
+    }
+}
+
+template <bool semiplanar, bool swap_uv>
+static void BlendYUVAToYUV420(const blend_kernels_t *k, bool,
+                              const CPicture &dst_data,
+                              const CPicture &src_data,
+                              unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned sx = src_data.getX();
+    const unsigned sy = src_data.getY();
+
+    for (unsigned y = 0; y < height; y++) {
+        CRowsYUVA rows;
+
+        rows.y = &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch + sx];
+        rows.u = &src->p[1].p_pixels[(sy + y) * src->p[1].i_pitch + sx];
+        rows.v = &src->p[2].p_pixels[(sy + y) * src->p[2].i_pitch + sx];
+        rows.a = &src->p[3].p_pixels[(sy + y) * src->p[3].i_pitch + sx];
+        BlendRowYUV420<semiplanar, swap_uv>(k, dst, dst_data.getX(),
+                                            dst_data.getY() + y, rows,
+                                            width, alpha);
+    }
+}
+
+template <bool semiplanar, bool swap_uv>
+static void BlendRGBAToYUV420(const blend_kernels_t *k, bool,
+                              const CPicture &dst_data,
+                              const CPicture &src_data,
+                              unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned sx = src_data.getX();
+    const unsigned sy = src_data.getY();
+
+    uint8_t *buffer = (uint8_t *)malloc(4 * width);
+    if (unlikely(buffer == NULL))
+        return;
+
+    CRowsYUVA rows;
+    uint8_t *y_row = buffer;
+    uint8_t *u_row = &buffer[width];
+    uint8_t *v_row = &buffer[2 * width];
+    uint8_t *a_row = &buffer[3 * width];
+
+    rows.y = y_row;
+    rows.u = u_row;
+    rows.v = v_row;
+    rows.a = a_row;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *rgba =
+            &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch + 4 * sx];
+
+        /* Convert the source row to planar YUVA first */
+        for (unsigned x = 0; x < width; x++, rgba += 4) {
+            rgb_to_yuv(&y_row[x], &u_row[x], &v_row[x],
+                       rgba[0], rgba[1], rgba[2]);
+            a_row[x] = rgba[3];
+        }
+        BlendRowYUV420<semiplanar, swap_uv>(k, dst, dst_data.getX(),
+                                            dst_data.getY() + y, rows,
+                                            width, alpha);
+    }
+    free(buffer);
+}
+
+static void BlendRGBAToRGBX(const blend_kernels_t *k, bool swap,
+                            const CPicture &dst_data,
+                            const CPicture &src_data,
+                            unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const plane_t *pd = &dst->p[0];
+    const plane_t *ps = &src->p[0];
+
+    for (unsigned y = 0; y < height; y++)
+        k->row_rgbx(&pd->p_pixels[(dst_data.getY() + y) * pd->i_pitch
+                                  + 4 * dst_data.getX()],
+                    &ps->p_pixels[(src_data.getY() + y) * ps->i_pitch
+                                  + 4 * src_data.getX()],
+                    alpha, width, swap);
+}
+
+typedef void (*blend_rows_function_t)(const blend_kernels_t *, bool,
+                                      const CPicture &dst_data,
+                                      const CPicture &src_data,
+                                      unsigned width, unsigned height,
+                                      int alpha);
+
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_rows_function_t blend;
+} blends_rows[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendYUVAToYUV420<true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendYUVAToYUV420<true,  true> },
+    { VLC_CODEC_I420,  VLC_CODEC_RGBA, BlendRGBAToYUV420<false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_RGBA, BlendRGBAToYUV420<false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_RGBA, BlendRGBAToYUV420<false, true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_RGBA, BlendRGBAToYUV420<true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_RGBA, BlendRGBAToYUV420<true,  true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRGBAToRGBX },
+};
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
@@ -626,10 +1317,13 @@ static const struct {
 };
 
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_rows(NULL), kernels(NULL), swap(false)
     {
     }
     blend_function_t blend;
+    blend_rows_function_t blend_rows;
+    const blend_kernels_t *kernels;
+    bool swap;
 };
 
 /**
@@ -657,13 +1351,18 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    CPicture dst_data(dst, &filter->fmt_out.video,
+                      filter->fmt_out.video.i_x_offset + x_offset,
+                      filter->fmt_out.video.i_y_offset + y_offset);
+    CPicture src_data(src, &filter->fmt_in.video,
+                      filter->fmt_in.video.i_x_offset,
+                      filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_rows != NULL)
+        sys->blend_rows(sys->kernels, sys->swap, dst_data, src_data,
+                        width, height, alpha);
+    else
+        sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -685,6 +1384,53 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    char *name = var_InheritString(filter, "blend-kernel");
+
+    if (name == NULL || strcmp(name, "generic")) {
+        for (size_t i = 0; i < sizeof(blends_rows) / sizeof(*blends_rows); i++) {
+            if (blends_rows[i].src == src && blends_rows[i].dst == dst)
+                sys->blend_rows = blends_rows[i].blend;
+        }
+    }
+
+    if (sys->blend_rows == BlendRGBAToRGBX) {
+        /* Only the common component orders are handled by rows */
+        video_format_t fmt = filter->fmt_out.video;
+        video_format_FixRgb(&fmt);
+#ifdef WORDS_BIGENDIAN
+        const unsigned offset_r = (32 - fmt.i_lrshift) / 8;
+        const unsigned offset_g = (32 - fmt.i_lgshift) / 8;
+        const unsigned offset_b = (32 - fmt.i_lbshift) / 8;
+#else
+        const unsigned offset_r = fmt.i_lrshift / 8;
+        const unsigned offset_g = fmt.i_lgshift / 8;
+        const unsigned offset_b = fmt.i_lbshift / 8;
+#endif
+        if (offset_g != 1 || !((offset_r == 0 && offset_b == 2)
+                            || (offset_r == 2 && offset_b == 0)))
+            sys->blend_rows = NULL;
+        sys->swap = offset_r == 2;
+    }
+
+    if (sys->blend_rows != NULL) {
+        for (size_t i = 0; i < sizeof(blend_kernels) / sizeof(*blend_kernels); i++) {
+            const blend_kernels_t *k = &blend_kernels[i];
+
+            if ((name == NULL || !strcmp(name, k->name)) && k->available()) {
+                sys->kernels = k;
+                break;
+            }
+        }
+        if (sys->kernels == NULL) {
+            msg_Err(filter, "blending kernels \"%s\" not available", name);
+            free(name);
+            delete sys;
+            return VLC_EGENERIC;
+        }
+        msg_Dbg(filter, "using %s blending kernels", sys->kernels->name);
+    }
+    free(name);
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
@@ -53,6 +53,10 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define LOOPS_TEXT N_("Number of time to blend")
 #define LOOPS_LONGTEXT N_("The number of time the blend will be performed")
 
+#define KERNELS_TEXT N_("Blending kernels")
+#define KERNELS_LONGTEXT N_("Comma-separated list of the blending kernels " \
+                            "to benchmark, one after the other")
+
 #define ALPHA_TEXT N_("Alpha of the blended image")
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
@@ -83,6 +87,8 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_string( CFG_PREFIX "kernels", "generic,c,sse2,avx2,neon",
+                KERNELS_TEXT, KERNELS_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
@@ -100,7 +106,7 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
+    "loops", "alpha", "kernels", "base-image", "base-chroma", "blend-image",
     "blend-chroma", NULL
 };
 
@@ -227,28 +233,27 @@ static void Destroy( vlc_object_t *p_this )
 /*****************************************************************************
  * Render: displays previously rendered output
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void blendbench_Run( filter_t *p_filter, const char *psz_kernel )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     filter_t *p_blend;
 
-    if( p_sys->b_done )
-        return p_pic;
-
     p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
+        return;
+
+    /* Use the requested blending kernels (see the blend module) */
+    var_Create( p_blend, "blend-kernel", VLC_VAR_STRING );
+    var_SetString( p_blend, "blend-kernel", psz_kernel );
+
     p_blend->fmt_out.video = p_sys->p_base_image->format;
     p_blend->fmt_in.video = p_sys->p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
+        msg_Info( p_filter, "%s: not available", psz_kernel );
         vlc_object_release( p_blend );
-        return NULL;
+        return;
     }
 
     mtime_t time = mdate();
@@ -260,17 +265,48 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     time = mdate() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    /* Only the overlapping area is blended */
+    const video_format_t *p_base = &p_sys->p_base_image->format;
+    const video_format_t *p_over = &p_sys->p_blend_image->format;
+    const double pixels =
+        (double)__MIN(p_base->i_visible_width, p_over->i_visible_width) *
+        __MIN(p_base->i_visible_height, p_over->i_visible_height);
+
+    if( time <= 0 )
+        time = 1;
+    msg_Info( p_filter, "%s: blended %d images in %f sec", psz_kernel,
+              p_sys->i_loops, time / 1000000.0f );
+    msg_Info( p_filter, "%s: speed is %f images/second, %.1f MPixel/s",
+              psz_kernel, (float) p_sys->i_loops / time * 1000000,
+              pixels * p_sys->i_loops / time );
 
     module_unneed( p_blend, p_blend->p_module );
 
     vlc_object_release( p_blend );
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    msg_Info( p_filter, "blending %4.4s onto %4.4s",
+              (const char *)&p_sys->i_blend_chroma,
+              (const char *)&p_sys->i_base_chroma );
+
+    char *psz_kernels = var_InheritString( p_filter, CFG_PREFIX "kernels" );
+    char *psz_saveptr;
+
+    for( char *psz_kernel = strtok_r( psz_kernels, ",", &psz_saveptr );
+         psz_kernel != NULL;
+         psz_kernel = strtok_r( NULL, ",", &psz_saveptr ) )
+        blendbench_Run( p_filter, psz_kernel );
+    free( psz_kernels );
 
     p_sys->b_done = true;
     return p_pic;
@@ -33,6 +33,7 @@
 #include <vlc_cpu.h>
 #include <vlc_picture.h>
 #include <vlc_filter.h>
+#include <vlc_slices.h>
 
 #include "deinterlace.h" /* filter_sys_t  */
 #include "common.h"      /* FFMIN3 et al. */
@@ -47,6 +48,150 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef void (*yadif_filter_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                               uint8_t *next, int w, int prefs, int mrefs,
+                               int parity, int mode);
+
+/* One field to interpolate */
+typedef struct
+{
+    yadif_filter_t filter;
+    picture_t *p_dst;
+    const picture_t *p_prev, *p_cur, *p_next;
+    int i_field;
+    int i_parity;
+    unsigned i_pixel_size;
+} yadif_frame_t;
+
+/*****************************************************************************
+ * Slice threads
+ *****************************************************************************/
+
+/* Each plane is cut in this many slices per thread, to balance the load */
+#define YADIF_SLICES_PER_THREAD 2
+
+/* Current field and slicing, for the slice threads */
+typedef struct
+{
+    const yadif_frame_t *p_frame;
+    unsigned i_slices; /**< Slices per plane */
+} yadif_slices_t;
+
+/* Interpolates lines [y0, y1) of a plane */
+static void RenderYadifLines( const yadif_frame_t *f, int n, int y0, int y1 )
+{
+    const plane_t *prevp = &f->p_prev->p[n];
+    const plane_t *curp  = &f->p_cur->p[n];
+    const plane_t *nextp = &f->p_next->p[n];
+    plane_t *dstp        = &f->p_dst->p[n];
+    /* Width in pixels, not bytes */
+    const int w = dstp->i_visible_pitch / f->i_pixel_size;
+
+    for( int y = y0; y < y1; y++ )
+    {
+        if( (y % 2) == f->i_field  ||  f->i_parity == 2 )
+        {
+            memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+        }
+        else
+        {
+            int mode;
+            /* Spatial checks only when enough data */
+            mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+            assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+            f->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                       &prevp->p_pixels[y * prevp->i_pitch],
+                       &curp->p_pixels[y * curp->i_pitch],
+                       &nextp->p_pixels[y * nextp->i_pitch],
+                       w,
+                       y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                       y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                       f->i_parity,
+                       mode );
+        }
+
+        /* We duplicate the first and last lines */
+        if( y == 1 )
+            memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+        else if( y == dstp->i_visible_lines - 2 )
+            memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+    }
+}
+
+static void RenderYadifSlice( void *opaque, unsigned i_slice, unsigned worker )
+{
+    const yadif_slices_t *p_slices = opaque;
+    const yadif_frame_t *f = p_slices->p_frame;
+    const unsigned i_slices = p_slices->i_slices;
+    const int n = i_slice / i_slices;
+    const int lines = f->p_dst->p[n].i_visible_lines - 2;
+
+    i_slice %= i_slices;
+    RenderYadifLines( f, n, 1 + lines * i_slice / i_slices,
+                      1 + lines * (i_slice + 1) / i_slices );
+    VLC_UNUSED(worker);
+}
+
+static vlc_slices_t *YadifThreadsNew( filter_t *p_filter )
+{
+    unsigned i_count = var_InheritInteger( p_filter, "video-filter-threads" );
+
+    if( i_count == 0 )
+        i_count = vlc_GetCPUCount();
+
+    vlc_slices_t *p_threads = vlc_slices_New( i_count,
+                                              VLC_THREAD_PRIORITY_VIDEO );
+    if( p_threads != NULL )
+        msg_Dbg( p_filter, "using %u threads",
+                 vlc_slices_GetThreads( p_threads ) );
+    return p_threads;
+}
+
+void CloseYadif( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_yadif_threads != NULL )
+        vlc_slices_Delete( p_sys->p_yadif_threads );
+    p_sys->p_yadif_threads = NULL;
+    p_sys->b_yadif_threads_init = false;
+}
+
+static void RenderYadifFrame( filter_t *p_filter, const yadif_frame_t *f )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    vlc_slices_t *p_threads;
+
+    if( !p_sys->b_yadif_threads_init )
+    {
+        p_sys->p_yadif_threads = YadifThreadsNew( p_filter );
+        p_sys->b_yadif_threads_init = true;
+    }
+
+    p_threads = p_sys->p_yadif_threads;
+    if( p_threads == NULL )
+    {
+        for( int n = 0; n < f->p_dst->i_planes; n++ )
+            RenderYadifLines( f, n, 1, f->p_dst->p[n].i_visible_lines - 1 );
+        return;
+    }
+
+    yadif_slices_t slices = {
+        .p_frame = f,
+        .i_slices = YADIF_SLICES_PER_THREAD
+                  * vlc_slices_GetThreads( p_threads ),
+    };
+
+    vlc_slices_Run( p_threads, slices.i_slices * f->p_dst->i_planes,
+                    RenderYadifSlice, &slices );
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -109,74 +254,51 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        yadif_frame_t frame = {
+            .p_dst = p_dst,
+            .p_prev = p_prev,
+            .p_cur = p_cur,
+            .p_next = p_next,
+            .i_field = i_field,
+            .i_parity = yadif_parity,
+            .i_pixel_size = p_sys->chroma->pixel_size,
+        };
 
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            frame.filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
-            filter = yadif_filter_line_ssse3;
+            frame.filter = yadif_filter_line_ssse3;
         else
 #endif
 #if defined(HAVE_YADIF_SSE2)
         if( vlc_CPU_SSE2() )
-            filter = yadif_filter_line_sse2;
+            frame.filter = yadif_filter_line_sse2;
         else
 #endif
 #if defined(HAVE_YADIF_MMX)
         if( vlc_CPU_MMX() )
-            filter = yadif_filter_line_mmx;
+            frame.filter = yadif_filter_line_mmx;
         else
 #endif
-            filter = yadif_filter_line_c;
+            frame.filter = yadif_filter_line_c;
 
         if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+#if defined(HAVE_YADIF_AVX2)
+            /* The AVX2 version computes in 16-bits signed integers */
+            if( vlc_CPU_AVX2() && p_sys->chroma->pixel_bits <= 12 )
+                frame.filter = yadif_filter_line_avx2_16bit;
+            else
+#endif
+                frame.filter = yadif_filter_line_c_16bit;
         }
 
+        RenderYadifFrame( p_filter, &frame );
+
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
         return VLC_SUCCESS;
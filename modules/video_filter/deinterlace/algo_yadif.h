@@ -91,4 +91,11 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
  */
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src );
 
+/**
+ * Releases the Yadif slice threads, if any.
+ *
+ * @param p_filter The filter instance. Must be non-NULL.
+ */
+void CloseYadif( filter_t *p_filter );
+
 #endif
@@ -35,6 +35,7 @@ struct vlc_object_t;
 
 #include <vlc_common.h>
 #include <vlc_mouse.h>
+#include <vlc_slices.h>
 
 /* Local algorithm headers */
 #include "algo_basic.h"
@@ -78,6 +79,10 @@ struct filter_sys_t
 
     struct deinterlace_ctx   context;
 
+    /** Yadif slice threads (created on first use) */
+    vlc_slices_t *p_yadif_threads;
+    bool b_yadif_threads_init;
+
     /* Algorithm-specific substructures */
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
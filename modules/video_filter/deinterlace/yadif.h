@@ -151,3 +151,173 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================ AVX2 =================
+/* Unlike the versions above, this one is written with intrinsics. It
+ * computes 16 pixels at once in 16-bits signed lanes, so it handles
+ * samples of up to 12 bits as well as 8 bits. */
+#include <immintrin.h>
+
+#define HAVE_YADIF_AVX2
+#define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
+
+VLC_AVX2
+static inline __m256i yadif_load_avx2(const uint8_t *p, int bytes)
+{
+    if (bytes == 1)
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+
+VLC_AVX2
+static inline void yadif_store_avx2(uint8_t *p, __m256i v, int bytes)
+{
+    if (bytes == 1) {
+        v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xd8);
+        _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(v));
+    } else
+        _mm256_storeu_si256((__m256i *)p, v);
+}
+
+VLC_AVX2
+static inline __m256i yadif_absdiff_avx2(__m256i a, __m256i b)
+{
+    return _mm256_abs_epi16(_mm256_sub_epi16(a, b));
+}
+
+VLC_AVX2
+static inline __m256i yadif_avg_avx2(__m256i a, __m256i b)
+{
+    return _mm256_srai_epi16(_mm256_add_epi16(a, b), 1);
+}
+
+/* Same as CHECK(j) above: keeps the edge direction j if it scores better */
+VLC_AVX2
+static inline __m256i yadif_check_avx2(const uint8_t *cur, int mrefs, int prefs,
+                                       int j, int bytes, __m256i mask,
+                                       __m256i *spatial_score,
+                                       __m256i *spatial_pred)
+{
+#define LOAD(off) yadif_load_avx2(cur + (off), bytes)
+    __m256i score = _mm256_add_epi16(_mm256_add_epi16(
+        yadif_absdiff_avx2(LOAD(mrefs + (j - 1) * bytes),
+                           LOAD(prefs - (j + 1) * bytes)),
+        yadif_absdiff_avx2(LOAD(mrefs + j * bytes),
+                           LOAD(prefs - j * bytes))),
+        yadif_absdiff_avx2(LOAD(mrefs + (j + 1) * bytes),
+                           LOAD(prefs - (j - 1) * bytes)));
+    __m256i pred = yadif_avg_avx2(LOAD(mrefs + j * bytes),
+                                  LOAD(prefs - j * bytes));
+#undef LOAD
+
+    mask = _mm256_and_si256(mask, _mm256_cmpgt_epi16(*spatial_score, score));
+    *spatial_score = _mm256_blendv_epi8(*spatial_score, score, mask);
+    *spatial_pred = _mm256_blendv_epi8(*spatial_pred, pred, mask);
+    return mask;
+}
+
+VLC_AVX2
+static inline void yadif_filter_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                     uint8_t *next, int w, int prefs,
+                                     int mrefs, int parity, int mode,
+                                     int bytes)
+{
+    uint8_t *prev2 = parity ? prev : cur ;
+    uint8_t *next2 = parity ? cur  : next;
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i all = _mm256_set1_epi16(-1);
+    int x;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        const int o = x * bytes;
+        __m256i c = yadif_load_avx2(cur + o + mrefs, bytes);
+        __m256i e = yadif_load_avx2(cur + o + prefs, bytes);
+        __m256i p2 = yadif_load_avx2(prev2 + o, bytes);
+        __m256i n2 = yadif_load_avx2(next2 + o, bytes);
+        __m256i d = yadif_avg_avx2(p2, n2);
+        __m256i temporal_diff0 = yadif_absdiff_avx2(p2, n2);
+        __m256i temporal_diff1 = _mm256_srai_epi16(_mm256_add_epi16(
+            yadif_absdiff_avx2(yadif_load_avx2(prev + o + mrefs, bytes), c),
+            yadif_absdiff_avx2(yadif_load_avx2(prev + o + prefs, bytes), e)), 1);
+        __m256i temporal_diff2 = _mm256_srai_epi16(_mm256_add_epi16(
+            yadif_absdiff_avx2(yadif_load_avx2(next + o + mrefs, bytes), c),
+            yadif_absdiff_avx2(yadif_load_avx2(next + o + prefs, bytes), e)), 1);
+        __m256i diff = _mm256_max_epi16(_mm256_max_epi16(
+            _mm256_srai_epi16(temporal_diff0, 1), temporal_diff1),
+            temporal_diff2);
+        __m256i spatial_pred = yadif_avg_avx2(c, e);
+        __m256i spatial_score = _mm256_sub_epi16(_mm256_add_epi16(
+            _mm256_add_epi16(
+                yadif_absdiff_avx2(yadif_load_avx2(cur + o + mrefs - bytes, bytes),
+                                   yadif_load_avx2(cur + o + prefs - bytes, bytes)),
+                yadif_absdiff_avx2(c, e)),
+            yadif_absdiff_avx2(yadif_load_avx2(cur + o + mrefs + bytes, bytes),
+                               yadif_load_avx2(cur + o + prefs + bytes, bytes))),
+            one);
+        __m256i mask;
+
+        /* Direction -2 is only tried if -1 was better, likewise for 2 */
+        mask = yadif_check_avx2(cur + o, mrefs, prefs, -1, bytes, all,
+                                &spatial_score, &spatial_pred);
+        yadif_check_avx2(cur + o, mrefs, prefs, -2, bytes, mask,
+                         &spatial_score, &spatial_pred);
+        mask = yadif_check_avx2(cur + o, mrefs, prefs, 1, bytes, all,
+                                &spatial_score, &spatial_pred);
+        yadif_check_avx2(cur + o, mrefs, prefs, 2, bytes, mask,
+                         &spatial_score, &spatial_pred);
+
+        if (mode < 2) {
+            __m256i b = yadif_avg_avx2(yadif_load_avx2(prev2 + o + 2 * mrefs, bytes),
+                                       yadif_load_avx2(next2 + o + 2 * mrefs, bytes));
+            __m256i f = yadif_avg_avx2(yadif_load_avx2(prev2 + o + 2 * prefs, bytes),
+                                       yadif_load_avx2(next2 + o + 2 * prefs, bytes));
+            __m256i de = _mm256_sub_epi16(d, e);
+            __m256i dc = _mm256_sub_epi16(d, c);
+            __m256i bc = _mm256_sub_epi16(b, c);
+            __m256i fe = _mm256_sub_epi16(f, e);
+            __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc),
+                                           _mm256_min_epi16(bc, fe));
+            __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc),
+                                           _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(),
+                                                     max));
+        }
+
+        spatial_pred = _mm256_max_epi16(
+            _mm256_min_epi16(spatial_pred, _mm256_add_epi16(d, diff)),
+            _mm256_sub_epi16(d, diff));
+        yadif_store_avx2(dst + o, spatial_pred, bytes);
+    }
+
+    if (x < w) {
+        const int o = x * bytes;
+
+        if (bytes == 1)
+            yadif_filter_line_c(dst + o, prev + o, cur + o, next + o, w - x,
+                                prefs, mrefs, parity, mode);
+        else
+            yadif_filter_line_c_16bit(dst + o, prev + o, cur + o, next + o,
+                                      w - x, prefs, mrefs, parity, mode);
+    }
+}
+
+VLC_AVX2
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                   uint8_t *next, int w, int prefs, int mrefs,
+                                   int parity, int mode)
+{
+    yadif_filter_avx2(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 1);
+}
+
+VLC_AVX2
+static void yadif_filter_line_avx2_16bit(uint8_t *dst, uint8_t *prev,
+                                         uint8_t *cur, uint8_t *next, int w,
+                                         int prefs, int mrefs, int parity,
+                                         int mode)
+{
+    yadif_filter_avx2(dst, prev, cur, next, w, prefs, mrefs, parity, mode, 2);
+}
+#endif
@@ -42,6 +42,8 @@ static int  Create      ( vlc_object_t * );
 static void Destroy     ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void FilterSlice( filter_t *, picture_t *, const picture_t *,
+                         unsigned, unsigned );
 
 /*****************************************************************************
  * Module descriptor
@@ -77,6 +79,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_EGENERIC;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_slice = FilterSlice;
     return VLC_SUCCESS;
 }
 
@@ -91,34 +94,27 @@ static void Destroy( vlc_object_t *p_this )
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************
- * This function send the currently rendered image to Invert image, waits
- * until it is displayed and switch the two rendering buffers, preparing next
- * frame.
+ * FilterSlice: inverts the lines of the planes matching luma lines [y0, y1)
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( filter_t *p_filter, picture_t *p_outpic,
+                         const picture_t *p_pic, unsigned y0, unsigned y1 )
 {
-    picture_t *p_outpic;
+    const unsigned i_luma_lines = p_pic->p[0].i_visible_lines;
     int i_planes;
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        msg_Warn( p_filter, "can't get output picture" );
-        picture_Release( p_pic );
-        return NULL;
-    }
+    VLC_UNUSED(p_filter);
 
     if( p_pic->format.i_chroma == VLC_CODEC_YUVA )
     {
         /* We don't want to invert the alpha plane */
+        const plane_t *p_src = &p_pic->p[A_PLANE];
+        plane_t *p_dst = &p_outpic->p[A_PLANE];
+
         i_planes = p_pic->i_planes - 1;
-        memcpy(
-            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
-            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
+        for( unsigned i = y0; i < y1; i++ )
+            memcpy( &p_dst->p_pixels[i * p_dst->i_pitch],
+                    &p_src->p_pixels[i * p_src->i_pitch],
+                    p_src->i_visible_pitch );
     }
     else
     {
@@ -127,24 +123,29 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     for( int i_index = 0 ; i_index < i_planes ; i_index++ )
     {
-        uint8_t *p_in, *p_in_end, *p_line_end, *p_out;
+        const plane_t *p_src = &p_pic->p[i_index];
+        const unsigned i_first = y0 * p_src->i_visible_lines / i_luma_lines;
+        const unsigned i_last = y1 * p_src->i_visible_lines / i_luma_lines;
+        const uint8_t *p_in, *p_in_end, *p_line_end;
+        uint8_t *p_out;
 
-        p_in = p_pic->p[i_index].p_pixels;
-        p_in_end = p_in + p_pic->p[i_index].i_visible_lines
-                           * p_pic->p[i_index].i_pitch;
+        p_in = p_src->p_pixels + i_first * p_src->i_pitch;
+        p_in_end = p_src->p_pixels + i_last * p_src->i_pitch;
 
-        p_out = p_outpic->p[i_index].p_pixels;
+        p_out = p_outpic->p[i_index].p_pixels
+              + i_first * p_outpic->p[i_index].i_pitch;
 
         while( p_in < p_in_end )
         {
-            uint64_t *p_in64, *p_out64;
+            const uint64_t *p_in64;
+            uint64_t *p_out64;
 
-            p_line_end = p_in + p_pic->p[i_index].i_visible_pitch - 64;
+            p_line_end = p_in + p_src->i_visible_pitch - 64;
 
-            p_in64 = (uint64_t*)p_in;
+            p_in64 = (const uint64_t*)p_in;
             p_out64 = (uint64_t*)p_out;
 
-            while( p_in64 < (uint64_t *)p_line_end )
+            while( p_in64 < (const uint64_t *)p_line_end )
             {
                 /* Do 64 pixels at a time */
                 *p_out64++ = ~*p_in64++; *p_out64++ = ~*p_in64++;
@@ -153,7 +154,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                 *p_out64++ = ~*p_in64++; *p_out64++ = ~*p_in64++;
             }
 
-            p_in = (uint8_t*)p_in64;
+            p_in = (const uint8_t*)p_in64;
             p_out = (uint8_t*)p_out64;
             p_line_end += 64;
 
@@ -162,12 +163,31 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                 *p_out++ = ~( *p_in++ );
             }
 
-            p_in += p_pic->p[i_index].i_pitch
-                     - p_pic->p[i_index].i_visible_pitch;
+            p_in += p_src->i_pitch - p_src->i_visible_pitch;
             p_out += p_outpic->p[i_index].i_pitch
                      - p_outpic->p[i_index].i_visible_pitch;
         }
     }
+}
+
+/*****************************************************************************
+ * Filter: inverts a whole picture
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    FilterSlice( p_filter, p_outpic, p_pic, 0, p_pic->p[0].i_visible_lines );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
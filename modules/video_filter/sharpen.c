@@ -55,6 +55,8 @@ static int  Create    ( vlc_object_t * );
 static void Destroy   ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void FilterSlice( filter_t *, picture_t *, const picture_t *,
+                         unsigned, unsigned );
 static int SharpenCallback( vlc_object_t *, char const *,
                             vlc_value_t, vlc_value_t, void * );
 
@@ -119,6 +121,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_slice = FilterSlice;
 
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                    p_filter->p_cfg );
@@ -170,9 +173,10 @@ static void Destroy( vlc_object_t *p_this )
         const int i_out_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int sigma = atomic_load(&p_filter->p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if (y0 == 0)                                                    \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = __MAX(y0, 1); i < __MIN(y1, i_visible_lines - 1); i++ ) \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -199,19 +203,50 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
+        if (y1 >= i_visible_lines)                                      \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+/* Copies the lines of a chroma plane matching luma lines [y0, y1) */
+static void CopyPlaneSlice( plane_t *p_dst, const plane_t *p_src,
+                            unsigned y0, unsigned y1, unsigned i_luma_lines )
+{
+    const unsigned i_lines = __MIN(p_dst->i_visible_lines,
+                                   p_src->i_visible_lines);
+    const unsigned i_width = __MIN(p_dst->i_visible_pitch,
+                                   p_src->i_visible_pitch);
+
+    for( unsigned i = y0 * i_lines / i_luma_lines;
+         i < y1 * i_lines / i_luma_lines && i < i_lines; i++ )
+        memcpy( &p_dst->p_pixels[i * p_dst->i_pitch],
+                &p_src->p_pixels[i * p_src->i_pitch], i_width );
+}
+
+static void FilterSlice( filter_t *p_filter, picture_t *p_outpic,
+                         const picture_t *p_pic, unsigned y0, unsigned y1 )
 {
-    picture_t *p_outpic;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
 
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_FRAME(255, uint8_t);
+    else
+        SHARPEN_FRAME(1023, uint16_t);
+
+    CopyPlaneSlice( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE], y0, y1,
+                    i_visible_lines );
+    CopyPlaneSlice( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE], y0, y1,
+                    i_visible_lines );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -219,13 +254,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
-
-    plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
-    plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
+    FilterSlice( p_filter, p_outpic, p_pic, 0,
+                 p_pic->p[Y_PLANE].i_visible_lines );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -111,6 +111,7 @@ error:
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    atomic_init (&owner->buffers_allocated, 0);
     atomic_store (&owner->vp.update, true);
     return 0;
 }
@@ -392,6 +393,8 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
     }
 
     block = aout_FiltersPlay (owner->filters, block, input_rate);
+    atomic_fetch_add(&owner->buffers_allocated,
+                     aout_FiltersGetResetAllocations (owner->filters));
     if (block == NULL)
         goto lost;
 
@@ -418,12 +421,14 @@ lost:
 }
 
 void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+                           unsigned *restrict played,
+                           unsigned *restrict allocated)
 {
     aout_owner_t *owner = aout_owner (aout);
 
     *lost = atomic_exchange(&owner->buffers_lost, 0);
     *played = atomic_exchange(&owner->buffers_played, 0);
+    *allocated = atomic_exchange(&owner->buffers_allocated, 0);
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, mtime_t date)
@@ -42,8 +42,193 @@
 #include <libvlc.h>
 #include "aout_internal.h"
 
+#define AOUT_MAX_FILTERS 10
+
+/**
+ * Scratch buffers of a pipeline.
+ *
+ * The filters get their output blocks with filter_NewAudioBuffer(). The
+ * blocks go back to the free list of the pipeline when released, whichever
+ * thread releases them, and the next buffers reuse them: once warm, a whole
+ * chain of filters runs without allocations. The free list outlives the
+ * pipeline until its last block is released.
+ */
+typedef struct aout_buffers aout_buffers_t;
+
+typedef struct
+{
+    block_t         self;
+    aout_buffers_t *owner;
+    size_t          capacity; /**< Payload size */
+} aout_buffer_t;
+
+struct aout_buffers
+{
+    vlc_mutex_t lock;
+    block_t    *free; /**< Released blocks, most recently used first */
+    unsigned    refs; /**< One for the pipeline, and one per block */
+    bool        deleted; /**< The pipeline is gone */
+};
+
+/** Payload alignment and padding, as with block_Alloc() */
+#define AOUT_BUFFER_ALIGN   32
+#define AOUT_BUFFER_PADDING 32
+/** Smallest payload, the sizes are rounded up to powers of 2 */
+#define AOUT_BUFFER_MIN     4096
+
+struct aout_filters
+{
+    filter_t *rate_filter; /**< The filter adjusting samples count
+        (either the scaletempo filter or a resampler) */
+    filter_t *resampler; /**< The resampler */
+    int resampling; /**< Current resampling (Hz) */
+
+    const aout_request_vout_t *request_vout; /**< Visualization requests */
+    aout_buffers_t *buffers; /**< Output blocks of the filters */
+    atomic_uint allocations; /**< Output blocks allocated since last read */
+
+    unsigned count; /**< Number of filters */
+    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
+        (e.g. equalization) and their conversions */
+};
+
+static aout_buffers_t *aout_BuffersNew (void)
+{
+    aout_buffers_t *buffers = malloc (sizeof (*buffers));
+    if (unlikely(buffers == NULL))
+        return NULL;
+
+    vlc_mutex_init (&buffers->lock);
+    buffers->free = NULL;
+    buffers->refs = 1;
+    buffers->deleted = false;
+    return buffers;
+}
+
+static void aout_BuffersDestroy (aout_buffers_t *buffers)
+{
+    vlc_mutex_destroy (&buffers->lock);
+    free (buffers);
+}
+
+/**
+ * Frees the released blocks, and the free list itself once the blocks still
+ * in use are released.
+ */
+static void aout_BuffersDelete (aout_buffers_t *buffers)
+{
+    vlc_mutex_lock (&buffers->lock);
+    block_t *block = buffers->free;
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        free (container_of(block, aout_buffer_t, self));
+        buffers->refs--;
+        block = next;
+    }
+    buffers->free = NULL;
+    buffers->deleted = true;
+    bool last = --buffers->refs == 0;
+    vlc_mutex_unlock (&buffers->lock);
+
+    if (last)
+        aout_BuffersDestroy (buffers);
+}
+
+static void aout_BufferRelease (block_t *block)
+{
+    aout_buffer_t *buf = container_of(block, aout_buffer_t, self);
+    aout_buffers_t *buffers = buf->owner;
+    bool recycled = false, last = false;
+
+    vlc_mutex_lock (&buffers->lock);
+    if (!buffers->deleted)
+    {
+        block->p_next = buffers->free;
+        buffers->free = block;
+        recycled = true;
+    }
+    else
+        last = --buffers->refs == 0;
+    vlc_mutex_unlock (&buffers->lock);
+
+    if (recycled)
+        return;
+    free (buf);
+    if (last)
+        aout_BuffersDestroy (buffers);
+}
+
+/**
+ * Gets an output block for a filter (filter_NewAudioBuffer() callback).
+ */
+static block_t *aout_FiltersBufferNew (filter_t *filter, size_t size)
+{
+    aout_filters_t *filters = filter->owner.sys;
+    aout_buffers_t *buffers = filters->buffers;
+    aout_buffer_t *buf = NULL, *stale = NULL;
+
+    vlc_mutex_lock (&buffers->lock);
+    for (block_t **pp = &buffers->free; *pp != NULL; pp = &(*pp)->p_next)
+    {
+        aout_buffer_t *b = container_of(*pp, aout_buffer_t, self);
+
+        if (b->capacity >= size)
+        {
+            *pp = b->self.p_next;
+            buf = b;
+            break;
+        }
+    }
+    if (buf == NULL)
+    {
+        if (buffers->free != NULL)
+        {   /* Replace a block too small, rather than keep it forever */
+            stale = container_of(buffers->free, aout_buffer_t, self);
+            buffers->free = stale->self.p_next;
+        }
+        else
+            buffers->refs++;
+    }
+    vlc_mutex_unlock (&buffers->lock);
+
+    if (buf == NULL)
+    {
+        size_t capacity = AOUT_BUFFER_MIN;
+
+        free (stale);
+        while (capacity < size && capacity <= SIZE_MAX / 4)
+            capacity *= 2;
+        if (capacity >= size)
+            buf = malloc (sizeof (*buf) + AOUT_BUFFER_ALIGN
+                          + (2 * AOUT_BUFFER_PADDING) + capacity);
+        if (unlikely(buf == NULL))
+        {
+            vlc_mutex_lock (&buffers->lock);
+            buffers->refs--; /* never the last reference: filters is alive */
+            vlc_mutex_unlock (&buffers->lock);
+            return NULL;
+        }
+        buf->owner = buffers;
+        buf->capacity = capacity;
+        atomic_fetch_add_explicit (&filters->allocations, 1,
+                                   memory_order_relaxed);
+    }
+
+    block_t *block = &buf->self;
+    block_Init (block, buf + 1, AOUT_BUFFER_ALIGN + (2 * AOUT_BUFFER_PADDING)
+                                + buf->capacity);
+    block->p_buffer += AOUT_BUFFER_PADDING + AOUT_BUFFER_ALIGN - 1;
+    block->p_buffer = (void *)(((uintptr_t)block->p_buffer)
+                               & ~(AOUT_BUFFER_ALIGN - 1));
+    block->i_buffer = size;
+    block->pf_release = aout_BufferRelease;
+    return block;
+}
+
 static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
-                               const char *name, filter_owner_sys_t *owner,
+                               const char *name, aout_filters_t *owner,
                                const audio_sample_format_t *infmt,
                                const audio_sample_format_t *outfmt,
                                config_chain_t *cfg, bool const_fmt)
@@ -53,6 +238,8 @@ static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
         return NULL;
 
     filter->owner.sys = owner;
+    filter->owner.audio.buffer_new = aout_FiltersBufferNew;
+    filter->b_in_place = false;
     filter->p_cfg = cfg;
     filter->fmt_in.audio = *infmt;
     filter->fmt_in.i_codec = infmt->i_format;
@@ -89,20 +276,20 @@ static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
     return filter;
 }
 
-static filter_t *FindConverter (vlc_object_t *obj,
+static filter_t *FindConverter (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter (obj, "audio converter", NULL, NULL, infmt, outfmt,
+    return CreateFilter (obj, "audio converter", NULL, owner, infmt, outfmt,
                          NULL, true);
 }
 
-static filter_t *FindResampler (vlc_object_t *obj,
+static filter_t *FindResampler (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
     char *modlist = var_InheritString(obj, "audio-resampler");
-    filter_t *filter = CreateFilter (obj, "audio resampler", modlist, NULL,
+    filter_t *filter = CreateFilter (obj, "audio resampler", modlist, owner,
                                      infmt, outfmt, NULL, true);
     free(modlist);
     return filter;
@@ -122,7 +309,8 @@ static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, aout_filters_t *owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -131,7 +319,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -140,6 +328,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param owner pipeline owning the new filters
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -147,7 +336,8 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj, aout_filters_t *owner,
+                                      filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt,
@@ -179,7 +369,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -208,7 +398,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         config_chain_t *cfg = NULL;
         if (headphones)
             config_ChainParseOptions(&cfg, "{headphones=true}");
-        filter_t *f = CreateFilter (obj, filter_type, NULL, NULL,
+        filter_t *f = CreateFilter (obj, filter_type, NULL, owner,
                                     &input, &output, cfg, true);
         if (cfg)
             config_ChainDestroy(cfg);
@@ -233,7 +423,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -251,7 +441,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -284,10 +474,22 @@ static block_t *aout_FiltersPipelinePlay(filter_t *const *filters,
     for (unsigned i = 0; (i < count) && (block != NULL); i++)
     {
         filter_t *filter = filters[i];
+        block_t *in = block;
 
         /* Please note that p_block->i_nb_samples & i_buffer
          * shall be set by the filter plug-in. */
         block = filter->pf_audio_filter (filter, block);
+
+        if (filter->b_in_place)
+            assert (block == in || block == NULL);
+        else if (block != NULL && block != in
+              && block->pf_release != aout_BufferRelease)
+        {   /* Output block not taken from the pipeline buffers */
+            aout_filters_t *owner = filter->owner.sys;
+
+            atomic_fetch_add_explicit (&owner->allocations, 1,
+                                       memory_order_relaxed);
+        }
     }
     return block;
 }
@@ -342,20 +544,6 @@ static void aout_FiltersPipelineChangeViewpoint(filter_t *const *filters,
         filter_ChangeViewpoint (filters[i], vp);
 }
 
-#define AOUT_MAX_FILTERS 10
-
-struct aout_filters
-{
-    filter_t *rate_filter; /**< The filter adjusting samples count
-        (either the scaletempo filter or a resampler) */
-    filter_t *resampler; /**< The resampler */
-    int resampling; /**< Current resampling (Hz) */
-
-    unsigned count; /**< Number of filters */
-    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
-        (e.g. equalization) and their conversions */
-};
-
 /** Callback for visualization selection */
 static int VisualizationCallback (vlc_object_t *obj, const char *var,
                                   vlc_value_t oldval, vlc_value_t newval,
@@ -390,7 +578,8 @@ vout_thread_t *aout_filter_RequestVout (filter_t *filter, vout_thread_t *vout,
      * If you want to use visualization filters from another place, you will
      * need to add a new pf_aout_request_vout callback or store a pointer
      * to aout_request_vout_t inside filter_t (i.e. a level of indirection). */
-    const aout_request_vout_t *req = filter->owner.sys;
+    const aout_filters_t *filters = filter->owner.sys;
+    const aout_request_vout_t *req = filters->request_vout;
     char *visual = var_InheritString (filter->obj.parent, "audio-visual");
     /* NOTE: Disable recycling to always close the filter vout because OpenGL
      * visualizations do not use this function to ask for a context. */
@@ -401,7 +590,7 @@ vout_thread_t *aout_filter_RequestVout (filter_t *filter, vout_thread_t *vout,
 }
 
 static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
-                        aout_filters_t *restrict filters, const void *owner,
+                        aout_filters_t *restrict filters,
                         audio_sample_format_t *restrict infmt,
                         const audio_sample_format_t *restrict outfmt,
                         config_chain_t *cfg)
@@ -414,7 +603,7 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     filter_t *filter = CreateFilter (obj, type, name,
-                                     (void *)owner, infmt, outfmt, cfg, false);
+                                     filters, infmt, outfmt, cfg, false);
     if (filter == NULL)
     {
         msg_Err (obj, "cannot add user %s \"%s\" (skipped)", type, name);
@@ -422,8 +611,8 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio, false))
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab,
+                                    &filters->count, max - 1, infmt, &filter->fmt_in.audio, false))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         module_unneed (filter, filter->p_module);
@@ -473,7 +662,7 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
     free(config_ChainCreate(&name, &cfg, str));
     if (name != NULL && cfg != NULL)
         ret = AppendFilter(obj, "audio filter", name, filters,
-                           NULL, infmt, outfmt, cfg);
+                           infmt, outfmt, cfg);
     else
         ret = -1;
 
@@ -510,9 +699,18 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (unlikely(filters == NULL))
         return NULL;
 
+    filters->buffers = aout_BuffersNew ();
+    if (unlikely(filters->buffers == NULL))
+    {
+        free (filters);
+        return NULL;
+    }
+
     filters->rate_filter = NULL;
     filters->resampler = NULL;
     filters->resampling = 0;
+    filters->request_vout = request_vout;
+    atomic_init (&filters->allocations, 0);
     filters->count = 0;
 
     /* Prepare format structure */
@@ -529,7 +727,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, filters, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -553,8 +751,9 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
 
         /* convert to the output format (minus resampling) if necessary */
         output_format.i_rate = input_format.i_rate;
-        if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                  AOUT_MAX_FILTERS, &input_format, &output_format,
+        if (aout_FiltersPipelineCreate (obj, filters, filters->tab,
+                                  &filters->count, AOUT_MAX_FILTERS,
+                                  &input_format, &output_format,
                                   cfg->headphones))
         {
             msg_Warn (obj, "cannot setup audio renderer pipeline");
@@ -577,7 +776,8 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, filters, &input_format,
+                                     &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -594,7 +794,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (var_InheritBool (obj, "audio-time-stretch"))
     {
         if (AppendFilter(obj, "audio filter", "scaletempo",
-                         filters, NULL, &input_format, &output_format, NULL) == 0)
+                         filters, &input_format, &output_format, NULL) == 0)
             filters->rate_filter = filters->tab[filters->count - 1];
     }
 
@@ -604,7 +804,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
                           cfg->remap);
 
         if (input_format.i_channels > 2 && cfg->headphones)
-            AppendFilter(obj, "audio filter", "binauralizer", filters, NULL,
+            AppendFilter(obj, "audio filter", "binauralizer", filters,
                     &input_format, &output_format, NULL);
     }
 
@@ -616,7 +816,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         while ((name = strsep (&p, " :")) != NULL)
         {
             AppendFilter(obj, "audio filter", name, filters,
-                         NULL, &input_format, &output_format, NULL);
+                         &input_format, &output_format, NULL);
         }
         free (str);
     }
@@ -626,14 +826,15 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         char *visual = var_InheritString (obj, "audio-visual");
         if (visual != NULL && strcasecmp (visual, "none"))
             AppendFilter(obj, "visualization", visual, filters,
-                         request_vout, &input_format, &output_format, NULL);
+                         &input_format, &output_format, NULL);
         free (visual);
     }
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                              AOUT_MAX_FILTERS, &input_format, &output_format, false))
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab,
+                              &filters->count, AOUT_MAX_FILTERS,
+                              &input_format, &output_format, false))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
         goto error;
@@ -643,7 +844,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler = FindResampler (obj, &input_format,
+    filters->resampler = FindResampler (obj, filters, &input_format,
                                         &output_format);
     if (filters->resampler == NULL && input_format.i_rate != outfmt->i_rate)
     {
@@ -653,12 +854,18 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (filters->rate_filter == NULL)
         filters->rate_filter = filters->resampler;
 
+    unsigned in_place = 0;
+    for (unsigned i = 0; i < filters->count; i++)
+        if (filters->tab[i]->b_in_place)
+            in_place++;
+    msg_Dbg (obj, "%u filter(s), %u in place", filters->count, in_place);
     return filters;
 
 error:
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (request_vout != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    aout_BuffersDelete (filters->buffers);
     free (filters);
     return NULL;
 }
@@ -679,9 +886,21 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (obj != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    aout_BuffersDelete (filters->buffers);
     free (filters);
 }
 
+/**
+ * Returns the number of output blocks allocated by the filters since the
+ * last call, rather than recycled from the previous buffers or processed in
+ * place. The count drops to zero once the pipeline is warm.
+ */
+unsigned aout_FiltersGetResetAllocations (aout_filters_t *filters)
+{
+    return atomic_exchange_explicit (&filters->allocations, 0,
+                                     memory_order_relaxed);
+}
+
 bool aout_FiltersCanResample (aout_filters_t *filters)
 {
     return (filters->resampler != NULL);
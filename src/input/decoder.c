@@ -1086,6 +1086,10 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
 {
     input_thread_t *p_input = p_owner->p_input;
     unsigned displayed = 0;
+    unsigned copied = 0;
+    unsigned spu_hits = 0, spu_misses = 0;
+    unsigned latency[INPUT_STATS_VOUT_STAGES][INPUT_STATS_LATENCY_BUCKETS] =
+        { { 0 } };
 
     /* Update ugly stat */
     if( p_input == NULL )
@@ -1095,7 +1099,8 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
     {
         unsigned vout_lost = 0;
 
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                &copied, &spu_hits, &spu_misses, latency );
         lost += vout_lost;
     }
 
@@ -1109,6 +1114,20 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
                                   memory_order_relaxed);
         atomic_fetch_add_explicit(&stats->displayed_pictures, displayed,
                                   memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->spu_cache_hits, spu_hits,
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->spu_cache_misses, spu_misses,
+                                  memory_order_relaxed);
+        for (unsigned i = 0; i < INPUT_STATS_VOUT_STAGES; i++)
+            for (unsigned j = 0; j < INPUT_STATS_LATENCY_BUCKETS; j++)
+                if (latency[i][j] != 0)
+                    atomic_fetch_add_explicit(&stats->vout_latency[i][j],
+                                              latency[i][j],
+                                              memory_order_relaxed);
+
+        vlc_mutex_lock(&stats->copied_pictures.lock);
+        input_rate_Add(&stats->copied_pictures, copied);
+        vlc_mutex_unlock(&stats->copied_pictures.lock);
     }
 }
 
@@ -1211,7 +1230,7 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
                                     unsigned decoded, unsigned lost )
 {
     input_thread_t *p_input = p_owner->p_input;
-    unsigned played = 0;
+    unsigned played = 0, allocated = 0;
 
     /* Update ugly stat */
     if( p_input == NULL )
@@ -1221,7 +1240,8 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
     {
         unsigned aout_lost;
 
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played,
+                               &allocated );
         lost += aout_lost;
     }
 
@@ -1233,6 +1253,8 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
                                   memory_order_relaxed);
         atomic_fetch_add_explicit(&stats->played_abuffers, played,
                                   memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->allocated_abuffers, allocated,
+                                  memory_order_relaxed);
         atomic_fetch_add_explicit(&stats->decoded_audio, decoded,
                                   memory_order_relaxed);
     }
@@ -276,6 +276,10 @@ typedef struct input_rate_t
 
 struct input_stats {
     input_rate_t input_bitrate;
+    atomic_uintmax_t stream_cache_hits;
+    atomic_uintmax_t stream_cache_misses;
+    atomic_uintmax_t recv_calls;
+    atomic_uintmax_t recv_datagrams;
     input_rate_t demux_bitrate;
     atomic_uintmax_t demux_corrupted;
     atomic_uintmax_t demux_discontinuity;
@@ -283,8 +287,14 @@ struct input_stats {
     atomic_uintmax_t decoded_video;
     atomic_uintmax_t played_abuffers;
     atomic_uintmax_t lost_abuffers;
+    atomic_uintmax_t allocated_abuffers;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
+    input_rate_t copied_pictures;
+    atomic_uintmax_t spu_cache_hits;
+    atomic_uintmax_t spu_cache_misses;
+    atomic_uintmax_t vout_latency[INPUT_STATS_VOUT_STAGES]
+                                 [INPUT_STATS_LATENCY_BUCKETS];
 };
 
 struct input_stats *input_stats_Create(void);
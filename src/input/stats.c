@@ -59,6 +59,10 @@ struct input_stats *input_stats_Create(void)
         return NULL;
 
     input_rate_Init(&stats->input_bitrate);
+    atomic_init(&stats->stream_cache_hits, 0);
+    atomic_init(&stats->stream_cache_misses, 0);
+    atomic_init(&stats->recv_calls, 0);
+    atomic_init(&stats->recv_datagrams, 0);
     input_rate_Init(&stats->demux_bitrate);
     atomic_init(&stats->demux_corrupted, 0);
     atomic_init(&stats->demux_discontinuity, 0);
@@ -66,13 +70,21 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->decoded_video, 0);
     atomic_init(&stats->played_abuffers, 0);
     atomic_init(&stats->lost_abuffers, 0);
+    atomic_init(&stats->allocated_abuffers, 0);
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    input_rate_Init(&stats->copied_pictures);
+    atomic_init(&stats->spu_cache_hits, 0);
+    atomic_init(&stats->spu_cache_misses, 0);
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_STAGES; i++)
+        for (unsigned j = 0; j < INPUT_STATS_LATENCY_BUCKETS; j++)
+            atomic_init(&stats->vout_latency[i][j], 0);
     return stats;
 }
 
 void input_stats_Destroy(struct input_stats *stats)
 {
+    vlc_mutex_destroy(&stats->copied_pictures.lock);
     vlc_mutex_destroy(&stats->demux_bitrate.lock);
     vlc_mutex_destroy(&stats->input_bitrate.lock);
     free(stats);
@@ -86,6 +98,14 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
     st->i_read_bytes = stats->input_bitrate.value;
     st->f_input_bitrate = stats_GetRate(&stats->input_bitrate);
     vlc_mutex_unlock(&stats->input_bitrate.lock);
+    st->i_stream_cache_hits = atomic_load_explicit(&stats->stream_cache_hits,
+                                                   memory_order_relaxed);
+    st->i_stream_cache_misses = atomic_load_explicit(
+                    &stats->stream_cache_misses, memory_order_relaxed);
+    st->i_recv_calls = atomic_load_explicit(&stats->recv_calls,
+                                            memory_order_relaxed);
+    st->i_recv_datagrams = atomic_load_explicit(&stats->recv_datagrams,
+                                                memory_order_relaxed);
 
     vlc_mutex_lock(&stats->demux_bitrate.lock);
     st->i_demux_read_bytes = stats->demux_bitrate.value;
@@ -103,6 +123,8 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                  memory_order_relaxed);
     st->i_lost_abuffers = atomic_load_explicit(&stats->lost_abuffers,
                                                memory_order_relaxed);
+    st->i_allocated_abuffers = atomic_load_explicit(
+                    &stats->allocated_abuffers, memory_order_relaxed);
 
     /* Vouts */
     st->i_decoded_video = atomic_load_explicit(&stats->decoded_video,
@@ -111,6 +133,21 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    vlc_mutex_lock(&stats->copied_pictures.lock);
+    st->i_copied_pictures = stats->copied_pictures.value;
+    st->f_copy_rate = stats_GetRate(&stats->copied_pictures) * CLOCK_FREQ;
+    vlc_mutex_unlock(&stats->copied_pictures.lock);
+
+    st->i_spu_cache_hits = atomic_load_explicit(&stats->spu_cache_hits,
+                                                memory_order_relaxed);
+    st->i_spu_cache_misses = atomic_load_explicit(&stats->spu_cache_misses,
+                                                  memory_order_relaxed);
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_STAGES; i++)
+        for (unsigned j = 0; j < INPUT_STATS_LATENCY_BUCKETS; j++)
+            st->i_vout_latency[i][j] =
+                atomic_load_explicit(&stats->vout_latency[i][j],
+                                     memory_order_relaxed);
 }
 
 /** Update a counter element with new values
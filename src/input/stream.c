@@ -42,6 +42,7 @@
 
 #include <libvlc.h>
 #include "stream.h"
+#include "input_internal.h"
 #include "mrl_helpers.h"
 
 typedef struct stream_priv_t
@@ -738,3 +739,34 @@ int vlc_stream_ReadDir( stream_t *s, input_item_node_t *p_node )
     assert(s->pf_readdir != NULL);
     return s->pf_readdir( s, p_node );
 }
+
+void vlc_stream_AddStats( stream_t *s, enum vlc_stream_stat stat,
+                          uintmax_t value )
+{
+    if( s->p_input == NULL )
+        return;
+
+    struct input_stats *stats = input_priv(s->p_input)->stats;
+    if( stats == NULL )
+        return;
+
+    atomic_uintmax_t *counter;
+    switch( stat )
+    {
+        case VLC_STREAM_STAT_CACHE_HITS:
+            counter = &stats->stream_cache_hits;
+            break;
+        case VLC_STREAM_STAT_CACHE_MISSES:
+            counter = &stats->stream_cache_misses;
+            break;
+        case VLC_STREAM_STAT_RECV_CALLS:
+            counter = &stats->recv_calls;
+            break;
+        case VLC_STREAM_STAT_RECV_DATAGRAMS:
+            counter = &stats->recv_datagrams;
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+    atomic_fetch_add_explicit( counter, value, memory_order_relaxed );
+}
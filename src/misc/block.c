@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -117,6 +118,309 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/**
+ * \defgroup block_cache Thread-local block cache
+ *
+ * Small blocks are recycled through per-thread free lists, one list per
+ * power-of-two size class. A block released by its allocating thread goes
+ * straight back onto that thread's free list. A block released by any other
+ * thread is pushed onto a lock-free return stack of the owning cache, which
+ * the owner drains when it runs out of free blocks.
+ *
+ * Caches are never freed: when a thread exits, its free blocks are released
+ * and its cache is put aside for adoption by the next new thread. This way,
+ * blocks still in flight always point to a valid cache.
+ * @{
+ */
+
+/** Smallest size class (256 bytes) */
+#define BLOCK_CACHE_MIN_SHIFT 8
+/** Number of size classes (256 bytes to 32 KiB) */
+#define BLOCK_CACHE_CLASSES   8
+/** Largest cached payload size */
+#define BLOCK_CACHE_MAX       ((size_t)1 << (BLOCK_CACHE_MIN_SHIFT + BLOCK_CACHE_CLASSES - 1))
+/** Maximum cached bytes per thread and per size class */
+#define BLOCK_CACHE_BYTES     (256 << 10)
+/** Maximum cached blocks per thread and per size class */
+#define BLOCK_CACHE_DEPTH     256
+
+typedef struct block_cache block_cache_t;
+
+typedef struct
+{
+    block_t        self;
+    block_cache_t *cache; /**< owning cache */
+    unsigned       klass; /**< size class */
+} block_cached_t;
+
+struct block_cache
+{
+    block_cache_t *next; /**< next cache (all caches) */
+    block_cache_t *next_orphan; /**< next cache without owner thread */
+
+    /* Owner thread only */
+    block_t  *free[BLOCK_CACHE_CLASSES];
+    unsigned  count[BLOCK_CACHE_CLASSES];
+
+    /* Blocks released by other threads */
+    _Atomic(block_t *) remote;
+
+    atomic_ulong hits;
+    atomic_ulong misses;
+    atomic_ulong remote_frees;
+};
+
+static vlc_once_t block_cache_once = VLC_STATIC_ONCE;
+static vlc_threadvar_t block_cache_key;
+static bool block_cache_usable = false;
+
+static vlc_mutex_t block_cache_lock = VLC_STATIC_MUTEX;
+static block_cache_t *block_caches = NULL;
+static block_cache_t *block_cache_orphans = NULL;
+
+static size_t block_cache_ClassSize(unsigned klass)
+{
+    return (size_t)1 << (BLOCK_CACHE_MIN_SHIFT + klass);
+}
+
+static unsigned block_cache_ClassDepth(unsigned klass)
+{
+    size_t depth = BLOCK_CACHE_BYTES / block_cache_ClassSize(klass);
+    return (depth < BLOCK_CACHE_DEPTH) ? depth : BLOCK_CACHE_DEPTH;
+}
+
+static unsigned block_cache_Class(size_t size)
+{
+    assert(size <= BLOCK_CACHE_MAX);
+
+    if (size <= block_cache_ClassSize(0))
+        return 0;
+    return (sizeof (unsigned long) * 8) - clz((unsigned long)(size - 1))
+           - BLOCK_CACHE_MIN_SHIFT;
+}
+
+static void block_cache_Count(atomic_ulong *counter)
+{
+    /* Only the owner thread updates the counter: no need for RMW. */
+    atomic_store_explicit(counter,
+        atomic_load_explicit(counter, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+}
+
+static void block_cache_Put(block_cache_t *cache, block_t *block)
+{
+    block_cached_t *cb = container_of(block, block_cached_t, self);
+    unsigned klass = cb->klass;
+
+    if (cache->count[klass] >= block_cache_ClassDepth(klass))
+    {
+        free(cb);
+        return;
+    }
+
+    block->p_next = cache->free[klass];
+    cache->free[klass] = block;
+    cache->count[klass]++;
+}
+
+/** Moves blocks released by other threads back to the free lists. */
+static void block_cache_Drain(block_cache_t *cache)
+{
+    block_t *block = atomic_exchange_explicit(&cache->remote, NULL,
+                                              memory_order_acquire);
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block_cache_Put(cache, block);
+        block = next;
+    }
+}
+
+/** Releases all cached blocks and gives up ownership of the cache. */
+static void block_cache_Detach(void *data)
+{
+    block_cache_t *cache = data;
+
+    for (unsigned i = 0; i < BLOCK_CACHE_CLASSES; i++)
+    {
+        block_t *block = cache->free[i];
+
+        while (block != NULL)
+        {
+            block_t *next = block->p_next;
+
+            free(container_of(block, block_cached_t, self));
+            block = next;
+        }
+        cache->free[i] = NULL;
+        cache->count[i] = 0;
+    }
+
+    block_t *block = atomic_exchange_explicit(&cache->remote, NULL,
+                                              memory_order_acquire);
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        free(container_of(block, block_cached_t, self));
+        block = next;
+    }
+
+    vlc_mutex_lock(&block_cache_lock);
+    cache->next_orphan = block_cache_orphans;
+    block_cache_orphans = cache;
+    vlc_mutex_unlock(&block_cache_lock);
+}
+
+static void block_cache_Setup(void)
+{
+    block_cache_usable = !vlc_threadvar_create(&block_cache_key,
+                                               block_cache_Detach);
+}
+
+/** Gets the cache of the calling thread, creating or adopting one. */
+static block_cache_t *block_cache_Get(void)
+{
+    vlc_once(&block_cache_once, block_cache_Setup);
+    if (unlikely(!block_cache_usable))
+        return NULL;
+
+    block_cache_t *cache = vlc_threadvar_get(block_cache_key);
+    if (likely(cache != NULL))
+        return cache;
+
+    vlc_mutex_lock(&block_cache_lock);
+    cache = block_cache_orphans;
+    if (cache != NULL)
+        block_cache_orphans = cache->next_orphan;
+    vlc_mutex_unlock(&block_cache_lock);
+
+    if (cache == NULL)
+    {
+        cache = malloc(sizeof (*cache));
+        if (unlikely(cache == NULL))
+            return NULL;
+
+        for (unsigned i = 0; i < BLOCK_CACHE_CLASSES; i++)
+        {
+            cache->free[i] = NULL;
+            cache->count[i] = 0;
+        }
+        atomic_init(&cache->remote, NULL);
+        atomic_init(&cache->hits, 0);
+        atomic_init(&cache->misses, 0);
+        atomic_init(&cache->remote_frees, 0);
+
+        vlc_mutex_lock(&block_cache_lock);
+        cache->next = block_caches;
+        block_caches = cache;
+        vlc_mutex_unlock(&block_cache_lock);
+    }
+
+    if (unlikely(vlc_threadvar_set(block_cache_key, cache)))
+    {
+        block_cache_Detach(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+static void block_cached_Release(block_t *block)
+{
+    block_cached_t *cb = container_of(block, block_cached_t, self);
+    block_cache_t *cache = cb->cache;
+
+    assert(block->p_start == (unsigned char *)(cb + 1));
+    block_Invalidate(block);
+
+    if (vlc_threadvar_get(block_cache_key) == cache)
+    {
+        block_cache_Put(cache, block);
+        return;
+    }
+
+    /* Foreign thread: hand the block back to its owner. */
+    block_t *head = atomic_load_explicit(&cache->remote, memory_order_relaxed);
+    do
+        block->p_next = head;
+    while (!atomic_compare_exchange_weak_explicit(&cache->remote, &head, block,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+    atomic_fetch_add_explicit(&cache->remote_frees, 1, memory_order_relaxed);
+}
+
+static block_t *block_cache_Alloc(size_t size)
+{
+    if (size > BLOCK_CACHE_MAX)
+        return NULL;
+
+    block_cache_t *cache = block_cache_Get();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    unsigned klass = block_cache_Class(size);
+    block_t *b = cache->free[klass];
+
+    if (b == NULL)
+    {
+        block_cache_Drain(cache);
+        b = cache->free[klass];
+    }
+
+    if (b != NULL)
+    {
+        cache->free[klass] = b->p_next;
+        cache->count[klass]--;
+        block_cache_Count(&cache->hits);
+    }
+    else
+    {
+        block_cached_t *cb = malloc(sizeof (*cb) + BLOCK_ALIGN
+                                    + (2 * BLOCK_PADDING)
+                                    + block_cache_ClassSize(klass));
+        if (unlikely(cb == NULL))
+            return NULL;
+
+        cb->cache = cache;
+        cb->klass = klass;
+        b = &cb->self;
+        block_cache_Count(&cache->misses);
+    }
+
+    block_cached_t *cb = container_of(b, block_cached_t, self);
+
+    block_Init(b, cb + 1, BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                          + block_cache_ClassSize(klass));
+    b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
+    b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
+    b->i_buffer = size;
+    b->pf_release = block_cached_Release;
+    return b;
+}
+
+void block_CacheGetStats(block_cache_stats_t *stats)
+{
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->remote_frees = 0;
+    stats->caches = 0;
+
+    vlc_mutex_lock(&block_cache_lock);
+    for (block_cache_t *c = block_caches; c != NULL; c = c->next)
+    {
+        stats->hits += atomic_load_explicit(&c->hits, memory_order_relaxed);
+        stats->misses += atomic_load_explicit(&c->misses,
+                                              memory_order_relaxed);
+        stats->remote_frees += atomic_load_explicit(&c->remote_frees,
+                                                    memory_order_relaxed);
+        stats->caches++;
+    }
+    vlc_mutex_unlock(&block_cache_lock);
+}
+
+/** @} */
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -125,13 +429,17 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
+    block_t *b = block_cache_Alloc (size);
+    if (likely(b != NULL))
+        return b;
+
     /* 2 * BLOCK_PADDING: pre + post padding */
     const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
                        + size;
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
+    b = malloc (alloc);
     if (unlikely(b == NULL))
         return NULL;
 
@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -44,10 +45,22 @@ struct block_fifo_t
     block_t             **pp_last;
     size_t              i_depth;
     size_t              i_size;
+
+    /* Lock-less mode: producers push onto a LIFO stack, which the consumer
+     * reverses into its private p_first list. The lock and condition
+     * variable are only used to sleep when the queue is empty. */
+    bool                lockless;
+    _Atomic(block_t *)  incoming; /**< blocks queued in reverse order */
+    /* Accounted after publishing and after dequeuing: the counters may lag
+     * behind the queue, and be transiently negative. */
+    atomic_ptrdiff_t    depth;
+    atomic_ptrdiff_t    size;
+    atomic_bool         waiting; /**< consumer is (about to be) sleeping */
 };
 
 void vlc_fifo_Lock(vlc_fifo_t *fifo)
 {
+    assert(!fifo->lockless);
     vlc_mutex_lock(&fifo->lock);
 }
 
@@ -141,7 +154,7 @@ block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
     return block;
 }
 
-block_fifo_t *block_FifoNew( void )
+static block_fifo_t *block_FifoCreate(bool lockless)
 {
     block_fifo_t *p_fifo = malloc( sizeof( block_fifo_t ) );
     if( !p_fifo )
@@ -153,11 +166,158 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
 
+    p_fifo->lockless = lockless;
+    atomic_init(&p_fifo->incoming, NULL);
+    atomic_init(&p_fifo->depth, 0);
+    atomic_init(&p_fifo->size, 0);
+    atomic_init(&p_fifo->waiting, false);
+
     return p_fifo;
 }
 
+block_fifo_t *block_FifoNew( void )
+{
+    return block_FifoCreate(false);
+}
+
+block_fifo_t *block_FifoNewLockless(void)
+{
+    return block_FifoCreate(true);
+}
+
+/*** Lock-less mode ***/
+
+static void LocklessPut(block_fifo_t *fifo, block_t *block)
+{
+    block_t *head = NULL, *tail = block;
+    size_t depth = 0, size = 0;
+
+    if (block == NULL)
+        return;
+
+    /* Reverse the chain, so that the consumer gets it in order. */
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = head;
+        head = block;
+        depth++;
+        size += block->i_buffer;
+        block = next;
+    }
+
+    block_t *top = atomic_load_explicit(&fifo->incoming, memory_order_relaxed);
+    do
+        tail->p_next = top;
+    while (!atomic_compare_exchange_weak(&fifo->incoming, &top, head));
+
+    /* Account after publishing, so that the consumer never sees a non-zero
+     * count with an empty queue. */
+    atomic_fetch_add_explicit(&fifo->depth, depth, memory_order_release);
+    atomic_fetch_add_explicit(&fifo->size, size, memory_order_relaxed);
+
+    if (atomic_load(&fifo->waiting))
+    {
+        vlc_mutex_lock(&fifo->lock);
+        vlc_cond_signal(&fifo->wait);
+        vlc_mutex_unlock(&fifo->lock);
+    }
+}
+
+/** Moves blocks from the producers stack to the consumer list. */
+static block_t *LocklessPeek(block_fifo_t *fifo)
+{
+    if (fifo->p_first == NULL)
+    {
+        block_t *block = atomic_exchange(&fifo->incoming, NULL);
+        block_t *list = NULL;
+
+        while (block != NULL)
+        {
+            block_t *next = block->p_next;
+
+            block->p_next = list;
+            list = block;
+            block = next;
+        }
+        fifo->p_first = list;
+    }
+    return fifo->p_first;
+}
+
+static block_t *LocklessDequeue(block_fifo_t *fifo)
+{
+    block_t *block = LocklessPeek(fifo);
+
+    if (block == NULL)
+        return NULL;
+
+    fifo->p_first = block->p_next;
+    block->p_next = NULL;
+
+    atomic_fetch_sub_explicit(&fifo->depth, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&fifo->size, block->i_buffer,
+                              memory_order_relaxed);
+    return block;
+}
+
+static void LocklessCleanup(void *data)
+{
+    block_fifo_t *fifo = data;
+
+    atomic_store(&fifo->waiting, false);
+    vlc_mutex_unlock(&fifo->lock);
+}
+
+static block_t *LocklessGet(block_fifo_t *fifo)
+{
+    vlc_testcancel();
+
+    block_t *block = LocklessDequeue(fifo);
+    if (likely(block != NULL))
+        return block;
+
+    vlc_mutex_lock(&fifo->lock);
+    vlc_cleanup_push(LocklessCleanup, fifo);
+    for (;;)
+    {
+        /* Producers check the flag after publishing, so either they see it
+         * and signal under the lock, or we see their blocks here. */
+        atomic_store(&fifo->waiting, true);
+        block = LocklessDequeue(fifo);
+        if (block != NULL)
+            break;
+        vlc_cond_wait(&fifo->wait, &fifo->lock);
+    }
+    vlc_cleanup_pop();
+    LocklessCleanup(fifo);
+    return block;
+}
+
+static block_t *LocklessDequeueAll(block_fifo_t *fifo)
+{
+    block_t *block = LocklessPeek(fifo);
+    size_t depth = 0, size = 0;
+
+    fifo->p_first = NULL;
+    for (block_t *b = block; b != NULL; b = b->p_next)
+    {
+        depth++;
+        size += b->i_buffer;
+    }
+
+    atomic_fetch_sub_explicit(&fifo->depth, depth, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&fifo->size, size, memory_order_relaxed);
+    return block;
+}
+
+/*** Generic FIFO functions ***/
+
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
+    if( p_fifo->lockless )
+        block_ChainRelease( LocklessDequeueAll( p_fifo ) );
     block_ChainRelease( p_fifo->p_first );
     vlc_cond_destroy( &p_fifo->wait );
     vlc_mutex_destroy( &p_fifo->lock );
@@ -168,6 +328,12 @@ void block_FifoEmpty(block_fifo_t *fifo)
 {
     block_t *block;
 
+    if (fifo->lockless)
+    {
+        block_ChainRelease(LocklessDequeueAll(fifo));
+        return;
+    }
+
     vlc_fifo_Lock(fifo);
     block = vlc_fifo_DequeueAllUnlocked(fifo);
     vlc_fifo_Unlock(fifo);
@@ -176,6 +342,12 @@ void block_FifoEmpty(block_fifo_t *fifo)
 
 void block_FifoPut(block_fifo_t *fifo, block_t *block)
 {
+    if (fifo->lockless)
+    {
+        LocklessPut(fifo, block);
+        return;
+    }
+
     vlc_fifo_Lock(fifo);
     vlc_fifo_QueueUnlocked(fifo, block);
     vlc_fifo_Unlock(fifo);
@@ -185,6 +357,9 @@ block_t *block_FifoGet(block_fifo_t *fifo)
 {
     block_t *block;
 
+    if (fifo->lockless)
+        return LocklessGet(fifo);
+
     vlc_testcancel();
 
     vlc_fifo_Lock(fifo);
@@ -204,6 +379,9 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 {
     block_t *b;
 
+    if( p_fifo->lockless )
+        return LocklessPeek( p_fifo );
+
     vlc_mutex_lock( &p_fifo->lock );
     assert(p_fifo->p_first != NULL);
     b = p_fifo->p_first;
@@ -217,6 +395,13 @@ size_t block_FifoSize (block_fifo_t *fifo)
 {
     size_t size;
 
+    if (fifo->lockless)
+    {
+        ptrdiff_t val = atomic_load_explicit(&fifo->size,
+                                             memory_order_relaxed);
+        return (val > 0) ? val : 0;
+    }
+
     vlc_mutex_lock (&fifo->lock);
     size = fifo->i_size;
     vlc_mutex_unlock (&fifo->lock);
@@ -228,6 +413,13 @@ size_t block_FifoCount (block_fifo_t *fifo)
 {
     size_t depth;
 
+    if (fifo->lockless)
+    {
+        ptrdiff_t val = atomic_load_explicit(&fifo->depth,
+                                             memory_order_acquire);
+        return (val > 0) ? val : 0;
+    }
+
     vlc_mutex_lock (&fifo->lock);
     depth = fifo->i_depth;
     vlc_mutex_unlock (&fifo->lock);
@@ -28,6 +28,7 @@
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
+#include <vlc_slices.h>
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
@@ -61,6 +62,8 @@ struct filter_chain_t
     bool b_allow_fmt_out_change; /**< Can the output format be changed? */
     const char *filter_cap; /**< Filter modules capability */
     const char *conv_cap; /**< Converter modules capability */
+    vlc_slices_t *slices; /**< Slice threads (created on demand) */
+    bool slices_failed; /**< Slice threads could not be created */
 };
 
 /**
@@ -89,6 +92,8 @@ static filter_chain_t *filter_chain_NewInner( const filter_owner_t *callbacks,
     chain->b_allow_fmt_out_change = fmt_out_change;
     chain->filter_cap = cap;
     chain->conv_cap = conv_cap;
+    chain->slices = NULL;
+    chain->slices_failed = false;
     return chain;
 }
 
@@ -151,6 +156,9 @@ void filter_chain_Delete( filter_chain_t *p_chain )
     while( p_chain->first != NULL )
         filter_chain_DeleteFilter( p_chain, &p_chain->first->filter );
 
+    if( p_chain->slices != NULL )
+        vlc_slices_Delete( p_chain->slices );
+
     es_format_Clean( &p_chain->fmt_in );
     es_format_Clean( &p_chain->fmt_out );
 
@@ -391,12 +399,96 @@ const es_format_t *filter_chain_GetFmtOut( filter_chain_t *p_chain )
     return &p_chain->fmt_out;
 }
 
+/* Picture being filtered by slices */
+typedef struct
+{
+    filter_t *filter;
+    picture_t *dst;
+    const picture_t *src;
+    unsigned height;
+    unsigned slice_height;
+} filter_slices_job_t;
+
+static void FilterSlice( void *opaque, unsigned index, unsigned worker )
+{
+    const filter_slices_job_t *job = opaque;
+    unsigned y0 = index * job->slice_height;
+    unsigned y1 = y0 + job->slice_height;
+
+    if( y1 > job->height )
+        y1 = job->height;
+    job->filter->pf_video_slice( job->filter, job->dst, job->src, y0, y1 );
+    (void) worker;
+}
+
+static vlc_slices_t *FilterSlicesNew( vlc_object_t *obj )
+{
+    unsigned count = var_InheritInteger( obj, "video-filter-threads" );
+
+    if( count == 0 )
+        count = vlc_GetCPUCount();
+
+    vlc_slices_t *slices = vlc_slices_New( count, VLC_THREAD_PRIORITY_VIDEO );
+    if( slices != NULL )
+        msg_Dbg( obj, "processing video filter slices with %u threads",
+                 vlc_slices_GetThreads( slices ) );
+    return slices;
+}
+
+/**
+ * Filters a picture by slices, on the slice threads and the calling thread.
+ */
+static picture_t *FilterSlicesProcess( vlc_slices_t *slices,
+                                       filter_t *filter, picture_t *src )
+{
+    picture_t *dst = filter_NewPicture( filter );
+    if( dst == NULL )
+    {
+        picture_Release( src );
+        return NULL;
+    }
+
+    const unsigned height = src->p[0].i_visible_lines;
+    /* A few slices per thread balance the load if some threads lag */
+    unsigned count = 4 * vlc_slices_GetThreads( slices );
+    unsigned slice_height = (height + count - 1) / count;
+
+    slice_height = (slice_height + 15) & ~15u;
+
+    filter_slices_job_t job = {
+        .filter = filter,
+        .dst = dst,
+        .src = src,
+        .height = height,
+        .slice_height = slice_height,
+    };
+
+    vlc_slices_Run( slices, (height + slice_height - 1) / slice_height,
+                    FilterSlice, &job );
+
+    picture_CopyProperties( dst, src );
+    picture_Release( src );
+    return dst;
+}
+
 static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic )
 {
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
-        p_pic = p_filter->pf_video_filter( p_filter, p_pic );
+        filter_chain_t *chain = p_filter->owner.sys;
+
+        if( p_filter->pf_video_slice != NULL && chain->slices == NULL
+         && !chain->slices_failed )
+        {
+            chain->slices = FilterSlicesNew( chain->callbacks.sys );
+            chain->slices_failed = chain->slices == NULL;
+        }
+
+        if( p_filter->pf_video_slice != NULL && chain->slices != NULL )
+            p_pic = FilterSlicesProcess( chain->slices, p_filter, p_pic );
+        else
+            p_pic = p_filter->pf_video_filter( p_filter, p_pic );
         if( !p_pic )
             break;
         if( f->pending )
@@ -211,6 +211,7 @@ static picture_priv_t *picture_NewPrivate(const video_format_t *restrict p_fmt)
 
     atomic_init( &priv->gc.refs, 1 );
     priv->gc.opaque = NULL;
+    priv->queued = VLC_TS_INVALID;
 
     return priv;
 }
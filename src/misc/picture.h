@@ -31,4 +31,5 @@ typedef struct
         void (*destroy)(picture_t *);
         void *opaque;
     } gc;
+    mtime_t queued; /**< Date queued to the video output */
 } picture_priv_t;
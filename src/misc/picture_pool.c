@@ -38,14 +38,20 @@
 
 static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 
+/*
+ * The set of available pictures is a bitmap, updated atomically so that
+ * getting and releasing pictures does not take any lock. The mutex and the
+ * condition variable are only used to sleep while the pool is exhausted.
+ */
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
     void      (*pic_unlock)(picture_t *);
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    atomic_ullong      available;
+    atomic_uint        waiters;
     atomic_ushort      refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -68,6 +74,46 @@ void picture_pool_Release(picture_pool_t *pool)
     picture_pool_Destroy(pool);
 }
 
+/**
+ * Takes one of the available pictures among the ones in mask.
+ * \return the picture index, or -1 if none is available
+ */
+static int picture_pool_Take(picture_pool_t *pool, unsigned long long mask)
+{
+    unsigned long long available = atomic_load(&pool->available);
+
+    while ((available & mask) != 0)
+    {
+        int i = ctz(available & mask);
+
+        if (atomic_compare_exchange_weak(&pool->available, &available,
+                                         available & ~(1ULL << i)))
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Makes a picture available again, and wakes a waiting thread if any.
+ */
+static void picture_pool_Give(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long available;
+
+    available = atomic_fetch_or(&pool->available, 1ULL << offset);
+    assert(!(available & (1ULL << offset)));
+    (void) available;
+
+    /* Both this and picture_pool_Wait() use sequentially consistent
+     * operations: either the waiter sees the picture, or it is seen here. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
@@ -82,12 +128,7 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_Give(pool, offset);
     picture_pool_Destroy(pool);
 }
 
@@ -133,14 +174,15 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
     if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << cfg->picture_count) - 1;
+        atomic_init(&pool->available, (1ULL << cfg->picture_count) - 1);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = cfg->picture_count;
     memcpy(pool->picture, cfg->picture,
            cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -203,28 +245,25 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
+    unsigned long long mask = ~0ULL;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
+    assert(atomic_load(&pool->refs) > 0);
 
-    while (available != 0)
+    for (;;)
     {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
-            break;
+        if (unlikely(atomic_load(&pool->canceled)))
+            return NULL;
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+        int i = picture_pool_Take(pool, mask);
+        if (i < 0)
+            return NULL;
 
         picture_t *picture = pool->picture[i];
 
+        /* Try the other pictures if this one cannot be locked */
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << i;
+            picture_pool_Give(pool, i);
+            mask &= ~(1ULL << i);
             continue;
         }
 
@@ -235,37 +274,38 @@ picture_t *picture_pool_Get(picture_pool_t *pool)
         }
         return clone;
     }
-
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    int i;
+
+    assert(atomic_load(&pool->refs) > 0);
 
-    while (pool->available == 0)
+    i = picture_pool_Take(pool, ~0ULL);
+    if (i < 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        while ((i = picture_pool_Take(pool, ~0ULL)) < 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+
+        if (i < 0)
+            return NULL;
+    }
 
     picture_t *picture = pool->picture[i];
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << i;
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_Give(pool, i);
         return NULL;
     }
 
@@ -279,10 +319,10 @@ picture_t *picture_pool_Wait(picture_pool_t *pool)
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    vlc_mutex_lock(&pool->lock);
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
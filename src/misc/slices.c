@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * slices.c: slice thread pool
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_slices.h>
+
+struct vlc_slice_thread
+{
+    vlc_slices_t *pool;
+    vlc_thread_t thread;
+    unsigned index;
+};
+
+struct vlc_slices
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait_work;
+    vlc_cond_t wait_done;
+    struct vlc_slice_thread *threads;
+    unsigned count; /**< Pool threads, excluding the calling thread */
+    bool exit;
+
+    /* Current job */
+    vlc_slice_cb cb;
+    void *opaque;
+    unsigned slices;
+    unsigned next; /**< Next slice to process */
+    unsigned pending; /**< Slices not processed yet */
+};
+
+static void vlc_slices_Process(vlc_slices_t *pool, unsigned worker)
+{
+    while (pool->next < pool->slices)
+    {
+        unsigned index = pool->next++;
+
+        vlc_mutex_unlock(&pool->lock);
+        pool->cb(pool->opaque, index, worker);
+        vlc_mutex_lock(&pool->lock);
+
+        assert(pool->pending > 0);
+        if (--pool->pending == 0)
+            vlc_cond_signal(&pool->wait_done);
+    }
+}
+
+static void *vlc_slices_Thread(void *data)
+{
+    struct vlc_slice_thread *th = data;
+    vlc_slices_t *pool = th->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->exit && pool->next >= pool->slices)
+            vlc_cond_wait(&pool->wait_work, &pool->lock);
+        if (pool->exit)
+            break;
+        vlc_slices_Process(pool, th->index);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+vlc_slices_t *vlc_slices_New(unsigned threads, int priority)
+{
+    /* The calling thread processes slices too */
+    if (threads <= 1)
+        return NULL;
+    threads--;
+
+    vlc_slices_t *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    pool->threads = vlc_alloc(threads, sizeof (*pool->threads));
+    if (unlikely(pool->threads == NULL))
+    {
+        free(pool);
+        return NULL;
+    }
+
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait_work);
+    vlc_cond_init(&pool->wait_done);
+    pool->count = 0;
+    pool->exit = false;
+    pool->slices = pool->next = pool->pending = 0;
+
+    while (pool->count < threads)
+    {
+        struct vlc_slice_thread *th = &pool->threads[pool->count];
+
+        th->pool = pool;
+        th->index = pool->count + 1;
+        if (vlc_clone(&th->thread, vlc_slices_Thread, th, priority))
+            break;
+        pool->count++;
+    }
+
+    if (pool->count == 0)
+    {
+        vlc_slices_Delete(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void vlc_slices_Delete(vlc_slices_t *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->exit = true;
+    vlc_cond_broadcast(&pool->wait_work);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->count; i++)
+        vlc_join(pool->threads[i].thread, NULL);
+
+    vlc_cond_destroy(&pool->wait_done);
+    vlc_cond_destroy(&pool->wait_work);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+unsigned vlc_slices_GetThreads(const vlc_slices_t *pool)
+{
+    return pool->count + 1;
+}
+
+void vlc_slices_Run(vlc_slices_t *pool, unsigned count, vlc_slice_cb cb,
+                    void *opaque)
+{
+    if (count == 0)
+        return;
+
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->pending == 0);
+    pool->cb = cb;
+    pool->opaque = opaque;
+    pool->slices = count;
+    pool->pending = count;
+    pool->next = 0;
+    vlc_cond_broadcast(&pool->wait_work);
+
+    vlc_slices_Process(pool, 0);
+    while (pool->pending > 0)
+        vlc_cond_wait(&pool->wait_done, &pool->lock);
+    vlc_mutex_unlock(&pool->lock);
+}
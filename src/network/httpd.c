@@ -31,6 +31,7 @@
 #include <vlc_httpd.h>
 
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_network.h>
 #include <vlc_tls.h>
@@ -66,8 +67,14 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* maximum number of stream chunks a client sends with one writev() */
+#define HTTPD_CL_CHUNKS 32
+
+/* maximum number of threads sending data to clients, besides the host one */
+#define HTTPD_MAX_WORKERS 7
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static int httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -86,6 +93,23 @@ struct httpd_host_t
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
+    /* wakes the host thread up when streams get new data (or -1) */
+    int         wakefd[2];
+    atomic_bool wake_pending;
+
+    /* threads sending data to ready clients on behalf of the host thread */
+    vlc_thread_t *workers;
+    unsigned     nworkers;
+    vlc_mutex_t  work_lock;
+    vlc_cond_t   work_wait;
+    vlc_cond_t   work_done;
+    httpd_client_t **work;
+    unsigned     work_count;
+    unsigned     work_next;
+    unsigned     work_busy;
+    unsigned     work_seq;
+    bool         work_exit;
+
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
      * All url will have their cb trigger, but only the first one can answer
@@ -135,6 +159,32 @@ enum
     HTTPD_CLIENT_TLS_HS_OUT
 };
 
+/*
+ * Stream data, shared by all the clients of a stream.
+ * The data is written once and is read-only afterward, so that clients can
+ * send it without copying nor locking while they hold a reference.
+ */
+typedef struct httpd_chunk_t
+{
+    struct httpd_chunk_t *p_next; /* only valid while in the stream window */
+    atomic_uint i_refs;
+    int64_t     i_pos;            /* absolute position from beginning */
+    size_t      i_data;
+    uint8_t     p_data[];
+} httpd_chunk_t;
+
+static void httpd_ChunkHold(httpd_chunk_t *chunk)
+{
+    atomic_fetch_add_explicit(&chunk->i_refs, 1, memory_order_relaxed);
+}
+
+static void httpd_ChunkRelease(httpd_chunk_t *chunk)
+{
+    if (atomic_fetch_sub_explicit(&chunk->i_refs, 1,
+                                  memory_order_acq_rel) == 1)
+        free(chunk);
+}
+
 struct httpd_client_t
 {
     httpd_url_t *url;
@@ -160,6 +210,13 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* stream data being sent (stream mode only) */
+    httpd_stream_t *stream;
+    httpd_chunk_t  *p_cursor;        /* last chunk taken from the stream */
+    httpd_chunk_t  *pp_chunks[HTTPD_CL_CHUNKS];
+    unsigned        i_chunks;
+    size_t          i_chunk_offset;  /* bytes of pp_chunks[0] already sent */
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -606,9 +663,13 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    httpd_chunk_t *p_keyframe;      /* chunk at i_last_keyframe_seen_pos */
+
+    /* window of shared data chunks */
+    size_t      i_buffer_size;      /* maximum window size */
+    size_t      i_buffer;           /* current window size */
+    httpd_chunk_t *p_first;         /* oldest chunk */
+    httpd_chunk_t *p_last;          /* newest chunk */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -627,47 +688,8 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
-
-        if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
-        }
-
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
-
-        /* using HTTPD_MSG_ANSWER -> data available */
-        answer->i_proto  = HTTPD_PROTO_HTTP;
-        answer->i_version= 0;
-        answer->i_type   = HTTPD_MSG_ANSWER;
-
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
-
-        answer->i_body_offset += i_write;
-
-        return VLC_SUCCESS;
+        /* Data is sent straight from the shared chunks, see httpd_StreamPin */
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -693,6 +715,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         if (query->i_type != HTTPD_MSG_HEAD) {
             cl->b_stream_mode = true;
+            cl->stream = stream;
             vlc_mutex_lock(&stream->lock);
             /* Send the header */
             if (stream->i_header > 0) {
@@ -701,6 +724,10 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
             answer->i_body_offset = stream->i_buffer_last_pos;
+            if (stream->p_last != NULL) {
+                httpd_ChunkHold(stream->p_last);
+                cl->p_cursor = stream->p_last;
+            }
             if (stream->b_has_keyframes)
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
@@ -764,7 +791,10 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc(stream->i_buffer_size);
+    stream->i_buffer = 0;
+    stream->p_first = NULL;
+    stream->p_last = NULL;
+    stream->p_keyframe = NULL;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -800,45 +830,128 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+static int httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    httpd_chunk_t *chunk = malloc(sizeof (*chunk) + i_data);
+    if (unlikely(chunk == NULL))
+        return VLC_ENOMEM;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+    chunk->p_next = NULL;
+    atomic_init(&chunk->i_refs, 1);
+    chunk->i_pos = stream->i_buffer_pos;
+    chunk->i_data = i_data;
+    memcpy(chunk->p_data, p_data, i_data);
+
+    if (stream->p_last != NULL)
+        stream->p_last->p_next = chunk;
+    else
+        stream->p_first = chunk;
+    stream->p_last = chunk;
+    stream->i_buffer += i_data;
+    stream->i_buffer_pos += i_data;
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
-    }
+    /* Drop the oldest data. Clients still sending it hold references. */
+    while (stream->i_buffer > stream->i_buffer_size
+        && stream->p_first != chunk) {
+        httpd_chunk_t *first = stream->p_first;
 
-    stream->i_buffer_pos += i_data;
+        stream->p_first = first->p_next;
+        stream->i_buffer -= first->i_data;
+        if (stream->p_keyframe == first)
+            stream->p_keyframe = NULL;
+        httpd_ChunkRelease(first);
+    }
+    return VLC_SUCCESS;
 }
 
+static void httpd_HostWake(httpd_host_t *host);
+
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 {
-    if (!p_block || !p_block->p_buffer)
+    if (!p_block || !p_block->p_buffer || p_block->i_buffer == 0)
         return VLC_SUCCESS;
 
     vlc_mutex_lock(&stream->lock);
 
     /* save this pointer (to be used by new connection) */
-    stream->i_buffer_last_pos = stream->i_buffer_pos;
+    int64_t i_last_pos = stream->i_buffer_pos;
+
+    if (httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer)) {
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_ENOMEM;
+    }
+
+    stream->i_buffer_last_pos = i_last_pos;
 
     if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
         stream->b_has_keyframes = true;
-        stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
+        stream->i_last_keyframe_seen_pos = i_last_pos;
+        stream->p_keyframe = stream->p_last;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
-
     vlc_mutex_unlock(&stream->lock);
+
+    httpd_HostWake(stream->url->host);
     return VLC_SUCCESS;
 }
 
+/**
+ * Takes references to the next stream chunks of a client in stream mode.
+ * Returns the number of chunks now pending on the client (0 if none).
+ */
+static unsigned httpd_StreamPin(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    int64_t offset = cl->answer.i_body_offset;
+    httpd_chunk_t *chunk = cl->p_cursor;
+
+    assert(cl->i_chunks == 0);
+
+    vlc_mutex_lock(&stream->lock);
+    if (offset >= stream->i_buffer_pos)
+        goto out; /* wait, no data available */
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            goto out;
+
+        /* seek to the new keyframe */
+        offset = stream->i_last_keyframe_seen_pos;
+        chunk = stream->p_keyframe;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (offset < stream->p_first->i_pos) {
+        /* this client isn't fast enough */
+        offset = stream->i_buffer_last_pos;
+        chunk = stream->p_last;
+    }
+
+    /* Chunks older than the window are not linked anymore */
+    if (chunk == NULL || chunk->i_pos < stream->p_first->i_pos)
+        chunk = stream->p_first;
+    while (chunk->i_pos + (int64_t)chunk->i_data <= offset)
+        chunk = chunk->p_next;
+
+    cl->i_chunk_offset = offset - chunk->i_pos;
+    do {
+        httpd_ChunkHold(chunk);
+        cl->pp_chunks[cl->i_chunks++] = chunk;
+        offset = chunk->i_pos + chunk->i_data;
+    } while ((chunk = chunk->p_next) != NULL
+          && cl->i_chunks < HTTPD_CL_CHUNKS);
+
+    chunk = cl->pp_chunks[cl->i_chunks - 1];
+    httpd_ChunkHold(chunk);
+    if (cl->p_cursor != NULL)
+        httpd_ChunkRelease(cl->p_cursor);
+    cl->p_cursor = chunk;
+    cl->answer.i_body_offset = offset;
+out:
+    vlc_mutex_unlock(&stream->lock);
+    return cl->i_chunks;
+}
+
 void httpd_StreamDelete(httpd_stream_t *stream)
 {
     httpd_UrlDelete(stream->url);
@@ -850,7 +963,12 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    while (stream->p_first != NULL) {
+        httpd_chunk_t *chunk = stream->p_first;
+
+        stream->p_first = chunk->p_next;
+        httpd_ChunkRelease(chunk);
+    }
     free(stream);
 }
 
@@ -858,6 +976,8 @@ void httpd_StreamDelete(httpd_stream_t *stream)
  * Low level
  *****************************************************************************/
 static void* httpd_HostThread(void *);
+static void *httpd_WorkerThread(void *);
+static void httpd_HostStopWorkers(httpd_host_t *);
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t *);
 
@@ -957,6 +1077,7 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
     host->i_ref = 1;
+    host->wakefd[0] = host->wakefd[1] = -1;
 
     host->fds = net_ListenTCP(p_this, url.psz_host, port);
     if (!host->fds) {
@@ -972,10 +1093,37 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->client   = NULL;
     host->p_tls    = p_tls;
 
+#ifndef _WIN32
+    if (vlc_socketpair(PF_LOCAL, SOCK_STREAM, 0, host->wakefd, true))
+        host->wakefd[0] = host->wakefd[1] = -1; /* poll streams instead */
+#endif
+    atomic_init(&host->wake_pending, false);
+
+    /* create the send worker threads */
+    vlc_mutex_init(&host->work_lock);
+    vlc_cond_init(&host->work_wait);
+    vlc_cond_init(&host->work_done);
+    host->work = NULL;
+    host->work_count = host->work_next = host->work_busy = 0;
+    host->work_seq = 0;
+    host->work_exit = false;
+    host->nworkers = 0;
+
+    unsigned nworkers = vlc_GetCPUCount();
+    nworkers = (nworkers > HTTPD_MAX_WORKERS) ? HTTPD_MAX_WORKERS
+                                              : nworkers - 1;
+    host->workers = vlc_alloc(nworkers, sizeof (*host->workers));
+    if (host->workers != NULL)
+        while (host->nworkers < nworkers
+            && vlc_clone(&host->workers[host->nworkers], httpd_WorkerThread,
+                         host, VLC_THREAD_PRIORITY_LOW) == 0)
+            host->nworkers++;
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
         msg_Err(p_this, "cannot spawn http host thread");
+        httpd_HostStopWorkers(host);
         goto error;
     }
 
@@ -992,6 +1140,10 @@ error:
 
     if (host) {
         net_ListenClose(host->fds);
+        if (host->wakefd[0] != -1) {
+            vlc_close(host->wakefd[1]);
+            vlc_close(host->wakefd[0]);
+        }
         vlc_cond_destroy(&host->wait);
         vlc_mutex_destroy(&host->lock);
         vlc_object_release(host);
@@ -1024,6 +1176,7 @@ void httpd_HostDelete(httpd_host_t *host)
 
     vlc_cancel(host->thread);
     vlc_join(host->thread, NULL);
+    httpd_HostStopWorkers(host);
 
     msg_Dbg(host, "HTTP host removed");
 
@@ -1038,6 +1191,10 @@ void httpd_HostDelete(httpd_host_t *host)
 
     vlc_tls_Delete(host->p_tls);
     net_ListenClose(host->fds);
+    if (host->wakefd[0] != -1) {
+        vlc_close(host->wakefd[1]);
+        vlc_close(host->wakefd[0]);
+    }
     vlc_cond_destroy(&host->wait);
     vlc_mutex_destroy(&host->lock);
     vlc_object_release(host);
@@ -1199,6 +1356,10 @@ static void httpd_ClientInit(httpd_client_t *cl, mtime_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
+    cl->p_cursor = NULL;
+    cl->i_chunks = 0;
+    cl->i_chunk_offset = 0;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1214,8 +1375,23 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
+/* Releases the stream data of a client */
+static void httpd_ClientDropStream(httpd_client_t *cl)
+{
+    for (unsigned i = 0; i < cl->i_chunks; i++)
+        httpd_ChunkRelease(cl->pp_chunks[i]);
+    cl->i_chunks = 0;
+    cl->i_chunk_offset = 0;
+
+    if (cl->p_cursor != NULL)
+        httpd_ChunkRelease(cl->p_cursor);
+    cl->p_cursor = NULL;
+    cl->stream = NULL;
+}
+
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
+    httpd_ClientDropStream(cl);
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
@@ -1254,6 +1430,38 @@ ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
     return sock->writev(sock, &iov, 1);
 }
 
+/* Sends pending stream chunks, straight from the shared stream data */
+static ssize_t httpd_ClientSendChunks(httpd_client_t *cl)
+{
+    vlc_tls_t *sock = cl->sock;
+    struct iovec iov[HTTPD_CL_CHUNKS];
+
+    for (unsigned i = 0; i < cl->i_chunks; i++) {
+        iov[i].iov_base = cl->pp_chunks[i]->p_data;
+        iov[i].iov_len = cl->pp_chunks[i]->i_data;
+    }
+    iov[0].iov_base = (uint8_t *)iov[0].iov_base + cl->i_chunk_offset;
+    iov[0].iov_len -= cl->i_chunk_offset;
+
+    ssize_t val = sock->writev(sock, iov, cl->i_chunks);
+    if (val <= 0)
+        return val;
+
+    /* Release the chunks that were fully sent */
+    size_t len = val;
+    unsigned i = 0;
+
+    while (i < cl->i_chunks && len >= iov[i].iov_len) {
+        len -= iov[i].iov_len;
+        httpd_ChunkRelease(cl->pp_chunks[i++]);
+    }
+    cl->i_chunks -= i;
+    memmove(cl->pp_chunks, cl->pp_chunks + i,
+            cl->i_chunks * sizeof (cl->pp_chunks[0]));
+    cl->i_chunk_offset = (i > 0) ? len : cl->i_chunk_offset + len;
+    return val;
+}
+
 
 static const struct
 {
@@ -1558,9 +1766,32 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+/* Fetches more body data for a client in stream mode */
+static void httpd_ClientCatchBody(httpd_client_t *cl)
+{
+    int     i_msg = cl->query.i_type;
+    int64_t i_offset = cl->answer.i_body_offset;
+
+    httpd_MsgClean(&cl->answer);
+    cl->answer.i_body_offset = i_offset;
+
+    if (cl->stream != NULL)
+        httpd_StreamPin(cl->stream, cl);
+    else {
+        httpd_url_t *url = cl->url;
+
+        /* This may run on a worker thread: callbacks expect to be serialized,
+         * so keep them from running concurrently for clients of one URL. */
+        vlc_mutex_lock(&url->lock);
+        url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl,
+                             &cl->answer, &cl->query);
+        vlc_mutex_unlock(&url->lock);
+    }
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
-    int i_len;
+    ssize_t i_len;
 
     if (cl->i_buffer < 0) {
         /* We need to create the header */
@@ -1593,25 +1824,23 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer_size = (uint8_t*)p - cl->p_buffer;
     }
 
-    i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer);
-    if (i_len >= 0) {
-        cl->i_buffer += i_len;
-
-        if (cl->i_buffer >= cl->i_buffer_size) {
-            if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
-                /* catch more body data */
-                int     i_msg = cl->query.i_type;
-                int64_t i_offset = cl->answer.i_body_offset;
-
-                httpd_MsgClean(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+    if (cl->i_chunks > 0)
+        i_len = httpd_ClientSendChunks(cl);
+    else {
+        i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer);
+        if (i_len >= 0)
+            cl->i_buffer += i_len;
+    }
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                                          &cl->answer, &cl->query);
-            }
+    if (i_len >= 0) {
+        if (cl->i_chunks == 0 && cl->i_buffer >= cl->i_buffer_size) {
+            if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0)
+                httpd_ClientCatchBody(cl); /* catch more body data */
 
-            if (cl->answer.i_body > 0) {
+            if (cl->i_chunks > 0)
+                ; /* send the stream data */
+            else if (cl->answer.i_body > 0) {
                 /* send the body data */
                 free(cl->p_buffer);
                 cl->p_buffer = cl->answer.p_body;
@@ -1687,15 +1916,91 @@ auth_failed:
     return false;
 }
 
+/* Wakes the host thread up, so that it catches new stream data */
+static void httpd_HostWake(httpd_host_t *host)
+{
+    if (host->wakefd[1] != -1
+     && !atomic_exchange(&host->wake_pending, true))
+        send(host->wakefd[1], "", 1, 0);
+}
+
+/* Sends data to a batch of ready clients, with the help of worker threads */
+static void httpd_HostSend(httpd_host_t *host, httpd_client_t **cls,
+                           unsigned count)
+{
+    if (host->nworkers == 0 || count < 2) {
+        for (unsigned i = 0; i < count; i++)
+            httpd_ClientSend(cls[i]);
+        return;
+    }
+
+    vlc_mutex_lock(&host->work_lock);
+    host->work = cls;
+    host->work_count = count;
+    host->work_next = 0;
+    host->work_seq++;
+    vlc_cond_broadcast(&host->work_wait);
+
+    while (host->work_next < host->work_count) {
+        httpd_client_t *cl = host->work[host->work_next++];
+
+        vlc_mutex_unlock(&host->work_lock);
+        httpd_ClientSend(cl);
+        vlc_mutex_lock(&host->work_lock);
+    }
+
+    /* Clients belong to the host thread again once all sends completed */
+    while (host->work_busy > 0)
+        vlc_cond_wait(&host->work_done, &host->work_lock);
+    host->work_count = 0;
+    vlc_mutex_unlock(&host->work_lock);
+}
+
+static void *httpd_WorkerThread(void *data)
+{
+    httpd_host_t *host = data;
+    unsigned seq = 0;
+
+    vlc_mutex_lock(&host->work_lock);
+    for (;;) {
+        while (host->work_seq == seq && !host->work_exit)
+            vlc_cond_wait(&host->work_wait, &host->work_lock);
+        if (host->work_exit)
+            break;
+
+        seq = host->work_seq;
+        host->work_busy++;
+
+        while (host->work_next < host->work_count) {
+            httpd_client_t *cl = host->work[host->work_next++];
+
+            vlc_mutex_unlock(&host->work_lock);
+            httpd_ClientSend(cl);
+            vlc_mutex_lock(&host->work_lock);
+        }
+
+        if (--host->work_busy == 0)
+            vlc_cond_signal(&host->work_done);
+    }
+    vlc_mutex_unlock(&host->work_lock);
+    return NULL;
+}
+
 static void httpdLoop(httpd_host_t *host)
 {
-    struct pollfd ufd[host->nfd + host->i_client];
+    struct pollfd ufd[host->nfd + 1 + host->i_client];
     unsigned nfd;
     for (nfd = 0; nfd < host->nfd; nfd++) {
         ufd[nfd].fd = host->fds[nfd];
         ufd[nfd].events = POLLIN;
         ufd[nfd].revents = 0;
     }
+    if (host->wakefd[0] != -1) {
+        ufd[nfd].fd = host->wakefd[0];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+        nfd++;
+    }
 
     /* add all socket that should be read/write and close dead connection */
     while (host->i_url <= 0) {
@@ -1888,6 +2193,7 @@ static void httpdLoop(httpd_host_t *host)
                     bool do_close = false;
 
                     cl->url = NULL;
+                    httpd_ClientDropStream(cl);
 
                     if (cl->query.i_proto != HTTPD_PROTO_HTTP
                      || cl->query.i_version > 0)
@@ -1927,15 +2233,11 @@ static void httpdLoop(httpd_host_t *host)
                 break;
 
             case HTTPD_CLIENT_WAITING:
-                i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
-
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
-
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                httpd_ClientCatchBody(cl);
+                if (cl->i_chunks > 0) {
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                    pufd->events = POLLOUT;
+                } else if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
                     cl->i_buffer      = 0;
                     cl->p_buffer      = cl->answer.p_body;
@@ -1948,7 +2250,7 @@ static void httpdLoop(httpd_host_t *host)
 
         if (pufd->events != 0)
             nfd++;
-        else
+        else if (cl->stream == NULL || host->wakefd[0] == -1)
             b_low_delay = true;
     }
     vlc_mutex_unlock(&host->lock);
@@ -1964,9 +2266,23 @@ static void httpdLoop(httpd_host_t *host)
     canc = vlc_savecancel();
     vlc_mutex_lock(&host->lock);
 
+    /* Acknowledge new stream data, clients will catch it on next iteration.
+     * Drain the socket pair before clearing the pending flag, so that the
+     * byte of any wake-up after the clear stays for the next poll(). Data
+     * signalled before the clear is caught by the clients before polling. */
+    nfd = host->nfd;
+    if (host->wakefd[0] != -1 && ufd[nfd++].revents) {
+        char dummy[16];
+
+        while (recv(host->wakefd[0], dummy, sizeof (dummy), 0) > 0);
+        atomic_store(&host->wake_pending, false);
+    }
+
     /* Handle client sockets */
+    httpd_client_t *ready[host->i_client > 0 ? host->i_client : 1];
+    unsigned nready = 0;
+
     now = mdate();
-    nfd = host->nfd;
 
     for (int i_client = 0; i_client < host->i_client; i_client++) {
         httpd_client_t *cl = host->client[i_client];
@@ -1984,13 +2300,14 @@ static void httpdLoop(httpd_host_t *host)
 
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+            case HTTPD_CLIENT_SENDING:   ready[nready++] = cl; break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
                 httpd_ClientTlsHandshake(host, cl);
                 break;
         }
     }
+    httpd_HostSend(host, ready, nready);
 
     /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
@@ -2041,6 +2358,22 @@ static void httpdLoop(httpd_host_t *host)
     vlc_restorecancel(canc);
 }
 
+static void httpd_HostStopWorkers(httpd_host_t *host)
+{
+    vlc_mutex_lock(&host->work_lock);
+    host->work_exit = true;
+    vlc_cond_broadcast(&host->work_wait);
+    vlc_mutex_unlock(&host->work_lock);
+
+    for (unsigned i = 0; i < host->nworkers; i++)
+        vlc_join(host->workers[i], NULL);
+    free(host->workers);
+
+    vlc_cond_destroy(&host->work_done);
+    vlc_cond_destroy(&host->work_wait);
+    vlc_mutex_destroy(&host->work_lock);
+}
+
 static void* httpd_HostThread(void *data)
 {
     httpd_host_t *host = data;
@@ -86,11 +86,170 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void *test_block_cache_thread(void *data)
+{
+    block_t **chain = data;
+
+    /* Blocks allocated here are released by the main thread. */
+    for (unsigned i = 0; i < 100; i++)
+    {
+        block_t *block = block_Alloc(188);
+        assert(block != NULL);
+        memset(block->p_buffer, i, block->i_buffer);
+        block->p_next = *chain;
+        *chain = block;
+    }
+    return NULL;
+}
+
+static void test_block_cache(void)
+{
+    block_cache_stats_t before, after;
+    block_t *chain = NULL;
+    vlc_thread_t th;
+
+    block_CacheGetStats(&before);
+
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        size_t size = (i * 97) % 40000;
+        block_t *block = block_Alloc(size);
+
+        assert(block != NULL);
+        assert(block->i_buffer == size);
+        assert(((uintptr_t)block->p_buffer % 32) == 0);
+        memset(block->p_buffer, 0xA5, size);
+
+        block = block_Realloc(block, 16, size + 32);
+        assert(block != NULL);
+        assert(block->i_buffer == 16 + size + 32);
+        block_Release(block);
+    }
+
+    block_CacheGetStats(&after);
+    assert(after.hits > before.hits);
+    assert(after.caches >= 1);
+
+    int val = vlc_clone(&th, test_block_cache_thread, &chain,
+                        VLC_THREAD_PRIORITY_LOW);
+    assert(val == 0);
+    vlc_join(th, NULL);
+
+    while (chain != NULL)
+    {
+        block_t *next = chain->p_next;
+        block_Release(chain);
+        chain = next;
+    }
+
+    block_CacheGetStats(&before);
+    assert(before.remote_frees >= after.remote_frees + 100);
+}
+
+#define FIFO_PRODUCERS 4
+#define FIFO_BLOCKS    20000
+
+struct fifo_producer
+{
+    block_fifo_t *fifo;
+    unsigned id;
+};
+
+static void *test_block_fifo_thread(void *data)
+{
+    struct fifo_producer *p = data;
+
+    /* Blocks are numbered per producer, some are queued as chains */
+    for (unsigned i = 0; i < FIFO_BLOCKS; )
+    {
+        block_t *chain = NULL, **pp = &chain;
+        unsigned n = 1 + (i % 3);
+
+        for (unsigned j = 0; j < n && i < FIFO_BLOCKS; j++, i++)
+        {
+            block_t *block = block_Alloc(2 * sizeof (unsigned));
+            assert(block != NULL);
+            memcpy(block->p_buffer, &p->id, sizeof (unsigned));
+            memcpy(block->p_buffer + sizeof (unsigned), &i, sizeof (unsigned));
+            *pp = block;
+            pp = &block->p_next;
+        }
+        block_FifoPut(p->fifo, chain);
+    }
+    return NULL;
+}
+
+static void test_block_fifo(void)
+{
+    block_fifo_t *fifo = block_FifoNewLockless();
+    struct fifo_producer producers[FIFO_PRODUCERS];
+    vlc_thread_t th[FIFO_PRODUCERS];
+    unsigned next[FIFO_PRODUCERS] = { 0 };
+
+    assert(fifo != NULL);
+    assert(block_FifoShow(fifo) == NULL);
+
+    for (unsigned i = 0; i < FIFO_PRODUCERS; i++)
+    {
+        producers[i].fifo = fifo;
+        producers[i].id = i;
+        int val = vlc_clone(&th[i], test_block_fifo_thread, &producers[i],
+                            VLC_THREAD_PRIORITY_LOW);
+        assert(val == 0);
+    }
+
+    /* Single consumer: the blocks of each producer come out in order, and
+     * a non-zero count always shows a block. */
+    for (unsigned n = 0; n < FIFO_PRODUCERS * FIFO_BLOCKS; n++)
+    {
+        unsigned id, seq;
+
+        if (block_FifoCount(fifo) > 0)
+            assert(block_FifoShow(fifo) != NULL);
+
+        block_t *shown = block_FifoShow(fifo);
+        block_t *block = block_FifoGet(fifo);
+        assert(block != NULL);
+        assert(shown == NULL || shown == block);
+        assert(block->p_next == NULL);
+
+        memcpy(&id, block->p_buffer, sizeof (id));
+        memcpy(&seq, block->p_buffer + sizeof (id), sizeof (seq));
+        assert(id < FIFO_PRODUCERS);
+        assert(seq == next[id]);
+        next[id]++;
+        block_Release(block);
+    }
+
+    for (unsigned i = 0; i < FIFO_PRODUCERS; i++)
+        vlc_join(th[i], NULL);
+
+    assert(block_FifoShow(fifo) == NULL);
+    assert(block_FifoCount(fifo) == 0);
+
+    /* Emptying and releasing with queued blocks */
+    for (unsigned i = 0; i < 3; i++)
+    {
+        block_t *block = block_Alloc(100);
+        assert(block != NULL);
+        block_FifoPut(fifo, block);
+    }
+    assert(block_FifoCount(fifo) == 3);
+    block_FifoEmpty(fifo);
+    assert(block_FifoCount(fifo) == 0);
+    assert(block_FifoShow(fifo) == NULL);
+
+    block_FifoPut(fifo, block_Alloc(100));
+    block_FifoRelease(fifo);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_cache ();
+    test_block_fifo ();
     return 0;
 }
 
@@ -22,7 +22,9 @@
 # include "config.h"
 #endif
 
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -31,6 +33,8 @@
 #include <vlc_picture_pool.h>
 
 #define PICTURES 10
+#define STRESS_THREADS 8
+#define STRESS_ITERATIONS 100000
 
 static video_format_t fmt;
 static picture_pool_t *pool, *reserve;
@@ -106,6 +110,91 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void *stress_thread(void *data)
+{
+    (void) data;
+
+    for (unsigned i = 0; i < STRESS_ITERATIONS; i++) {
+        picture_t *pic = picture_pool_Wait(pool);
+        assert(pic != NULL);
+
+        /* Hold another picture sometimes, whenever one is available */
+        picture_t *other = picture_pool_Get(pool);
+        if (other != NULL)
+            picture_Release(other);
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+static void test_stress(unsigned count)
+{
+    vlc_thread_t threads[STRESS_THREADS];
+    picture_t *pics[PICTURES];
+
+    assert(count <= STRESS_THREADS);
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+
+    mtime_t ts = mdate();
+
+    for (unsigned i = 0; i < count; i++)
+        assert(vlc_clone(&threads[i], stress_thread, NULL,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < count; i++)
+        vlc_join(threads[i], NULL);
+
+    ts = mdate() - ts;
+    printf("%u threads: %u pictures in %"PRId64" us\n", count,
+           count * STRESS_ITERATIONS, ts);
+
+    /* All the pictures must be back in the pool */
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_Release(pool);
+}
+
+static void *cancel_thread(void *data)
+{
+    (void) data;
+    assert(picture_pool_Wait(pool) == NULL);
+    return NULL;
+}
+
+static void test_cancel(void)
+{
+    vlc_thread_t thread;
+    picture_t *pics[PICTURES];
+
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+
+    /* Waiting on an exhausted pool must return when canceled, whether the
+     * thread was already waiting or not */
+    assert(vlc_clone(&thread, cancel_thread, NULL,
+                     VLC_THREAD_PRIORITY_LOW) == 0);
+    picture_pool_Cancel(pool, true);
+    vlc_join(thread, NULL);
+
+    assert(picture_pool_Get(pool) == NULL);
+    picture_pool_Cancel(pool, false);
+
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +211,10 @@ int main(void)
 
     test(false);
     test(true);
+    test_cancel();
+
+    for (unsigned i = 1; i <= STRESS_THREADS; i *= 2)
+        test_stress(i);
 
     return 0;
 }
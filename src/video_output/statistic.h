@@ -24,19 +24,31 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
+# include <vlc_input_item.h>
 
-/* NOTE: Both statistics are atomic on their own, so one might be older than
- * the other one. Currently, only one of them is updated at a time, so this
+/* NOTE: All statistics are atomic on their own, so one might be older than
+ * the other ones. Currently, only one of them is updated at a time, so this
  * is a non-issue. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint copied; /* full-frame copies made by the video output */
+    atomic_uint spu_hits;   /* subpicture regions reused from their cache */
+    atomic_uint spu_misses; /* subpicture regions rendered or scaled again */
+    /* per stage histograms, see input_stats_LatencyBucket() */
+    atomic_uint latency[INPUT_STATS_VOUT_STAGES][INPUT_STATS_LATENCY_BUCKETS];
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->copied, 0);
+    atomic_init(&stat->spu_hits, 0);
+    atomic_init(&stat->spu_misses, 0);
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_STAGES; i++)
+        for (unsigned j = 0; j < INPUT_STATS_LATENCY_BUCKETS; j++)
+            atomic_init(&stat->latency[i][j], 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -46,10 +58,20 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
 
 static inline void vout_statistic_GetReset(vout_statistic_t *stat,
                                            unsigned *restrict displayed,
-                                           unsigned *restrict lost)
+                                           unsigned *restrict lost,
+                                           unsigned *restrict copied,
+                                           unsigned *restrict spu_hits,
+                                           unsigned *restrict spu_misses,
+        unsigned latency[restrict INPUT_STATS_VOUT_STAGES][INPUT_STATS_LATENCY_BUCKETS])
 {
-    *displayed = atomic_exchange(&stat->displayed, 0);
-    *lost      = atomic_exchange(&stat->lost, 0);
+    *displayed  = atomic_exchange(&stat->displayed, 0);
+    *lost       = atomic_exchange(&stat->lost, 0);
+    *copied     = atomic_exchange(&stat->copied, 0);
+    *spu_hits   = atomic_exchange(&stat->spu_hits, 0);
+    *spu_misses = atomic_exchange(&stat->spu_misses, 0);
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_STAGES; i++)
+        for (unsigned j = 0; j < INPUT_STATS_LATENCY_BUCKETS; j++)
+            latency[i][j] = atomic_exchange(&stat->latency[i][j], 0);
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -63,4 +85,25 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+static inline void vout_statistic_AddCopied(vout_statistic_t *stat,
+                                            int copied)
+{
+    atomic_fetch_add(&stat->copied, copied);
+}
+
+static inline void vout_statistic_AddSpuCache(vout_statistic_t *stat,
+                                              int hits, int misses)
+{
+    atomic_fetch_add(&stat->spu_hits, hits);
+    atomic_fetch_add(&stat->spu_misses, misses);
+}
+
+static inline void vout_statistic_AddLatency(vout_statistic_t *stat,
+                                             enum input_stats_vout_stage stage,
+                                             mtime_t duration)
+{
+    atomic_fetch_add_explicit(&stat->latency[stage][input_stats_LatencyBucket(duration)],
+                              1, memory_order_relaxed);
+}
+
 #endif
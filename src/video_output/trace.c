@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * trace.c : vout trace events
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include "trace.h"
+
+/* All the video outputs write to the same file, as separate tracks. The file
+ * is truncated once per process, then reopened in append mode if all the
+ * video outputs were closed in the mean time. The closing bracket of the
+ * event array is optional in the trace format, and never written so that
+ * the file can always be appended to. */
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static struct {
+    FILE     *stream;
+    char     *path; /**< Path of the current or last trace file */
+    unsigned refs;  /**< Number of video outputs using the stream */
+    bool     first; /**< No event written to the file yet */
+} trace_file;
+
+struct vout_trace {
+    unsigned long tid;
+};
+
+static int vout_trace_Open(vlc_object_t *obj, char *path)
+{
+    const bool same = trace_file.path != NULL
+                   && strcmp(trace_file.path, path) == 0;
+
+    if (trace_file.refs > 0) {
+        if (!same)
+            msg_Warn(obj, "already tracing to %s, ignoring %s",
+                     trace_file.path, path);
+        free(path);
+        trace_file.refs++;
+        return 0;
+    }
+
+    FILE *stream = vlc_fopen(path, same ? "at" : "wt");
+    if (stream == NULL) {
+        msg_Err(obj, "cannot create trace file %s: %s", path,
+                vlc_strerror_c(errno));
+        free(path);
+        return -1;
+    }
+    msg_Dbg(obj, "tracing the display to %s", path);
+
+    if (!same) {
+        fputs("[\n", stream);
+        trace_file.first = true;
+        free(trace_file.path);
+        trace_file.path = path;
+    } else
+        free(path);
+    trace_file.stream = stream;
+    trace_file.refs = 1;
+    return 0;
+}
+
+vout_trace_t *vout_trace_New(vlc_object_t *obj)
+{
+    char *path = var_InheritString(obj, "vout-trace");
+    if (path == NULL)
+        return NULL;
+
+    vout_trace_t *trace = malloc(sizeof (*trace));
+    if (unlikely(trace == NULL)) {
+        free(path);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&lock);
+    int ret = vout_trace_Open(obj, path);
+    vlc_mutex_unlock(&lock);
+    if (ret) {
+        free(trace);
+        return NULL;
+    }
+
+    /* Each video output gets its own track */
+    static atomic_ulong count = ATOMIC_VAR_INIT(0);
+    trace->tid = atomic_fetch_add(&count, 1);
+    return trace;
+}
+
+void vout_trace_Delete(vout_trace_t *trace)
+{
+    vlc_mutex_lock(&lock);
+    assert(trace_file.refs > 0);
+    if (--trace_file.refs == 0) {
+        fclose(trace_file.stream);
+        trace_file.stream = NULL;
+    }
+    vlc_mutex_unlock(&lock);
+    free(trace);
+}
+
+void vout_trace_Event(vout_trace_t *trace, const char *name,
+                      mtime_t start, mtime_t end, mtime_t date)
+{
+    vlc_mutex_lock(&lock);
+    fprintf(trace_file.stream,
+            "%s{\"name\":\"%s\",\"cat\":\"vout\",\"ph\":\"X\","
+            "\"ts\":%"PRId64",\"dur\":%"PRId64",\"pid\":0,\"tid\":%lu,"
+            "\"args\":{\"date\":%"PRId64"}}",
+            trace_file.first ? "" : ",\n", name, start, end - start,
+            trace->tid, date);
+    trace_file.first = false;
+    vlc_mutex_unlock(&lock);
+}
@@ -0,0 +1,37 @@
+/*****************************************************************************
+ * trace.h : vout trace events
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_VOUT_TRACE_H
+# define LIBVLC_VOUT_TRACE_H
+
+/* Timing of the display pipeline stages, written as Trace Event Format
+ * (JSON array of complete events) viewable in chrome://tracing. All the
+ * video outputs of the process share the file, one track each. */
+typedef struct vout_trace vout_trace_t;
+
+/* Returns NULL if no trace is requested (--vout-trace) or on error. */
+vout_trace_t *vout_trace_New(vlc_object_t *);
+void vout_trace_Delete(vout_trace_t *);
+
+/* Writes a stage of the processing of the picture with the given date. */
+void vout_trace_Event(vout_trace_t *, const char *name,
+                      mtime_t start, mtime_t end, mtime_t date);
+
+#endif
@@ -54,6 +54,7 @@
 #include "display.h"
 #include "window.h"
 #include "../misc/variables.h"
+#include "../misc/picture.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -139,6 +140,7 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_INIT);
 
     vout_statistic_Init(&vout->p->statistic);
+    vout->p->trace = vout_trace_New(VLC_OBJECT(vout));
 
     vout_snapshot_Init(&vout->p->snapshot);
 
@@ -297,6 +299,8 @@ static void VoutDestructor(vlc_object_t *object)
 
     /* */
     vout_statistic_Clean(&vout->p->statistic);
+    if (vout->p->trace != NULL)
+        vout_trace_Delete(vout->p->trace);
 
     /* */
     vout_snapshot_Clean(&vout->p->snapshot);
@@ -323,9 +327,13 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
 }
 
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost)
+                            unsigned *restrict lost, unsigned *restrict copied,
+                            unsigned *restrict spu_hits,
+                            unsigned *restrict spu_misses,
+                            unsigned latency[][INPUT_STATS_LATENCY_BUCKETS])
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, copied,
+                             spu_hits, spu_misses, latency );
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -427,6 +435,7 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     picture->p_next = NULL;
     if (picture_pool_OwnsPic(vout->p->decoder_pool, picture))
     {
+        ((picture_priv_t *)picture)->queued = mdate();
         picture_fifo_Push(vout->p->decoder_fifo, picture);
 
         vout_control_Wake(&vout->p->control);
@@ -861,6 +870,18 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         } else {
             decoded = picture_fifo_Pop(vout->p->decoder_fifo);
             if (decoded) {
+                /* Time spent in the decoder queue */
+                const mtime_t queued = ((picture_priv_t *)decoded)->queued;
+                if (queued != VLC_TS_INVALID) {
+                    const mtime_t dequeued = mdate();
+
+                    vout_statistic_AddLatency(&vout->p->statistic,
+                                              INPUT_STATS_VOUT_QUEUE,
+                                              dequeued - queued);
+                    if (vout->p->trace != NULL)
+                        vout_trace_Event(vout->p->trace, "queue", queued,
+                                         dequeued, decoded->date);
+                }
                 if (is_late_dropped && !decoded->b_force) {
                     mtime_t late_threshold;
                     if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
@@ -894,7 +915,16 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         vout->p->displayed.timestamp     = decoded->date;
         vout->p->displayed.is_interlaced = !decoded->b_progressive;
 
+        const mtime_t date = decoded->date;
+        const mtime_t filter_start = mdate();
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+        const mtime_t filter_end = mdate();
+
+        vout_statistic_AddLatency(&vout->p->statistic, INPUT_STATS_VOUT_FILTER,
+                                  filter_end - filter_start);
+        if (vout->p->trace != NULL)
+            vout_trace_Event(vout->p->trace, "static filters",
+                             filter_start, filter_end, date);
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
@@ -948,6 +978,8 @@ static picture_t *ConvertRGB32AndBlend(vout_thread_t *vout, picture_t *pic,
     picture_Hold(pic);
     pic = filter_chain_VideoFilter(filterc, pic);
     filter_chain_Delete(filterc);
+    if (pic)
+        vout_statistic_AddCopied(&vout->p->statistic, 1);
 
     if (pic)
     {
@@ -970,13 +1002,22 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     vout_display_t *vd = vout->p->display.vd;
 
     picture_t *torender = picture_Hold(vout->p->displayed.current);
+    const mtime_t date = torender->date;
 
     vout_chrono_Start(&vout->p->render);
+    const mtime_t render_start = mdate();
 
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
     vlc_mutex_unlock(&vout->p->filter.lock);
 
+    const mtime_t filter_end = mdate();
+    vout_statistic_AddLatency(&sys->statistic, INPUT_STATS_VOUT_FILTER,
+                              filter_end - render_start);
+    if (sys->trace != NULL)
+        vout_trace_Event(sys->trace, "interactive filters",
+                         render_start, filter_end, date);
+
     if (!filtered)
         return VLC_EGENERIC;
 
@@ -1075,6 +1116,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
             if (blent) {
                 VideoFormatCopyCropAr(&blent->format, &filtered->format);
                 picture_Copy(blent, filtered);
+                vout_statistic_AddCopied(&vout->p->statistic, 1);
                 if (picture_BlendSubpicture(blent, vout->p->spu_blend, subpic)) {
                     picture_Release(todisplay);
                     snap_pic = todisplay = blent;
@@ -1115,6 +1157,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
          * pictures from the decoder to the output is unavoidable. */
         VideoFormatCopyCropAr(&direct->format, &todisplay->format);
         picture_Copy(direct, todisplay);
+        vout_statistic_AddCopied(&vout->p->statistic, 1);
         picture_Release(todisplay);
         snap_pic = todisplay = direct;
     }
@@ -1155,6 +1198,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     }
 
     vout_chrono_Stop(&vout->p->render);
+
+    const mtime_t prepare_end = mdate();
+    vout_statistic_AddLatency(&sys->statistic, INPUT_STATS_VOUT_PREPARE,
+                              prepare_end - filter_end);
+    if (sys->trace != NULL)
+        vout_trace_Event(sys->trace, "prepare", filter_end, prepare_end, date);
 #if 0
         {
         static int i = 0;
@@ -1174,9 +1223,23 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         mwait(todisplay->date);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    const mtime_t display_date = todisplay->date;
     vout->p->displayed.date = mdate();
     vout_display_Display(vd, todisplay, subpic);
 
+    const mtime_t display_end = mdate();
+    vout_statistic_AddLatency(&sys->statistic, INPUT_STATS_VOUT_DISPLAY,
+                              display_end - vout->p->displayed.date);
+    if (!is_forced)
+        vout_statistic_AddLatency(&sys->statistic, INPUT_STATS_VOUT_LATENESS,
+                                  display_end - display_date);
+    if (sys->trace != NULL) {
+        vout_trace_Event(sys->trace, "wait", prepare_end,
+                         vout->p->displayed.date, date);
+        vout_trace_Event(sys->trace, "display", vout->p->displayed.date,
+                         display_end, date);
+    }
+
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
     return VLC_SUCCESS;
@@ -25,6 +25,8 @@
 #ifndef LIBVLC_VOUT_CONTROL_H
 #define LIBVLC_VOUT_CONTROL_H 1
 
+#include <vlc_input_item.h>
+
 typedef struct vout_window_mouse_event_t vout_window_mouse_event_t;
 
 /**
@@ -42,7 +44,9 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
  * This function will return and reset internal statistics.
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost );
+                             unsigned *pi_lost, unsigned *pi_copied,
+                             unsigned *pi_spu_hits, unsigned *pi_spu_misses,
+                             unsigned pi_latency[][INPUT_STATS_LATENCY_BUCKETS] );
 
 /**
  * This function will ensure that all ready/displayed pictures have at most
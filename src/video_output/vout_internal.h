@@ -33,6 +33,7 @@
 #include "control.h"
 #include "snapshot.h"
 #include "statistic.h"
+#include "trace.h"
 #include "chrono.h"
 
 /* It should be high enough to absorbe jitter due to difficult picture(s)
@@ -61,6 +62,7 @@ struct vout_thread_sys_t
 
     /* Statistics */
     vout_statistic_t statistic;
+    vout_trace_t     *trace;
 
     /* Subpicture unit */
     vlc_mutex_t     spu_lock;
@@ -93,6 +93,11 @@ struct spu_private_t {
     vlc_mutex_t    filter_chain_lock;
     filter_chain_t *filter_chain;
 
+    /* Regions shown as previously rendered and scaled (hits), or rendered
+     * or scaled again (misses), since the last report to the vout */
+    unsigned cache_hits;
+    unsigned cache_misses;
+
     /* */
     mtime_t             last_sort_date;
     vout_thread_t       *vout;
@@ -663,6 +668,7 @@ static void SpuRenderRegion(spu_t *spu,
 
     video_format_t fmt_original = region->fmt;
     bool restore_text = false;
+    bool rendered = false;
     int x_offset;
     int y_offset;
 
@@ -682,6 +688,7 @@ static void SpuRenderRegion(spu_t *spu,
         /* Check if the rendering has failed ... */
         if (region->fmt.i_chroma == VLC_CODEC_TEXT)
             goto exit;
+        rendered = true;
     }
 
     video_format_AdjustColorSpace(&region->fmt);
@@ -829,6 +836,8 @@ static void SpuRenderRegion(spu_t *spu,
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
+            rendered = true;
+
             picture_t *picture = region->p_picture;
             picture_Hold(picture);
 
@@ -949,14 +958,18 @@ static void SpuRenderRegion(spu_t *spu,
         }
     }
 
-    subpicture_region_t *dst = *dst_ptr = subpicture_region_New(&region_fmt);
+    if (rendered)
+        sys->cache_misses++;
+    else
+        sys->cache_hits++;
+
+    /* The output region shows the cached picture, no need to allocate one */
+    subpicture_region_t *dst = *dst_ptr =
+        subpicture_region_ForPicture(&region_fmt, region_picture);
     if (dst) {
         dst->i_x       = x_offset;
         dst->i_y       = y_offset;
         dst->i_align   = 0;
-        if (dst->p_picture)
-            picture_Release(dst->p_picture);
-        dst->p_picture = picture_Hold(region_picture);
         int fade_alpha = 255;
         if (subpic->b_fade) {
             mtime_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
@@ -1327,6 +1340,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     /* */
     sys->last_sort_date = -1;
     sys->vout = vout;
+    sys->cache_hits = sys->cache_misses = 0;
 
     return spu;
 }
@@ -1602,6 +1616,11 @@ subpicture_t *spu_Render(spu_t *spu,
                                                 fmt_src,
                                                 render_subtitle_date,
                                                 render_osd_date);
+
+    if (sys->vout != NULL)
+        vout_statistic_AddSpuCache(&sys->vout->p->statistic,
+                                   sys->cache_hits, sys->cache_misses);
+    sys->cache_hits = sys->cache_misses = 0;
     vlc_mutex_unlock(&sys->lock);
 
     return render;
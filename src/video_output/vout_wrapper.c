@@ -107,6 +107,21 @@ void vout_CloseWrapper(vout_thread_t *vout, vout_display_state_t *state)
  *****************************************************************************/
 /* Minimum number of display picture */
 #define DISPLAY_PICTURE_COUNT (1)
+/* Minimum number of private picture without filters (1 for SPU, 1 spare) */
+#define PRIVATE_PICTURE_MIN (2)
+
+/* Whether the video output starts without any picture filter
+ * (automatic deinterlacing only adds a filter for interlaced pictures) */
+static bool NoFilters(vout_thread_t *vout)
+{
+    char *filters = var_GetNonEmptyString(vout, "video-filter");
+    const int deinterlace = var_GetInteger(vout, "deinterlace");
+
+    free(filters);
+    return filters == NULL &&
+           (deinterlace == 0 ||
+            (deinterlace < 0 && !var_GetBool(vout, "deinterlace-needed")));
+}
 
 static void NoDrInit(vout_thread_t *vout)
 {
@@ -125,7 +140,7 @@ int vout_InitWrapper(vout_thread_t *vout)
 
     sys->display.use_dr = !vout_IsDisplayFiltered(vd);
     const bool allow_dr = !vd->info.has_pictures_invalid && !vd->info.is_slow && sys->display.use_dr;
-    const unsigned private_picture  = 4; /* XXX 3 for filter, 1 for SPU */
+    unsigned private_picture        = 4; /* XXX 3 for filter, 1 for SPU */
     const unsigned decoder_picture  = 1 + sys->dpb_size;
     const unsigned kept_picture     = 1; /* last displayed picture */
     const unsigned reserved_picture = DISPLAY_PICTURE_COUNT +
@@ -143,9 +158,27 @@ int vout_InitWrapper(vout_thread_t *vout)
                  display_pool_size, picture_pool_GetSize(display_pool));
 #endif
 
+    /* Decoding straight into the display pictures avoids copying every
+     * picture to the display. If the display pool is a bit short and there
+     * are no filters to feed, prefer reserving fewer private pictures to
+     * copying. Filters enabled later on, including the deinterlacer once
+     * interlaced pictures show up, then run short of pictures, and drop some,
+     * until the video output is restarted. */
+    const unsigned display_size = picture_pool_GetSize(display_pool);
+    const unsigned shared_picture = DISPLAY_PICTURE_COUNT + kept_picture +
+                                    decoder_picture;
     if (allow_dr &&
-        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture) {
-        sys->dpb_size     = picture_pool_GetSize(display_pool) - reserved_picture;
+        display_size < shared_picture + private_picture &&
+        display_size >= shared_picture + PRIVATE_PICTURE_MIN &&
+        NoFilters(vout)) {
+        private_picture = display_size - shared_picture;
+        msg_Dbg(vout, "reserving only %u private pictures for direct "
+                "rendering", private_picture);
+    }
+
+    if (allow_dr && display_size >= shared_picture + private_picture) {
+        sys->dpb_size     = display_size - DISPLAY_PICTURE_COUNT -
+                            kept_picture - private_picture;
         sys->decoder_pool = display_pool;
         sys->display_pool = display_pool;
     } else if (!sys->decoder_pool) {
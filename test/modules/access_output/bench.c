@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * bench.c: UDP access output transmission benchmark
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Sends TS-sized datagrams through the UDP access output to a loopback
+ * socket, with each batch size, and reports the packets per second per core
+ * of the writer thread: the CPU time of the process minus that of the main
+ * thread, which queues and receives the packets. Not run as a test:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_access_output_bench
+ * $ ./test_modules_access_output_bench [packets]
+ */
+
+#define BENCH_PACKET_SIZE (7 * 188)
+#define BENCH_BACKLOG     4096 /* Maximum packets in flight */
+
+static const unsigned batches[] = { 1, 4, 16, 64 };
+
+static mtime_t CPUTime(clockid_t clock)
+{
+    struct timespec ts;
+
+    if (clock_gettime(clock, &ts))
+        abort();
+    return INT64_C(1000000) * ts.tv_sec + ts.tv_nsec / 1000;
+}
+
+/* Receives the pending datagrams, waiting up to timeout ms for the first */
+static unsigned Receive(int fd, int timeout)
+{
+    static char buf[BENCH_PACKET_SIZE];
+    struct pollfd ufd = { .fd = fd, .events = POLLIN };
+    unsigned count = 0;
+
+    if (poll(&ufd, 1, timeout) <= 0)
+        return 0;
+    while (recv(fd, buf, sizeof (buf), MSG_DONTWAIT) >= 0)
+        count++;
+    return count;
+}
+
+static int Bench(unsigned batch, unsigned packets)
+{
+    libvlc_instance_t *p_libvlc = libvlc_new(0, NULL);
+    assert(p_libvlc != NULL);
+
+    /* Receiving socket, with a large buffer to limit the losses */
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+
+    int bufsize = 8 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof (bufsize));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+    int val = bind(fd, (struct sockaddr *)&addr, sizeof (addr));
+    assert(val == 0);
+    val = getsockname(fd, (struct sockaddr *)&addr, &addrlen);
+    assert(val == 0);
+
+    char access[64], dst[32];
+    snprintf(access, sizeof (access), "udp{caching=0,batch=%u}", batch);
+    snprintf(dst, sizeof (dst), "127.0.0.1:%u", ntohs(addr.sin_port));
+
+    sout_access_out_t *p_access =
+        sout_AccessOutNew(p_libvlc->p_libvlc_int, access, dst);
+    if (p_access == NULL)
+    {
+        fprintf(stderr, "cannot open %s://%s\n", access, dst);
+        close(fd);
+        libvlc_release(p_libvlc);
+        return -1;
+    }
+
+    const mtime_t wall = mdate();
+    const mtime_t cpu = CPUTime(CLOCK_PROCESS_CPUTIME_ID);
+    const mtime_t main_cpu = CPUTime(CLOCK_THREAD_CPUTIME_ID);
+    unsigned received = 0;
+
+    for (unsigned i = 0; i < packets; i++)
+    {
+        block_t *p_block = block_Alloc(BENCH_PACKET_SIZE);
+        assert(p_block != NULL);
+        memset(p_block->p_buffer, 0x47, BENCH_PACKET_SIZE);
+        p_block->i_dts = mdate(); /* due now */
+        sout_AccessOutWrite(p_access, p_block);
+
+        /* Keep the queue short, without waiting for lost packets */
+        received += Receive(fd, 0);
+        while (i - received > BENCH_BACKLOG)
+        {
+            unsigned n = Receive(fd, 100);
+            if (n == 0)
+                break;
+            received += n;
+        }
+    }
+
+    /* Wait for the tail, until nothing comes for 100 ms */
+    for (unsigned n; (n = Receive(fd, 100)) > 0; )
+        received += n;
+
+    const mtime_t writer_cpu = (CPUTime(CLOCK_PROCESS_CPUTIME_ID) - cpu)
+                             - (CPUTime(CLOCK_THREAD_CPUTIME_ID) - main_cpu);
+    const mtime_t elapsed = mdate() - wall;
+
+    sout_AccessOutDelete(p_access);
+    close(fd);
+    libvlc_release(p_libvlc);
+
+    printf("batch %2u: %u/%u packets in %6.3f s, writer %6.3f s CPU, "
+           "%9.0f packets/s per core\n", batch, received, packets,
+           elapsed / 1e6, writer_cpu / 1e6,
+           writer_cpu > 0 ? received * 1e6 / writer_cpu : 0.);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned packets = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+    int ret = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(batches); i++)
+        if (Bench(batches[i], packets))
+            ret = 1;
+    return ret;
+}
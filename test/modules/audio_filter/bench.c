@@ -0,0 +1,314 @@
+/*****************************************************************************
+ * bench.c: audio filters benchmark
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_input.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Feeds synthetic FL32 buffers through each audio filter and reports the
+ * throughput, and the processing time per second of input. The filters with
+ * a playback rate are run as the time stretching filter. The resamplers
+ * also report the signal to noise ratio of a resampled tone. Not run as a
+ * test:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_audio_filter_bench
+ * $ ./test_modules_audio_filter_bench [filter]
+ */
+
+#define BENCH_RATE    48000
+#define BENCH_FRAMES  1024
+#define BENCH_BUFFERS 2000
+
+#define TONE_FREQ    997.
+#define TONE_BUFFERS 200
+
+#define RATE_1_5X (INPUT_RATE_DEFAULT * 2 / 3)
+#define RATE_2X   (INPUT_RATE_DEFAULT / 2)
+
+static const struct
+{
+    const char *psz_name;
+    const char *ppsz_options[2];
+    uint16_t i_in_channels;
+    uint16_t i_out_channels;
+    int i_rate;
+    unsigned i_out_rate; /* resampler output, or 0 */
+} filters[] =
+{
+    { "equalizer", { "--equalizer-bands=-2 0 4 2 0 -2 -4 -2 0 2" },
+      AOUT_CHANS_5_1, AOUT_CHANS_5_1, INPUT_RATE_DEFAULT, 0 },
+    { "param_eq", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_5_1,
+      INPUT_RATE_DEFAULT, 0 },
+    { "compressor", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_5_1,
+      INPUT_RATE_DEFAULT, 0 },
+    { "spatializer", { NULL }, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      INPUT_RATE_DEFAULT, 0 },
+    { "headphone", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_STEREO,
+      INPUT_RATE_DEFAULT, 0 },
+    { "normvol", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_5_1,
+      INPUT_RATE_DEFAULT, 0 },
+    { "scaletempo", { "--scaletempo-search-method=1" },
+      AOUT_CHANS_STEREO, AOUT_CHANS_STEREO, RATE_1_5X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=2" },
+      AOUT_CHANS_STEREO, AOUT_CHANS_STEREO, RATE_1_5X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=1" },
+      AOUT_CHANS_5_1, AOUT_CHANS_5_1, RATE_2X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=2" },
+      AOUT_CHANS_5_1, AOUT_CHANS_5_1, RATE_2X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=1",
+                      "--scaletempo-search-downmix" },
+      AOUT_CHANS_5_1, AOUT_CHANS_5_1, RATE_2X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=1",
+                      "--scaletempo-search=100" },
+      AOUT_CHANS_STEREO, AOUT_CHANS_STEREO, RATE_2X, 0 },
+    { "scaletempo", { "--scaletempo-search-method=2",
+                      "--scaletempo-search=100" },
+      AOUT_CHANS_STEREO, AOUT_CHANS_STEREO, RATE_2X, 0 },
+    { "polyphase_resampler", { NULL }, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      INPUT_RATE_DEFAULT, 44100 },
+    { "bandlimited_resampler", { NULL }, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      INPUT_RATE_DEFAULT, 44100 },
+    { "polyphase_resampler", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_5_1,
+      INPUT_RATE_DEFAULT, 96000 },
+    { "bandlimited_resampler", { NULL }, AOUT_CHANS_5_1, AOUT_CHANS_5_1,
+      INPUT_RATE_DEFAULT, 96000 },
+};
+
+static void FillSamples(float *p_samples, unsigned i_frames,
+                        unsigned i_channels)
+{
+    unsigned i_seed = 1;
+
+    for (unsigned i = 0; i < i_frames; i++)
+        for (unsigned j = 0; j < i_channels; j++)
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+            *p_samples++ = .5f * sinf(i * (j + 1) * 2.f * M_PI * 440.f
+                                      / BENCH_RATE)
+                         + (int)(i_seed >> 16 & 0x7fff) / 327680.f - .05f;
+        }
+}
+
+/* Resamples a tone and returns the ratio in dB of the sinusoid fitting the
+ * first output channel the best, to the residual */
+static double ToneSNR(libvlc_instance_t *p_libvlc,
+                      const audio_sample_format_t *infmt,
+                      const audio_sample_format_t *outfmt)
+{
+    aout_filters_t *p_filters = aout_FiltersNew(p_libvlc->p_libvlc_int,
+                                                infmt, outfmt, NULL, NULL);
+    assert(p_filters != NULL);
+
+    const unsigned i_in_channels = aout_FormatNbChannels(infmt);
+    const unsigned i_out_channels = aout_FormatNbChannels(outfmt);
+    const size_t i_max = (uint64_t)TONE_BUFFERS * BENCH_FRAMES
+                       * outfmt->i_rate / infmt->i_rate + BENCH_FRAMES;
+    float *p_out = malloc(i_max * sizeof (float));
+    size_t i_out = 0;
+    assert(p_out != NULL);
+
+    for (unsigned j = 0; j < TONE_BUFFERS; j++)
+    {
+        block_t *p_block = block_Alloc(BENCH_FRAMES * i_in_channels
+                                       * sizeof (float));
+        assert(p_block != NULL);
+
+        float *p_in = (float *)p_block->p_buffer;
+        for (unsigned k = 0; k < BENCH_FRAMES; k++)
+            for (unsigned c = 0; c < i_in_channels; c++)
+                *p_in++ = .5 * sin(2. * M_PI * TONE_FREQ
+                                   * (j * BENCH_FRAMES + k) / infmt->i_rate);
+        p_block->i_nb_samples = BENCH_FRAMES;
+        p_block->i_pts = p_block->i_dts = VLC_TS_0
+                       + j * CLOCK_FREQ * BENCH_FRAMES / infmt->i_rate;
+
+        p_block = aout_FiltersPlay(p_filters, p_block, INPUT_RATE_DEFAULT);
+        if (p_block == NULL)
+            continue;
+
+        const float *p_samples = (const float *)p_block->p_buffer;
+        for (unsigned k = 0; k < p_block->i_nb_samples && i_out < i_max; k++)
+            p_out[i_out++] = p_samples[k * i_out_channels];
+        block_Release(p_block);
+    }
+    aout_FiltersDelete((vlc_object_t *)NULL, p_filters);
+
+    /* Least squares fit of a sin + b cos, without the edges */
+    double ss = 0., sc = 0., cc = 0., ys = 0., yc = 0.;
+    const size_t i_start = BENCH_FRAMES, i_end = i_out - BENCH_FRAMES;
+    assert(i_out > 2 * BENCH_FRAMES);
+
+    for (size_t k = i_start; k < i_end; k++)
+    {
+        double w = 2. * M_PI * TONE_FREQ * k / outfmt->i_rate;
+
+        ss += sin(w) * sin(w);
+        sc += sin(w) * cos(w);
+        cc += cos(w) * cos(w);
+        ys += p_out[k] * sin(w);
+        yc += p_out[k] * cos(w);
+    }
+
+    const double det = ss * cc - sc * sc;
+    const double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+    double signal = 0., noise = 0.;
+
+    for (size_t k = i_start; k < i_end; k++)
+    {
+        double w = 2. * M_PI * TONE_FREQ * k / outfmt->i_rate;
+        double fit = a * sin(w) + b * cos(w);
+
+        signal += fit * fit;
+        noise += (p_out[k] - fit) * (p_out[k] - fit);
+    }
+    free(p_out);
+    return 10. * log10(signal / noise);
+}
+
+static int Bench(size_t i)
+{
+    const char *argv[3 + ARRAY_SIZE(filters[i].ppsz_options)];
+    int argc = 0;
+
+    if (filters[i].i_out_rate != 0)
+    {
+        argv[argc++] = "--audio-resampler";
+        argv[argc++] = filters[i].psz_name;
+        argv[argc++] = "--no-audio-time-stretch";
+    }
+    else if (filters[i].i_rate == INPUT_RATE_DEFAULT)
+    {
+        argv[argc++] = "--audio-filter";
+        argv[argc++] = filters[i].psz_name;
+        argv[argc++] = "--no-audio-time-stretch";
+    }
+    else
+        argv[argc++] = "--audio-time-stretch";
+    for (size_t j = 0; j < ARRAY_SIZE(filters[i].ppsz_options)
+                    && filters[i].ppsz_options[j] != NULL; j++)
+        argv[argc++] = filters[i].ppsz_options[j];
+
+    libvlc_instance_t *p_libvlc = libvlc_new(argc, argv);
+    assert(p_libvlc != NULL);
+
+    audio_sample_format_t infmt = {
+        .i_format = VLC_CODEC_FL32,
+        .i_rate = BENCH_RATE,
+        .i_physical_channels = filters[i].i_in_channels,
+        .channel_type = AUDIO_CHANNEL_TYPE_BITMAP,
+    };
+    audio_sample_format_t outfmt = infmt;
+
+    outfmt.i_physical_channels = filters[i].i_out_channels;
+    if (filters[i].i_out_rate != 0)
+        outfmt.i_rate = filters[i].i_out_rate;
+    aout_FormatPrepare(&infmt);
+    aout_FormatPrepare(&outfmt);
+
+    aout_filters_t *p_filters = aout_FiltersNew(p_libvlc->p_libvlc_int,
+                                                &infmt, &outfmt, NULL, NULL);
+    if (p_filters == NULL)
+    {
+        fprintf(stderr, "%-21s cannot be loaded\n", filters[i].psz_name);
+        libvlc_release(p_libvlc);
+        return -1;
+    }
+
+    const unsigned i_channels = aout_FormatNbChannels(&infmt);
+    const size_t i_size = BENCH_FRAMES * i_channels * sizeof (float);
+    float *p_samples = malloc(i_size);
+    assert(p_samples != NULL);
+    FillSamples(p_samples, BENCH_FRAMES, i_channels);
+
+    mtime_t i_elapsed = 0;
+
+    for (unsigned j = 0; j < BENCH_BUFFERS; j++)
+    {
+        block_t *p_block = block_Alloc(i_size);
+        assert(p_block != NULL);
+        memcpy(p_block->p_buffer, p_samples, i_size);
+        p_block->i_nb_samples = BENCH_FRAMES;
+        p_block->i_pts = p_block->i_dts = VLC_TS_0
+                       + j * CLOCK_FREQ * BENCH_FRAMES / BENCH_RATE;
+        p_block->i_length = CLOCK_FREQ * BENCH_FRAMES / BENCH_RATE;
+
+        mtime_t i_start = mdate();
+        p_block = aout_FiltersPlay(p_filters, p_block, filters[i].i_rate);
+        i_elapsed += mdate() - i_start;
+
+        if (p_block != NULL)
+            block_Release(p_block);
+        if (j == 0) /* count the allocations once the pipeline is warm */
+            aout_FiltersGetResetAllocations(p_filters);
+    }
+    unsigned i_allocations = aout_FiltersGetResetAllocations(p_filters);
+
+    if (i_elapsed <= 0)
+        i_elapsed = 1;
+    printf("%-21s %2u -> %u channels, x%.1f: %8.1f Msamples/s, "
+           "%6.2f ms/s of audio, %4.2f allocs/buffer",
+           filters[i].psz_name, i_channels, aout_FormatNbChannels(&outfmt),
+           (double)INPUT_RATE_DEFAULT / filters[i].i_rate,
+           (double)BENCH_BUFFERS * BENCH_FRAMES * i_channels / i_elapsed,
+           i_elapsed / 1000. * BENCH_RATE / (BENCH_BUFFERS * BENCH_FRAMES),
+           (double)i_allocations / (BENCH_BUFFERS - 1));
+    for (size_t j = 0; j < ARRAY_SIZE(filters[i].ppsz_options)
+                    && filters[i].ppsz_options[j] != NULL; j++)
+        printf(" %s", filters[i].ppsz_options[j]);
+    if (filters[i].i_out_rate != 0)
+        printf(" %u -> %u Hz, SNR %5.1f dB", infmt.i_rate, outfmt.i_rate,
+               ToneSNR(p_libvlc, &infmt, &outfmt));
+    putchar('\n');
+
+    free(p_samples);
+    aout_FiltersDelete((vlc_object_t *)NULL, p_filters);
+    libvlc_release(p_libvlc);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    for (size_t i = 0; i < ARRAY_SIZE(filters); i++)
+        if (argc < 2 || !strcmp(argv[1], filters[i].psz_name))
+            if (Bench(i))
+                ret = 1;
+    return ret;
+}
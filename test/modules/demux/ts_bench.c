@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * ts_bench.c: MPEG-TS demuxer benchmark
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Demuxes a synthetic transport stream, made of a program with a given
+ * number of elementary streams, from memory and reports the throughput in
+ * packets per second. Not run as a test:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_demux_ts_bench
+ * $ ./test_modules_demux_ts_bench [packets]
+ */
+
+#define BENCH_PMT_PID 0x100
+#define BENCH_ES_PID(i) (0x200 + 13 * (i)) /* spread over the PID range */
+
+static const unsigned streams[] = { 1, 8, 64, 256 };
+
+/* Dummy ES output, discarding everything */
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) fmt;
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    (void) out; (void) id;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDelete(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_PCR_SYSTEM:
+        case ES_OUT_MODIFY_PCR_SYSTEM:
+            return VLC_EGENERIC;
+        default:
+            return VLC_SUCCESS;
+    }
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+static uint32_t CRC32(const uint8_t *p, size_t i_size)
+{
+    uint32_t i_crc = 0xffffffff;
+
+    while (i_size--)
+    {
+        i_crc ^= (uint32_t)*p++ << 24;
+        for (int i = 0; i < 8; i++)
+            i_crc = (i_crc << 1) ^ ((i_crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return i_crc;
+}
+
+static uint8_t *PutHeader(uint8_t *p, uint16_t i_pid, bool b_start,
+                          uint8_t *p_cc)
+{
+    p[0] = 0x47;
+    p[1] = (b_start ? 0x40 : 0x00) | (i_pid >> 8);
+    p[2] = i_pid & 0xff;
+    p[3] = 0x10 | (*p_cc & 0xf); /* payload only */
+    (*p_cc)++;
+    return p + 4;
+}
+
+/* Writes a PSI section in a single packet */
+static void PutSection(uint8_t *p, uint16_t i_pid, uint8_t *p_cc,
+                       const uint8_t *p_section, size_t i_section)
+{
+    memset(p, 0xff, 188);
+    p = PutHeader(p, i_pid, true, p_cc);
+    *p++ = 0; /* pointer field */
+
+    uint32_t i_crc = CRC32(p_section, i_section);
+    memcpy(p, p_section, i_section);
+    SetDWBE(p + i_section, i_crc);
+}
+
+static void PutPAT(uint8_t *p, uint8_t *p_cc)
+{
+    const uint8_t section[] = {
+        0x00, 0xb0, 13, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01, 0xe0 | (BENCH_PMT_PID >> 8), BENCH_PMT_PID & 0xff,
+    };
+
+    PutSection(p, 0, p_cc, section, sizeof (section));
+}
+
+static void PutPMT(uint8_t *p, uint8_t *p_cc, unsigned i_streams)
+{
+    uint8_t section[183];
+    size_t i = 0;
+
+    /* Describes as many streams as fit in one packet, the others are
+     * demuxed as unknown PIDs */
+    unsigned i_described = __MIN(i_streams, (183 - 12 - 4) / 5);
+    size_t i_length = 9 + 5 * i_described + 4;
+
+    section[i++] = 0x02;
+    section[i++] = 0xb0 | (i_length >> 8);
+    section[i++] = i_length & 0xff;
+    section[i++] = 0x00;
+    section[i++] = 0x01;
+    section[i++] = 0xc1;
+    section[i++] = 0x00;
+    section[i++] = 0x00;
+    section[i++] = 0xe0 | (BENCH_ES_PID(0) >> 8); /* PCR PID */
+    section[i++] = BENCH_ES_PID(0) & 0xff;
+    section[i++] = 0xf0;
+    section[i++] = 0x00;
+    for (unsigned j = 0; j < i_described; j++)
+    {
+        section[i++] = 0x06; /* private data */
+        section[i++] = 0xe0 | (BENCH_ES_PID(j) >> 8);
+        section[i++] = BENCH_ES_PID(j) & 0xff;
+        section[i++] = 0xf0;
+        section[i++] = 0x00;
+    }
+    PutSection(p, BENCH_PMT_PID, p_cc, section, i);
+}
+
+static void PutPES(uint8_t *p, uint16_t i_pid, uint8_t *p_cc, bool b_start)
+{
+    p = PutHeader(p, i_pid, b_start, p_cc);
+    memset(p, 0xaa, 184);
+    if (b_start)
+    {
+        static const uint8_t hdr[] = {
+            0x00, 0x00, 0x01, 0xbd, 0x00, 0x00, 0x80, 0x00, 0x00,
+        };
+        memcpy(p, hdr, sizeof (hdr));
+    }
+}
+
+static uint8_t *Generate(unsigned i_streams, unsigned i_packets)
+{
+    uint8_t *p_buf = malloc(188 * i_packets);
+    uint8_t cc[0x2000] = { 0 };
+    assert(p_buf != NULL);
+
+    for (unsigned i = 0; i < i_packets; i++)
+    {
+        uint8_t *p = p_buf + 188 * i;
+
+        if (i % 1000 == 0)
+            PutPAT(p, &cc[0]);
+        else if (i % 1000 == 1)
+            PutPMT(p, &cc[BENCH_PMT_PID], i_streams);
+        else
+        {
+            uint16_t i_pid = BENCH_ES_PID(i % i_streams);
+            PutPES(p, i_pid, &cc[i_pid], (i / i_streams) % 16 == 0);
+        }
+    }
+    return p_buf;
+}
+
+static void Bench(libvlc_instance_t *p_libvlc, unsigned i_streams,
+                  unsigned i_packets)
+{
+    uint8_t *p_buf = Generate(i_streams, i_packets);
+    stream_t *s = vlc_stream_MemoryNew(p_libvlc->p_libvlc_int, p_buf,
+                                       188 * i_packets, false);
+    assert(s != NULL);
+
+    es_out_t out = {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDelete,
+        .pf_control = EsOutControl,
+        .pf_destroy = EsOutDestroy,
+    };
+
+    demux_t *p_demux = demux_New(VLC_OBJECT(p_libvlc->p_libvlc_int), "ts",
+                                 s, &out);
+    assert(p_demux != NULL);
+
+    const mtime_t i_start = mdate();
+    while (demux_Demux(p_demux) == VLC_DEMUXER_SUCCESS);
+    const mtime_t i_time = mdate() - i_start;
+
+    demux_Delete(p_demux); /* deletes the stream, and frees the buffer */
+
+    printf("%3u streams: %u packets in %6.3f s, %10"PRId64" packets/s\n",
+           i_streams, i_packets, i_time / 1e6,
+           i_time > 0 ? (int64_t)i_packets * CLOCK_FREQ / i_time : 0);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned i_packets = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+
+    libvlc_instance_t *p_libvlc = libvlc_new(0, NULL);
+    assert(p_libvlc != NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        Bench(p_libvlc, streams[i], i_packets);
+
+    libvlc_release(p_libvlc);
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * yadif_bench.c: Yadif line filters benchmark
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../../../modules/video_filter/deinterlace/common.h"
+#include "../../../modules/video_filter/deinterlace/yadif.h"
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Interpolates random lines with each Yadif line filter available on the
+ * CPU, checks that the output matches the C version, and reports the time
+ * per line. Not run as a test:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_video_filter_yadif_bench
+ * $ ./test_modules_video_filter_yadif_bench [lines]
+ */
+
+#define BENCH_WIDTH 1920 /* pixels */
+
+typedef void (*yadif_filter_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                               uint8_t *next, int w, int prefs, int mrefs,
+                               int parity, int mode);
+
+struct bench_filter
+{
+    const char *name;
+    yadif_filter_t filter;
+    unsigned bits; /**< Maximum sample depth */
+    bool available;
+};
+
+/* Picture lines: the line being interpolated, and two lines above and below
+ * for the spatial checks, in the three fields */
+struct bench_lines
+{
+    uint8_t *prev, *cur, *next;
+    uint8_t *dst;
+    int pitch;
+};
+
+static void Generate(struct bench_lines *l, unsigned bits)
+{
+    const unsigned bytes = bits > 8 ? 2 : 1;
+
+    l->pitch = BENCH_WIDTH * bytes + 64;
+    l->prev = malloc(5 * l->pitch);
+    l->cur = malloc(5 * l->pitch);
+    l->next = malloc(5 * l->pitch);
+    l->dst = malloc(l->pitch);
+    assert(l->prev != NULL && l->cur != NULL && l->next != NULL
+        && l->dst != NULL);
+
+    uint8_t *planes[] = { l->prev, l->cur, l->next };
+
+    for (size_t i = 0; i < ARRAY_SIZE(planes); i++)
+        for (int j = 0; j < 5 * l->pitch; j += bytes)
+        {
+            unsigned v = rand() & ((1u << bits) - 1);
+
+            if (bytes == 2)
+                memcpy(planes[i] + j, &(uint16_t){ v }, 2);
+            else
+                planes[i][j] = v;
+        }
+}
+
+static void Destroy(struct bench_lines *l)
+{
+    free(l->dst);
+    free(l->next);
+    free(l->cur);
+    free(l->prev);
+}
+
+static void Filter(const struct bench_lines *l, yadif_filter_t filter,
+                   int parity)
+{
+    const int o = 2 * l->pitch; /* middle line */
+
+    filter(l->dst, l->prev + o, l->cur + o, l->next + o, BENCH_WIDTH,
+           l->pitch, -l->pitch, parity, 0);
+}
+
+static int Bench(const struct bench_filter *filters, size_t count,
+                 unsigned bits, unsigned lines)
+{
+    struct bench_lines l;
+    int ret = 0;
+
+    Generate(&l, bits);
+
+    uint8_t *ref = malloc(l.pitch);
+    assert(ref != NULL);
+    memset(l.dst, 0, l.pitch);
+    Filter(&l, filters[0].filter, 0);
+    memcpy(ref, l.dst, l.pitch);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const struct bench_filter *f = &filters[i];
+
+        if (!f->available || bits > f->bits)
+            continue;
+
+        memset(l.dst, 0, l.pitch);
+        Filter(&l, f->filter, 0);
+        bool exact = !memcmp(l.dst, ref, BENCH_WIDTH * (bits > 8 ? 2 : 1));
+        if (!exact)
+            ret = 1;
+
+        const mtime_t start = mdate();
+        for (unsigned j = 0; j < lines; j++)
+            Filter(&l, f->filter, j & 1);
+        const mtime_t time = mdate() - start;
+
+        printf("%2u bits %-6s: %6.3f s, %8.1f ns per line%s\n", bits, f->name,
+               time / 1e6, time * 1e3 / lines,
+               exact ? "" : ", MISMATCH");
+    }
+
+    free(ref);
+    Destroy(&l);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned lines = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+    int ret = 0;
+
+    const struct bench_filter filters8[] = {
+        { "C", yadif_filter_line_c, 8, true },
+#if defined(HAVE_YADIF_MMX)
+        { "MMX", yadif_filter_line_mmx, 8, vlc_CPU_MMX() },
+#endif
+#if defined(HAVE_YADIF_SSE2)
+        { "SSE2", yadif_filter_line_sse2, 8, vlc_CPU_SSE2() },
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+        { "SSSE3", yadif_filter_line_ssse3, 8, vlc_CPU_SSSE3() },
+#endif
+#if defined(HAVE_YADIF_AVX2)
+        { "AVX2", yadif_filter_line_avx2, 8, vlc_CPU_AVX2() },
+#endif
+    };
+    const struct bench_filter filters16[] = {
+        { "C", yadif_filter_line_c_16bit, 16, true },
+#if defined(HAVE_YADIF_AVX2)
+        /* The AVX2 version computes in 16-bits signed integers */
+        { "AVX2", yadif_filter_line_avx2_16bit, 12, vlc_CPU_AVX2() },
+#endif
+    };
+
+    srand(0);
+    ret |= Bench(filters8, ARRAY_SIZE(filters8), 8, lines);
+    ret |= Bench(filters16, ARRAY_SIZE(filters16), 10, lines);
+    ret |= Bench(filters16, ARRAY_SIZE(filters16), 12, lines);
+    return ret;
+}
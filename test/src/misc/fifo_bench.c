@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * fifo_bench.c: block FIFO benchmark
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Queues TS packet blocks from one or more producer threads to a single
+ * consumer thread, as the sout access outputs do, with the locked and the
+ * lock-less FIFO modes, and reports the blocks per second. Not run as a test:
+ * $ cd vlc/build-<name>/test
+ * $ make test_src_misc_fifo_bench
+ * $ ./test_src_misc_fifo_bench [blocks]
+ */
+
+#define BENCH_PRODUCERS_MAX 4
+
+static const unsigned producers[] = { 1, 2, 4 };
+
+struct bench_producer
+{
+    block_fifo_t *fifo;
+    block_t **blocks;
+    unsigned count;
+    vlc_thread_t thread;
+};
+
+static void *Producer(void *data)
+{
+    struct bench_producer *p = data;
+
+    for (unsigned i = 0; i < p->count; i++)
+        block_FifoPut(p->fifo, p->blocks[i]);
+    return NULL;
+}
+
+static void Bench(bool lockless, unsigned threads, unsigned count)
+{
+    block_fifo_t *fifo = lockless ? block_FifoNewLockless() : block_FifoNew();
+    struct bench_producer p[BENCH_PRODUCERS_MAX];
+    const unsigned total = threads * count;
+
+    assert(fifo != NULL);
+    assert(threads <= BENCH_PRODUCERS_MAX);
+
+    /* Blocks are allocated up front, so that only the queue is measured */
+    block_t **blocks = malloc(total * sizeof (*blocks));
+    assert(blocks != NULL);
+    for (unsigned i = 0; i < total; i++)
+    {
+        blocks[i] = block_Alloc(188);
+        assert(blocks[i] != NULL);
+    }
+
+    const mtime_t start = mdate();
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        p[i].fifo = fifo;
+        p[i].blocks = blocks + i * count;
+        p[i].count = count;
+        if (vlc_clone(&p[i].thread, Producer, &p[i],
+                      VLC_THREAD_PRIORITY_LOW))
+            abort();
+    }
+
+    for (unsigned i = 0; i < total; i++)
+    {
+        block_t *block = block_FifoGet(fifo);
+        assert(block != NULL);
+    }
+
+    const mtime_t time = mdate() - start;
+
+    for (unsigned i = 0; i < threads; i++)
+        vlc_join(p[i].thread, NULL);
+
+    for (unsigned i = 0; i < total; i++)
+        block_Release(blocks[i]);
+    free(blocks);
+    block_FifoRelease(fifo);
+
+    printf("%-9s %u producer(s): %6.3f s, %6.2f Mblocks/s\n",
+           lockless ? "lock-less" : "locked", threads, time / 1e6,
+           time > 0 ? total / (double)time : 0.);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 250000;
+
+    for (size_t i = 0; i < ARRAY_SIZE(producers); i++)
+    {
+        Bench(false, producers[i], count);
+        Bench(true, producers[i], count);
+    }
+    return 0;
+}